@@ -0,0 +1,279 @@
+/**
+ * @file codec.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief codec benchmark
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * times varints of every length, strings, positions and slots,
+ * then decodes and encodes the sample of every generated packet,
+ * prints nanoseconds per operation as JSON, decode times include
+ * freeing the packet and roundtrip is false if the encoded packet
+ * differs from its sample
+ *
+ * usage: bench-codec [rounds]
+ */
+    /* includes */
+#include "mcp/codec.h"    /* encoders/decoders */
+#include "mcp/protocol.h" /* packet descriptors */
+#include <stdio.h>        /* printf */
+#include <stdlib.h>       /* malloc, strtoul */
+#include <string.h>       /* memcmp */
+#include <time.h>         /* clock_gettime */
+
+    /* defines */
+/**
+ * @brief number of values of a varint round
+ */
+#define BENCH_VARINTS 4096
+
+    /* variables */
+static const char* bench_states[MCP_STATE__MAX] = { "handshaking", "status", "login", "play" };
+static const char* bench_sources[MCP_SOURCE__MAX] = { "client", "server" };
+
+    /* functions */
+/**
+ * @brief get monotonic time in nanoseconds
+ */
+static double bench_now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+/**
+ * @brief time varints of one encoded length
+ *
+ * @param bytes  encoded length
+ * @param rounds number of rounds
+ */
+static void bench_varint(size_t bytes, size_t rounds) {
+    uint64_t low = bytes == 1 ? 0 : 1ull << (7 * (bytes - 1));
+    uint64_t range = (1ull << (7 * bytes)) - low;
+    if (bytes == 5) {
+        range = (1ull << 32) - low;
+    }
+    uint32_t values[BENCH_VARINTS];
+    for (size_t i = 0; i < BENCH_VARINTS; i++) {
+        values[i] = low + (uint64_t) rand() * rand() % range;
+    }
+    mcp_buffer_t buffer = { 0 };
+    mcp_buffer_allocate(&buffer, BENCH_VARINTS * 5);
+
+    rounds = rounds / BENCH_VARINTS + 1;
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        for (size_t i = 0; i < BENCH_VARINTS; i++) {
+            mcp_encode_varint(values[i], &buffer);
+        }
+    }
+    double encode = bench_now() - start;
+
+    uint64_t sum = 0;
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        for (size_t i = 0; i < BENCH_VARINTS; i++) {
+            sum += mcp_decode_varint(&buffer);
+        }
+    }
+    double decode = bench_now() - start;
+
+    double count = (double) rounds * BENCH_VARINTS;
+    printf("{\"benchmark\": \"codec\", \"case\": \"varint_%zu\", \"bytes\": %zu, \"encode_ns\": %.2f, \"decode_ns\": %.2f, \"checksum\": %llu}\n",
+           bytes, bytes, encode / count, decode / count, (unsigned long long) sum);
+    mcp_buffer_free(&buffer);
+}
+
+/**
+ * @brief time strings of one length
+ *
+ * @param length string length
+ * @param rounds number of rounds
+ */
+static void bench_string(size_t length, size_t rounds) {
+    char* value = malloc(length + 1);
+    for (size_t i = 0; i < length; i++) {
+        value[i] = 'a' + i % 26;
+    }
+    value[length] = 0;
+    mcp_buffer_t buffer = { 0 };
+    mcp_buffer_allocate(&buffer, length + 5);
+
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        mcp_encode_string(value, &buffer);
+    }
+    double encode = bench_now() - start;
+
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        char* decoded;
+        mcp_decode_string(&decoded, &buffer);
+        mcp_free_string(&decoded);
+    }
+    double decode = bench_now() - start;
+
+    printf("{\"benchmark\": \"codec\", \"case\": \"string_%zu\", \"bytes\": %zu, \"encode_ns\": %.2f, \"decode_ns\": %.2f}\n",
+           length, buffer.index, encode / rounds, decode / rounds);
+    mcp_buffer_free(&buffer);
+    free(value);
+}
+
+/**
+ * @brief time positions
+ *
+ * @param rounds number of rounds
+ */
+static void bench_position(size_t rounds) {
+    mcp_type_Position positions[64];
+    for (size_t i = 0; i < 64; i++) {
+        positions[i] = (mcp_type_Position) { rand() % 60000000 - 30000000, rand() % 256, rand() % 60000000 - 30000000 };
+    }
+    mcp_buffer_t buffer = { 0 };
+    mcp_buffer_allocate(&buffer, sizeof(positions));
+
+    rounds = rounds / 64 + 1;
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        for (size_t i = 0; i < 64; i++) {
+            mcp_encode_type_Position(&positions[i], &buffer);
+        }
+    }
+    double encode = bench_now() - start;
+
+    int32_t sum = 0;
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        for (size_t i = 0; i < 64; i++) {
+            mcp_decode_type_Position(&positions[i], &buffer);
+            sum += positions[i].y;
+        }
+    }
+    double decode = bench_now() - start;
+
+    double count = (double) rounds * 64;
+    printf("{\"benchmark\": \"codec\", \"case\": \"position\", \"bytes\": 8, \"encode_ns\": %.2f, \"decode_ns\": %.2f, \"checksum\": %d}\n",
+           encode / count, decode / count, sum);
+    mcp_buffer_free(&buffer);
+}
+
+/**
+ * @brief time a slot
+ *
+ * @param name   case name
+ * @param data   encoded slot
+ * @param size   encoded size
+ * @param rounds number of rounds
+ */
+static void bench_slot(const char* name, const char* data, size_t size, size_t rounds) {
+    mcp_buffer_t buffer = { 0 };
+    mcp_buffer_allocate(&buffer, size);
+    memcpy(buffer.data, data, size);
+    mcp_type_Slot slot;
+    mcp_decode_type_Slot(&slot, &buffer);
+
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        mcp_encode_type_Slot(&slot, &buffer);
+    }
+    double encode = bench_now() - start;
+    mcp_free_type_Slot(&slot);
+
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        mcp_decode_type_Slot(&slot, &buffer);
+        mcp_free_type_Slot(&slot);
+    }
+    double decode = bench_now() - start;
+
+    printf("{\"benchmark\": \"codec\", \"case\": \"%s\", \"bytes\": %zu, \"encode_ns\": %.2f, \"decode_ns\": %.2f}\n",
+           name, size, encode / rounds, decode / rounds);
+    mcp_buffer_free(&buffer);
+}
+
+/**
+ * @brief time the sample of a generated packet
+ *
+ * @param state  packet state
+ * @param source packet source
+ * @param info   packet descriptor
+ * @param rounds number of rounds
+ */
+static void bench_packet(mcp_state_t state, mcp_source_t source, const mcp_packet_info_t* info, size_t rounds) {
+    if (info->sample == NULL) {
+        printf("{\"benchmark\": \"packet\", \"state\": \"%s\", \"source\": \"%s\", \"packet\": \"%s\", \"skipped\": true}\n",
+               bench_states[state], bench_sources[source], info->name);
+        return;
+    }
+    void* packet = calloc(1, info->size);
+    mcp_buffer_t src = { 0 };
+    mcp_buffer_set(&src, (char*) info->sample, info->sample_size);
+
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        src.index = 0;
+        info->decode(packet, &src);
+        info->free(packet);
+    }
+    double decode = bench_now() - start;
+
+    mcp_region_t region;
+    mcp_region_init(&region, 0);
+    mcp_buffer_t dest = { 0 };
+    dest.region = &region;
+    src.index = 0;
+    info->decode(packet, &src);
+
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        info->encode(packet, &dest);
+    }
+    double encode = bench_now() - start;
+
+    /* skip the packet id */
+    mcp_buffer_t encoded = { 0 };
+    mcp_buffer_set(&encoded, mcp_buffer_packet(&dest), mcp_buffer_packet_length(&dest));
+    mcp_decode_varint(&encoded);
+    bool roundtrip = encoded.size - encoded.index == info->sample_size
+                  && memcmp(mcp_buffer_current(&encoded), info->sample, info->sample_size) == 0;
+
+    printf("{\"benchmark\": \"packet\", \"state\": \"%s\", \"source\": \"%s\", \"packet\": \"%s\", \"bytes\": %zu, "
+           "\"encode_ns\": %.2f, \"decode_ns\": %.2f, \"roundtrip\": %s}\n",
+           bench_states[state], bench_sources[source], info->name, info->sample_size,
+           encode / rounds, decode / rounds, roundtrip ? "true" : "false");
+    info->free(packet);
+    mcp_region_free(&region);
+    free(packet);
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    srand(1);
+    for (size_t bytes = 1; bytes <= 5; bytes++) {
+        bench_varint(bytes, rounds * 16);
+    }
+    bench_string(16, rounds);
+    bench_string(256, rounds);
+    bench_position(rounds * 16);
+    bench_slot("slot_empty", "\x00", 1, rounds);
+    bench_slot("slot", "\x01\x81\x02\x01\x00", 5, rounds);
+    bench_slot("slot_nbt", "\x01\x81\x02\x01\x0a\x00\x00\x03\x00\x06\x44\x61\x6d\x61\x67\x65\x00\x00\x00\x07"
+               "\x08\x00\x04\x6e\x61\x6d\x65\x00\x05\x53\x77\x6f\x72\x64\x00", 35, rounds);
+
+    for (mcp_state_t state = 0; state < MCP_STATE__MAX; state++) {
+        for (mcp_source_t source = 0; source < MCP_SOURCE__MAX; source++) {
+            for (mcp_packet_id_t id = 0; id < mcp_protocol_max_ids[state][source]; id++) {
+                bench_packet(state, source, &mcp_protocol_packets[state][source][id], rounds);
+            }
+        }
+    }
+    return 0;
+}
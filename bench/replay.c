@@ -0,0 +1,183 @@
+/**
+ * @file replay.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief capture replay benchmark
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * replays a capture through the receive path, decoding and freeing
+ * every packet which has a decoder, without and then with metrics,
+ * prints packets and megabytes per second and the metrics of every
+ * packet as JSON, without a capture the sample of every generated
+ * packet is recorded into a temporary one
+ *
+ * usage: bench-replay [capture] [rounds]
+ */
+    /* includes */
+#include "mcp/capture.h"  /* capture replay */
+#include "mcp/handler.h"  /* handler tables */
+#include "mcp/codec.h"    /* varint functions */
+#include "mcp/protocol.h" /* packet descriptors */
+#include "mcp/metrics.h"  /* packet metrics */
+#include <stdio.h>        /* printf */
+#include <stdlib.h>       /* malloc, strtoul */
+#include <string.h>       /* memcpy */
+#include <time.h>         /* clock_gettime */
+#include <unistd.h>       /* unlink */
+
+    /* defines */
+/**
+ * @brief number of records of every packet in a generated capture
+ */
+#define BENCH_COPIES 64
+
+    /* variables */
+static void* packet;
+static size_t decoded;
+
+    /* functions */
+/**
+ * @brief get monotonic time in seconds
+ */
+static double bench_now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief decode and free a received packet
+ *
+ * @param context connection context
+ */
+static void bench_decode(mcp_context_t* context) {
+    uint64_t id;
+    mcp_peek_varint(context->buffer.data, context->buffer.size, &id);
+    const mcp_packet_info_t* info = &mcp_protocol_packets[context->state][context->source][id];
+    if (info->sample != NULL) {
+        info->decode(packet, &context->buffer);
+        info->free(packet);
+        decoded++;
+    }
+}
+
+/**
+ * @brief record the sample of every generated packet
+ *
+ * @param path capture path
+ */
+static void bench_record(const char* path) {
+    mcp_capture_t capture;
+    if (!mcp_capture_open(&capture, path, false)) {
+        perror("mcp_capture_open");
+        exit(1);
+    }
+    mcp_buffer_t buffer = { 0 };
+    for (size_t copy = 0; copy < BENCH_COPIES; copy++) {
+        for (mcp_state_t state = 0; state < MCP_STATE__MAX; state++) {
+            for (mcp_source_t source = 0; source < MCP_SOURCE__MAX; source++) {
+                for (mcp_packet_id_t id = 0; id < mcp_protocol_max_ids[state][source]; id++) {
+                    const mcp_packet_info_t* info = &mcp_protocol_packets[state][source][id];
+                    if (info->sample == NULL) {
+                        continue;
+                    }
+                    mcp_buffer_allocate(&buffer, MCP_BUFFER_HEADROOM + info->sample_size);
+                    mcp_encode_varint(id, &buffer);
+                    memcpy(mcp_buffer_current(&buffer), info->sample, info->sample_size);
+                    mcp_capture_write(&capture, MCP_PROTOCOL_VERSION, state, source, 0, buffer.data, buffer.index + info->sample_size);
+                    mcp_buffer_free(&buffer);
+                }
+            }
+        }
+    }
+    if (!mcp_capture_close(&capture)) {
+        perror("mcp_capture_close");
+        exit(1);
+    }
+}
+
+/**
+ * @brief replay a capture and print the results
+ *
+ * @param replay  pointer to the replay driver
+ * @param context connection context
+ * @param rounds  number of rounds
+ * @param name    benchmark name
+ */
+static void bench_replay(mcp_replay_t* replay, mcp_context_t* context, size_t rounds, const char* name) {
+    long records = 0;
+    decoded = 0;
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        mcp_replay_rewind(replay);
+        long count = mcp_replay_run(replay, context);
+        if (count < 0) {
+            fprintf(stderr, "malformed record at offset %zu\n", replay->offset);
+            exit(1);
+        }
+        records += count;
+    }
+    double elapsed = bench_now() - start;
+
+    printf("{\"benchmark\": \"%s\", \"capture_bytes\": %zu, \"records\": %ld, \"decoded\": %zu, \"seconds\": %.3f, "
+           "\"packets_per_second\": %.0f, \"megabytes_per_second\": %.1f}\n",
+           name, replay->size, records, decoded, elapsed, records / elapsed, replay->size * rounds / elapsed / 1e6);
+}
+
+int main(int argc, char** argv) {
+    char path[] = "/tmp/bench-replay-XXXXXX";
+    const char* capture = argc > 1 ? argv[1] : NULL;
+    size_t rounds = argc > 2 ? strtoul(argv[2], NULL, 10) : 500;
+    if (capture == NULL) {
+        close(mkstemp(path));
+        bench_record(path);
+        capture = path;
+    }
+
+    size_t size = 0;
+    for (mcp_state_t state = 0; state < MCP_STATE__MAX; state++) {
+        for (mcp_source_t source = 0; source < MCP_SOURCE__MAX; source++) {
+            for (mcp_packet_id_t id = 0; id < mcp_protocol_max_ids[state][source]; id++) {
+                if (mcp_protocol_packets[state][source][id].size > size) {
+                    size = mcp_protocol_packets[state][source][id].size;
+                }
+            }
+        }
+    }
+    packet = malloc(size);
+
+    mcp_replay_t replay;
+    if (!mcp_replay_open(&replay, capture)) {
+        fprintf(stderr, "unable to open capture %s\n", capture);
+        return 1;
+    }
+    mcp_handler_table_t table;
+    mcp_handler_table_init(&table);
+    for (mcp_state_t state = 0; state < MCP_STATE__MAX; state++) {
+        for (mcp_source_t source = 0; source < MCP_SOURCE__MAX; source++) {
+            for (mcp_packet_id_t id = 0; id < mcp_protocol_max_ids[state][source]; id++) {
+                mcp_handler_table_set(&table, state, source, id, bench_decode);
+            }
+        }
+    }
+    mcp_context_t context;
+    mcp_context_init(&context, -1);
+    context.handlers = &table;
+
+    mcp_metrics_t metrics;
+    mcp_metrics_init(&metrics);
+    bench_replay(&replay, &context, rounds, "replay");
+    context.metrics = &metrics;
+    bench_replay(&replay, &context, rounds, "replay_metrics");
+    mcp_metrics_write(&metrics, stdout);
+
+    mcp_metrics_free(&metrics);
+    mcp_context_free(&context);
+    mcp_handler_table_free(&table);
+    mcp_replay_close(&replay);
+    free(packet);
+    if (capture == path) {
+        unlink(path);
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file stream.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief send and receive benchmark
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * sends packets of several sizes with chunk-like payloads through
+ * mcp_send and mcp_receive over a socket pair on a single thread,
+ * with and without compression, prints packets and payload
+ * megabytes per second as JSON
+ *
+ * usage: bench-stream [megabytes]
+ */
+    /* includes */
+#include "mcp/connection.h" /* mcp_send, mcp_receive */
+#include "mcp/handler.h"    /* packet handlers */
+#include "mcp/codec.h"      /* varint encoder */
+#include <sys/socket.h>     /* socketpair */
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* malloc, strtoul */
+#include <string.h>         /* memcpy */
+#include <time.h>           /* clock_gettime */
+#include <unistd.h>         /* close */
+
+    /* defines */
+/**
+ * @brief compression threshold of the compressed runs
+ */
+#define BENCH_THRESHOLD 256
+
+/**
+ * @brief maximum bytes and packets sent before the packets are received,
+ *          small writes take more socket buffer space than their size
+ */
+#define BENCH_BATCH_BYTES 65536
+#define BENCH_BATCH_PACKETS 64
+
+    /* variables */
+static size_t received_bytes;
+
+    /* functions */
+/**
+ * @brief get monotonic time in seconds
+ */
+static double bench_now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief count the payload of a received packet
+ *
+ * @param context connection context
+ */
+static void bench_consume(mcp_context_t* context) {
+    received_bytes += context->buffer.size - context->buffer.index;
+}
+
+/**
+ * @brief send and receive packets of one size
+ *
+ * @param payload   payload data
+ * @param size      payload size
+ * @param threshold compression threshold, zero to disable compression
+ * @param total     total payload bytes
+ */
+static void bench_shape(const char* payload, size_t size, int threshold, size_t total) {
+    int streams[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, streams) != 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    mcp_context_t sender, receiver;
+    mcp_context_init(&sender, streams[0]);
+    mcp_context_init(&receiver, streams[1]);
+    sender.state = receiver.state = MCP_STATE_PLAY;
+    sender.source = receiver.source = MCP_SOURCE_SERVER;
+    sender.compression_threshold = receiver.compression_threshold = threshold;
+
+    size_t packets = total / size;
+    size_t batch = BENCH_BATCH_BYTES / size;
+    if (batch == 0) {
+        batch = 1;
+    } else if (batch > BENCH_BATCH_PACKETS) {
+        batch = BENCH_BATCH_PACKETS;
+    }
+    received_bytes = 0;
+    double start = bench_now();
+    for (size_t sent = 0; sent < packets; sent += batch) {
+        size_t count = packets - sent < batch ? packets - sent : batch;
+        for (size_t i = 0; i < count; i++) {
+            mcp_buffer_begin(&sender.buffer, size + 1);
+            mcp_encode_varint(0, &sender.buffer);
+            mcp_buffer_reserve(&sender.buffer, size);
+            memcpy(mcp_buffer_current(&sender.buffer), payload, size);
+            mcp_buffer_increment(&sender.buffer, size);
+            mcp_send(&sender);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (!mcp_receive(&receiver)) {
+                perror("mcp_receive");
+                exit(1);
+            }
+        }
+    }
+    double elapsed = bench_now() - start;
+
+    #ifdef MCP_USE_ZLIB
+        const char* backend = "zlib";
+    #else
+        const char* backend = "libdeflate";
+    #endif /* MCP_USE_ZLIB */
+    printf("{\"benchmark\": \"stream\", \"payload\": %zu, \"compression\": %s, \"backend\": \"%s\", \"packets\": %zu, "
+           "\"seconds\": %.3f, \"packets_per_second\": %.0f, \"megabytes_per_second\": %.1f, \"valid\": %s}\n",
+           size, threshold > 0 ? "true" : "false", backend, packets, elapsed, packets / elapsed,
+           received_bytes / elapsed / 1e6, received_bytes == packets * size ? "true" : "false");
+
+    close(streams[0]);
+    close(streams[1]);
+    mcp_context_free(&sender);
+    mcp_context_free(&receiver);
+}
+
+int main(int argc, char** argv) {
+    size_t total = (argc > 1 ? strtoul(argv[1], NULL, 10) : 32) << 20;
+    mcp_handler_set(MCP_STATE_PLAY, MCP_SOURCE_SERVER, 0, bench_consume);
+
+    /* runs of palette indices with some noise, like chunk sections */
+    size_t sizes[] = { 64, 512, 4096, 32768 };
+    char* payload = malloc(sizes[3]);
+    srand(1);
+    for (size_t i = 0; i < sizes[3]; i++) {
+        payload[i] = i > 0 && rand() % 4 != 0 ? payload[i - 1] : rand() % 16;
+    }
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        bench_shape(payload, sizes[i], 0, total);
+        bench_shape(payload, sizes[i], BENCH_THRESHOLD, total);
+    }
+    free(payload);
+    return 0;
+}
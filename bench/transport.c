@@ -0,0 +1,175 @@
+/**
+ * @file transport.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief reactor backend benchmark
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * echoes keep alive packets over many connections and prints
+ * throughput, round trip latency and server thread cost as JSON
+ *
+ * usage: bench-transport [epoll|io_uring] [connections] [rounds]
+ */
+    /* feature test */
+#define _GNU_SOURCE /* RUSAGE_THREAD */
+
+    /* includes */
+#include "mcp/reactor.h"  /* reactor */
+#include "mcp/handler.h"  /* packet handlers */
+#include "mcp/protocol.h" /* packets */
+#include <sys/socket.h>   /* socketpair */
+#include <sys/resource.h> /* getrusage */
+#include <pthread.h>      /* server thread */
+#include <stdatomic.h>    /* stop flag */
+#include <stdio.h>        /* printf */
+#include <stdlib.h>       /* malloc, qsort */
+#include <string.h>       /* strcmp */
+#include <time.h>         /* clock_gettime */
+
+    /* variables */
+static mcp_reactor_t reactor;
+static atomic_bool running = true;
+static struct rusage server_usage;
+static mcp_context_t* clients;
+static double* sent;
+static double* latencies;
+static size_t latency_count;
+
+    /* functions */
+/**
+ * @brief get monotonic time in microseconds
+ */
+static double bench_now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+/**
+ * @brief compare two doubles for qsort
+ */
+static int bench_compare(const void* a, const void* b) {
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief echo a keep alive packet back to the client
+ *
+ * @param context connection context
+ */
+static void bench_echo(mcp_context_t* context) {
+    mcp_packet_server_KeepAlive request;
+    mcp_decode_packet_server_KeepAlive(&request, &context->buffer);
+    mcp_packet_client_KeepAlive response;
+    mcp_create_packet_client_KeepAlive(&response, request.keepAliveId);
+    mcp_encode_packet_client_KeepAlive(&response, &context->buffer);
+    mcp_send(context);
+}
+
+/**
+ * @brief record the round trip time of a keep alive packet
+ *
+ * @param context connection context
+ */
+static void bench_pong(mcp_context_t* context) {
+    mcp_packet_client_KeepAlive response;
+    mcp_decode_packet_client_KeepAlive(&response, &context->buffer);
+    latencies[latency_count++] = bench_now() - sent[context - clients];
+}
+
+/**
+ * @brief close a server connection
+ */
+static void bench_close(mcp_reactor_t* reactor, mcp_context_t* context) {
+    close(context->buffer.stream);
+    mcp_context_free(context);
+}
+
+/**
+ * @brief run the server reactor until stopped
+ */
+static void* bench_server(void* argument) {
+    while (atomic_load(&running)) {
+        mcp_reactor_run(&reactor, 10);
+    }
+    getrusage(RUSAGE_THREAD, &server_usage);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    bool uring = argc > 1 && strcmp(argv[1], "io_uring") == 0;
+    size_t connections = argc > 2 ? strtoul(argv[2], NULL, 10) : 256;
+    size_t rounds = argc > 3 ? strtoul(argv[3], NULL, 10) : 400;
+    if (!mcp_reactor_init_backend(&reactor, bench_close, uring ? MCP_REACTOR_IO_URING : MCP_REACTOR_EPOLL)) {
+        printf("{\"benchmark\": \"transport\", \"backend\": \"%s\", \"skipped\": true}\n", uring ? "io_uring" : "epoll");
+        return 0;
+    }
+    mcp_handler_set(MCP_STATE_PLAY, MCP_SOURCE_SERVER, MCP_SV_PL_KEEP_ALIVE, bench_echo);
+    mcp_handler_set(MCP_STATE_PLAY, MCP_SOURCE_CLIENT, MCP_CL_PL_KEEP_ALIVE, bench_pong);
+
+    clients = malloc(connections * sizeof(mcp_context_t));
+    mcp_context_t* servers = malloc(connections * sizeof(mcp_context_t));
+    sent = malloc(connections * sizeof(double));
+    latencies = malloc(connections * rounds * sizeof(double));
+    for (size_t i = 0; i < connections; i++) {
+        int streams[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, streams) != 0) {
+            perror("socketpair");
+            return 1;
+        }
+        mcp_context_init(&clients[i], streams[0]);
+        clients[i].state = MCP_STATE_PLAY;
+        clients[i].source = MCP_SOURCE_CLIENT;
+        mcp_context_init(&servers[i], streams[1]);
+        servers[i].state = MCP_STATE_PLAY;
+        servers[i].source = MCP_SOURCE_SERVER;
+        mcp_reactor_add(&reactor, &servers[i]);
+    }
+    pthread_t server;
+    pthread_create(&server, NULL, bench_server, NULL);
+
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < connections; i++) {
+            mcp_packet_server_KeepAlive request;
+            mcp_create_packet_server_KeepAlive(&request, round);
+            mcp_encode_packet_server_KeepAlive(&request, &clients[i].buffer);
+            sent[i] = bench_now();
+            mcp_send(&clients[i]);
+        }
+        for (size_t i = 0; i < connections; i++) {
+            if (!mcp_receive(&clients[i])) {
+                perror("mcp_receive");
+                return 1;
+            }
+        }
+    }
+    double elapsed = (bench_now() - start) / 1e6;
+    atomic_store(&running, false);
+    pthread_join(server, NULL);
+
+    qsort(latencies, latency_count, sizeof(double), bench_compare);
+    double cpu = server_usage.ru_utime.tv_sec + server_usage.ru_utime.tv_usec / 1e6
+               + server_usage.ru_stime.tv_sec + server_usage.ru_stime.tv_usec / 1e6;
+    printf("{\"benchmark\": \"transport\", \"backend\": \"%s\", \"connections\": %zu, \"packets\": %zu, "
+           "\"seconds\": %.3f, \"packets_per_second\": %.0f, \"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f, "
+           "\"server_cpu_seconds\": %.3f, \"server_context_switches\": %ld}\n",
+           uring ? "io_uring" : "epoll", connections, latency_count, elapsed, latency_count / elapsed,
+           latencies[latency_count / 2], latencies[latency_count * 99 / 100], latencies[latency_count * 999 / 1000],
+           cpu, server_usage.ru_nvcsw + server_usage.ru_nivcsw);
+
+    for (size_t i = 0; i < connections; i++) {
+        close(clients[i].buffer.stream);
+        mcp_context_free(&clients[i]);
+    }
+    while (reactor.count > 0) {
+        mcp_reactor_run(&reactor, 10);
+    }
+    mcp_reactor_free(&reactor);
+    free(servers);
+    free(clients);
+    free(sent);
+    free(latencies);
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file varint.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief varint array benchmark
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * decodes and encodes arrays shaped like tag entries and block palettes
+ * with a per-value loop and with the bulk functions, prints the
+ * number of values per second as JSON
+ *
+ * usage: bench-varint [values] [rounds]
+ */
+    /* includes */
+#include "mcp/codec.h" /* varint functions */
+#include <stdio.h>     /* printf */
+#include <stdlib.h>    /* malloc, strtoul */
+#include <time.h>      /* clock_gettime */
+
+    /* functions */
+/**
+ * @brief get monotonic time in seconds
+ */
+static double bench_now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief run one data shape and print the results
+ *
+ * @param name   data shape name
+ * @param values input values
+ * @param count  number of values
+ * @param rounds number of rounds
+ */
+static void bench_shape(const char* name, int32_t* values, size_t count, size_t rounds) {
+    int32_t* decoded = malloc(count * sizeof(int32_t));
+    mcp_buffer_t buffer = { 0 };
+    mcp_buffer_allocate(&buffer, count * 5);
+    for (size_t i = 0; i < count; i++) {
+        mcp_encode_varint((uint32_t) values[i], &buffer);
+    }
+    size_t size = buffer.index;
+
+    double start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        for (size_t i = 0; i < count; i++) {
+            decoded[i] = mcp_decode_varint(&buffer);
+        }
+    }
+    double loop_decode = bench_now() - start;
+
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        mcp_decode_varint_array(decoded, count, &buffer);
+    }
+    double bulk_decode = bench_now() - start;
+
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        for (size_t i = 0; i < count; i++) {
+            mcp_encode_varint((uint32_t) values[i], &buffer);
+        }
+    }
+    double loop_encode = bench_now() - start;
+
+    start = bench_now();
+    for (size_t round = 0; round < rounds; round++) {
+        buffer.index = 0;
+        mcp_encode_varint_array(values, count, &buffer);
+    }
+    double bulk_encode = bench_now() - start;
+
+    double total = (double) count * rounds;
+    printf("{\"benchmark\": \"varint\", \"shape\": \"%s\", \"values\": %zu, \"bytes\": %zu, "
+           "\"loop_decode_per_second\": %.0f, \"bulk_decode_per_second\": %.0f, "
+           "\"loop_encode_per_second\": %.0f, \"bulk_encode_per_second\": %.0f}\n",
+           name, count, size, total / loop_decode, total / bulk_decode, total / loop_encode, total / bulk_encode);
+    mcp_buffer_free(&buffer);
+    free(decoded);
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 4096;
+    size_t rounds = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+    int32_t* values = malloc(count * sizeof(int32_t));
+    srand(1);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = rand() % 128;
+    }
+    bench_shape("palette", values, count, rounds);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = rand() % 16384;
+    }
+    bench_shape("block_ids", values, count, rounds);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = rand() % 4 == 0 ? rand() % 16384 : rand() % 128;
+    }
+    bench_shape("mixed", values, count, rounds);
+    free(values);
+    return 0;
+}
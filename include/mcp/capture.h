@@ -0,0 +1,216 @@
+/**
+ * @file capture.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief packet capture recorder and replay driver
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * capture file is a header followed by records appended in the order
+ * packets were received or sent, each record is a record header and
+ * the packet data padded to 8 bytes, all numbers are little-endian
+ */
+    /* header guard */
+#ifndef MCP_CAPTURE_H
+#define MCP_CAPTURE_H
+
+    /* includes */
+#include "mcp/connection.h" /* connection context */
+#include "mcp/version.h"    /* protocol versions */
+#include <stdbool.h>        /* boolean type */
+#include <stdint.h>         /* integer types */
+#include <stdio.h>          /* file streams */
+
+    /* defines */
+/**
+ * @brief capture file magic and format version
+ */
+#define MCP_CAPTURE_MAGIC "MCPC"
+#define MCP_CAPTURE_VERSION 1
+
+/**
+ * @brief record flags
+ *
+ * source is the source of the packet, raw records hold a whole frame
+ * with its length header instead of an uncompressed packet,
+ * compressed raw frames have the uncompressed size header
+ */
+#define MCP_CAPTURE_SERVER 0x01
+#define MCP_CAPTURE_RAW 0x02
+#define MCP_CAPTURE_COMPRESSED 0x04
+
+    /* typedefs */
+/**
+ * @brief capture file header
+ *
+ * @note start is the wall clock time of the capture in nanoseconds
+ */
+typedef struct mcp_capture_header_t {
+    char magic[4];
+    uint32_t version;
+    uint64_t start;
+} mcp_capture_header_t;
+
+/**
+ * @brief capture record header
+ *
+ * @note time is in nanoseconds since the start of the capture,
+ *         protocol is the protocol version of the packet as it is on the stream
+ */
+typedef struct mcp_capture_record_t {
+    uint64_t time;
+    uint32_t length;
+    uint16_t protocol;
+    uint8_t state;
+    uint8_t flags;
+} mcp_capture_record_t;
+
+/**
+ * @brief capture recorder
+ *
+ * @note raw captures hold frames as they are on the stream,
+ *         others hold uncompressed packets starting with their id
+ * @note a recorder could be shared by connections on several threads,
+ *         a record is written while holding the file lock
+ */
+struct mcp_capture_t {
+    FILE* file;
+    uint64_t start;
+    bool raw;
+};
+
+/**
+ * @brief capture replay driver
+ *
+ * @note data is mapped read only, packets are decoded from the mapping
+ *         without copying them, so handlers should not modify the buffer
+ */
+typedef struct mcp_replay_t {
+    char* data;
+    size_t size;
+    size_t offset;
+    uint64_t start;
+} mcp_replay_t;
+
+    /* functions */
+/**
+ * @brief create a capture file
+ *
+ * @param capture pointer to the recorder
+ * @param path    file path, an existing file is truncated
+ * @param raw     record frames as they are on the stream
+ *
+ * @return false if the file could not be created
+ * @warning capture should be closed with mcp_capture_close after usage
+ */
+bool mcp_capture_open(mcp_capture_t* capture, const char* path, bool raw);
+
+/**
+ * @brief close a capture file
+ *
+ * @param capture pointer to the recorder
+ *
+ * @return false if any record could not be written
+ */
+bool mcp_capture_close(mcp_capture_t* capture);
+
+/**
+ * @brief append a record
+ *
+ * @param capture  pointer to the recorder
+ * @param protocol protocol version number
+ * @param state    packet state
+ * @param source   packet source
+ * @param flags    MCP_CAPTURE_RAW and MCP_CAPTURE_COMPRESSED flags
+ * @param data     packet or frame data
+ * @param length   data length
+ */
+void mcp_capture_write(mcp_capture_t* capture, int protocol, mcp_state_t state, mcp_source_t source, uint8_t flags, const char* data, size_t length);
+
+/**
+ * @brief append a record of a connection packet
+ *
+ * @param capture       pointer to the recorder
+ * @param context       connection context
+ * @param source        packet source
+ * @param frame         frame with its length header
+ * @param frame_length  frame length
+ * @param packet        uncompressed packet
+ * @param packet_length packet length
+ *
+ * @note called by mcp_receive and mcp_send when context->capture is set,
+ *         packets are recorded in the version of the connection stream
+ */
+static inline void mcp_capture_packet(mcp_capture_t* capture, mcp_context_t* context, mcp_source_t source, const char* frame, size_t frame_length, const char* packet, size_t packet_length) {
+    int protocol = mcp_version_get(context)->version;
+    if (capture->raw) {
+        mcp_capture_write(capture, protocol, context->state, source, MCP_CAPTURE_RAW | (context->compression_threshold > 0 ? MCP_CAPTURE_COMPRESSED : 0), frame, frame_length);
+    } else {
+        mcp_capture_write(capture, protocol, context->state, source, 0, packet, packet_length);
+    }
+}
+
+/**
+ * @brief map a capture file
+ *
+ * @param replay pointer to the replay driver
+ * @param path   file path
+ *
+ * @return false if the file could not be mapped or is not a capture
+ * @warning replay should be closed with mcp_replay_close after usage
+ */
+bool mcp_replay_open(mcp_replay_t* replay, const char* path);
+
+/**
+ * @brief unmap a capture file
+ *
+ * @param replay pointer to the replay driver
+ */
+void mcp_replay_close(mcp_replay_t* replay);
+
+/**
+ * @brief restart a replay from the first record
+ *
+ * @param replay pointer to the replay driver
+ */
+static inline void mcp_replay_rewind(mcp_replay_t* replay) {
+    replay->offset = sizeof(mcp_capture_header_t);
+}
+
+/**
+ * @brief read the next record
+ *
+ * @param replay pointer to the replay driver
+ * @param record destination record header
+ * @param data   destination pointer to the record data
+ *
+ * @return false at the end of the capture or at a truncated record
+ */
+bool mcp_replay_next(mcp_replay_t* replay, mcp_capture_record_t* record, char** data);
+
+/**
+ * @brief pass a record through the receive path of a connection
+ *
+ * @param context connection context, its state, source and protocol
+ *                  are set from the record
+ * @param record  record header
+ * @param data    record data
+ *
+ * @return false if the frame or the packet is malformed,
+ *           or if the record version is not generated
+ * @note the stream of the context is never used, packets with
+ *         mcp_handler_Forward handler are sent to the peer if it is set
+ */
+bool mcp_replay_packet(mcp_context_t* context, mcp_capture_record_t* record, char* data);
+
+/**
+ * @brief pass every remaining record through the receive path of a connection
+ *
+ * @param replay  pointer to the replay driver
+ * @param context connection context
+ *
+ * @return number of passed records, or -1 if a frame or a packet is malformed
+ * @note records of versions which are not generated are skipped
+ */
+long mcp_replay_run(mcp_replay_t* replay, mcp_context_t* context);
+
+#endif /* MCP_CAPTURE_H */
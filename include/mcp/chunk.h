@@ -0,0 +1,231 @@
+/**
+ * @file chunk.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief chunk column and section decoders and encoders
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_CHUNK_H
+#define MCP_CHUNK_H
+
+    /* includes */
+#include "mcp/codec.h"    /* encoders/decoders */
+#include "mcp/protocol.h" /* map chunk packet */
+#include <stdbool.h>      /* boolean type */
+#include <stddef.h>       /* size type */
+#include <stdint.h>       /* integer types */
+
+    /* defines */
+/**
+ * @brief number of blocks in a section, stored in y, z, x order
+ */
+#define MCP_CHUNK_SECTION_BLOCKS 4096
+
+/**
+ * @brief number of sections in a column
+ */
+#define MCP_CHUNK_SECTIONS 16
+
+/**
+ * @brief size of a section light array
+ */
+#define MCP_CHUNK_LIGHT_SIZE 2048
+
+/**
+ * @brief maximum bits per block of a section palette
+ */
+#define MCP_CHUNK_PALETTE_BITS 8
+
+/**
+ * @brief maximum bits per block of encoded block states
+ */
+#define MCP_CHUNK_MAX_BITS 16
+
+    /* typedefs */
+/**
+ * @brief chunk data format of a protocol version
+ */
+typedef struct mcp_chunk_format_t {
+  bool block_count;    /* sections start with the number of non-air blocks, 1.14+ */
+  bool spanning;       /* block states are split across longs, before 1.16 */
+  bool light;          /* sections end with light arrays, before 1.14 */
+  bool direct_palette; /* direct palettes are sent with an empty length, before 1.13 */
+  size_t biomes;       /* size of biomes after sections of a full column, before 1.15 */
+  uint8_t global_bits; /* bits per block of the global palette */
+} mcp_chunk_format_t;
+
+/**
+ * @brief decoded chunk section
+ *
+ * @note light arrays point into the source data,
+ *         they are NULL if the format has no light,
+ *         block count is -1 if the format has none
+ */
+typedef struct mcp_chunk_section_t {
+  uint16_t blocks[MCP_CHUNK_SECTION_BLOCKS];
+  int16_t block_count;
+  uint8_t bits;
+  char* block_light;
+  char* sky_light;
+} mcp_chunk_section_t;
+
+/**
+ * @brief decoded chunk column
+ *
+ * @note only sections set in the mask are decoded,
+ *         biomes point into the source data and are NULL
+ *         if the column is not full or the format has none
+ */
+typedef struct mcp_chunk_column_t {
+  uint16_t mask;
+  mcp_chunk_section_t sections[MCP_CHUNK_SECTIONS];
+  char* biomes;
+} mcp_chunk_column_t;
+
+    /* functions */
+/**
+ * @brief get the chunk data format of a protocol version
+ *
+ * @param protocol protocol version, 107 (1.9) or newer
+ */
+mcp_chunk_format_t mcp_chunk_format(int32_t protocol);
+
+/**
+ * @brief get the number of longs holding encoded block states
+ *
+ * @param count    number of block states
+ * @param bits     bits per block state
+ * @param spanning block states are split across longs
+ */
+static inline size_t mcp_chunk_longs(size_t count, uint8_t bits, bool spanning) {
+  if (spanning) {
+    return (count * bits + 63) / 64;
+  }
+  size_t per_long = 64 / bits;
+  return (count + per_long - 1) / per_long;
+}
+
+/**
+ * @brief unpack bit-packed block states
+ *
+ * @param dest     destination states
+ * @param count    number of states, a multiple of 8 at most MCP_CHUNK_SECTION_BLOCKS
+ * @param longs    big-endian longs, mcp_chunk_longs() of them
+ * @param bits     bits per state, 1 to MCP_CHUNK_MAX_BITS
+ * @param spanning states are split across longs
+ * @param palette  palette of 1 << bits entries, NULL to keep the states
+ *
+ * @note kernel is chosen at runtime from the cpu features
+ */
+void mcp_chunk_unpack(uint16_t* dest, size_t count, const char* longs, uint8_t bits, bool spanning, const int32_t* palette);
+
+/**
+ * @brief decode a chunk section
+ *
+ * @param section   destination section
+ * @param src       source buffer
+ * @param format    chunk data format
+ * @param sky_light section has sky light
+ *
+ * @return false if the section is malformed
+ */
+bool mcp_chunk_decode_section(mcp_chunk_section_t* section, mcp_buffer_t* src, mcp_chunk_format_t* format, bool sky_light);
+
+/**
+ * @brief decode the chunk data of a column
+ *
+ * @param column    destination column
+ * @param data      chunk data
+ * @param size      data size
+ * @param mask      primary bit mask of sent sections
+ * @param full      column is full
+ * @param sky_light sections have sky light
+ * @param format    chunk data format
+ *
+ * @return false if the data is malformed
+ */
+bool mcp_chunk_decode_column(mcp_chunk_column_t* column, char* data, size_t size, uint16_t mask, bool full, bool sky_light, mcp_chunk_format_t* format);
+
+/**
+ * @brief pack block states into longs
+ *
+ * @param longs    destination big-endian longs, mcp_chunk_longs() of them
+ * @param src      source states
+ * @param count    number of states, a multiple of 8 at most MCP_CHUNK_SECTION_BLOCKS
+ * @param bits     bits per state, 1 to MCP_CHUNK_MAX_BITS
+ * @param spanning states are split across longs
+ *
+ * @note high bits of the states above bits are dropped,
+ *         kernel is chosen at runtime from the cpu features
+ */
+void mcp_chunk_pack(char* longs, const uint16_t* src, size_t count, uint8_t bits, bool spanning);
+
+/**
+ * @brief build the palette of a section
+ *
+ * @param blocks  section states
+ * @param indices destination palette indices
+ * @param palette destination palette of 1 << MCP_CHUNK_PALETTE_BITS entries
+ * @param size    number of palette entries
+ *
+ * @return false if there are too many states for a palette
+ */
+bool mcp_chunk_palette(const uint16_t* blocks, uint16_t* indices, int32_t* palette, size_t* size);
+
+/**
+ * @brief encode a chunk section with the smallest palette
+ *
+ * @param section   source section, its bits are set to the chosen ones
+ * @param dest      destination buffer
+ * @param format    chunk data format
+ * @param sky_light section has sky light
+ *
+ * @note block count is computed from non-air states if it is negative,
+ *         missing light arrays are sent dark for blocks and bright for sky
+ */
+void mcp_chunk_encode_section(mcp_chunk_section_t* section, mcp_buffer_t* dest, mcp_chunk_format_t* format, bool sky_light);
+
+/**
+ * @brief encode the chunk data of a column
+ *
+ * @param column    source column, sections set in its mask are encoded
+ * @param dest      destination buffer
+ * @param full      column is full
+ * @param sky_light sections have sky light
+ * @param format    chunk data format
+ *
+ * @note missing biomes of a full column are sent as zeros
+ */
+void mcp_chunk_encode_column(mcp_chunk_column_t* column, mcp_buffer_t* dest, bool full, bool sky_light, mcp_chunk_format_t* format);
+
+/**
+ * @brief build the heightmaps of a column
+ *
+ * @param column     source column
+ * @param heightmaps destination compound with the motion blocking heightmap
+ * @param format     chunk data format
+ *
+ * @note height is above the highest non-air state
+ * @warning heightmaps should be deallocated with mcp_free_type_NbtTagCompound after usage
+ */
+void mcp_chunk_heightmaps(mcp_chunk_column_t* column, mcp_type_NbtTagCompound* heightmaps, mcp_chunk_format_t* format);
+
+#if MCP_PROTOCOL_VERSION >= 751
+/**
+ * @brief create a map chunk packet from a column
+ *
+ * @param packet destination packet
+ * @param column source column
+ * @param x      column x coordinate
+ * @param z      column z coordinate
+ * @param biomes 1024 biome ids of a full column, NULL for a partial one
+ * @param data   buffer holding the chunk data, could be reused between packets
+ *
+ * @note chunk data is valid until the data buffer is changed
+ * @warning packet should be deallocated with mcp_free_packet_server_MapChunk after usage
+ */
+void mcp_chunk_create_packet(mcp_packet_server_MapChunk* packet, mcp_chunk_column_t* column, int32_t x, int32_t z, int32_t* biomes, mcp_buffer_t* data);
+#endif /* MCP_PROTOCOL_VERSION */
+
+#endif /* MCP_CHUNK_H */
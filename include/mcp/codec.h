@@ -12,7 +12,9 @@
     /* includes */
 #include "mcp/io/buffer.h" /* buffered io */
 #include "mcp/type.h"      /* type definitions */
+#include "csafe/assertd.h" /* debug assertions */
 #include <endian.h>        /* byte swap */ 
+#include <stdlib.h>        /* malloc */
 #include <string.h>        /* string operation */
 
     /* functions */
@@ -23,12 +25,35 @@ void mcp_encode_type_UUID(mcp_type_UUID* this, mcp_buffer_t* dest);
 void mcp_decode_type_UUID(mcp_type_UUID* this, mcp_buffer_t* src);
 /* length is sizeof() compatible */
 
+/**
+ * nbt compound
+ * 
+ * @note read function expects the compound type byte to be already decoded,
+ *         skip function validates the compound without building its tree
+ */
+void mcp_encode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* dest);
+void mcp_decode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src);
+void mcp_read_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src);
+void mcp_skip_type_NbtTagCompound(mcp_buffer_t* src);
+static inline void mcp_length_type_NbtTagCompound(mcp_type_NbtTagCompound* this, size_t* length) {
+  *length += sizeof(uint8_t) + (this->nodes != NULL ? this->size : 0);
+}
+static inline void mcp_free_type_NbtTagCompound(mcp_type_NbtTagCompound* this) {
+  free(this->nodes);
+}
+
 /**
  * minecraft slot
  */
 void mcp_encode_type_Slot(mcp_type_Slot* this, mcp_buffer_t* dest);
 void mcp_decode_type_Slot(mcp_type_Slot* this, mcp_buffer_t* src);
 void mcp_length_type_Slot(mcp_type_Slot* this, size_t* length);
+void mcp_skip_type_Slot(mcp_buffer_t* src);
+static inline void mcp_free_type_Slot(mcp_type_Slot* this) {
+  if (this->present && this->nbt_data.has_value) {
+    mcp_free_type_NbtTagCompound(&this->nbt_data.value);
+  }
+}
 
 /**
  * minecraft particle
@@ -36,6 +61,11 @@ void mcp_length_type_Slot(mcp_type_Slot* this, size_t* length);
 void mcp_encode_type_Particle(mcp_type_Particle* this, mcp_buffer_t* dest);
 void mcp_decode_type_Particle(mcp_type_Particle* this, mcp_type_ParticleType p_type, mcp_buffer_t* src);
 void mcp_length_type_Particle(mcp_type_Particle* this, size_t* length);
+static inline void mcp_free_type_Particle(mcp_type_Particle* this) {
+  if (this->type == MCP_DEFINED_PARTICLE_ITEM) {
+    mcp_free_type_Slot(&this->item);
+  }
+}
 
 /**
  * minecraft smelting
@@ -44,7 +74,11 @@ void mcp_encode_type_Smelting(mcp_type_Smelting* this, mcp_buffer_t* dest);
 void mcp_decode_type_Smelting(mcp_type_Smelting* this, mcp_buffer_t* src);
 void mcp_length_type_Smelting(mcp_type_Smelting* this, size_t* length);
 static inline void mcp_free_type_Smelting(mcp_type_Smelting* this) {
+  for (size_t i = 0; i < this->ingredient.size; i++) {
+    mcp_free_type_Slot(&this->ingredient.data[i]);
+  }
   free(this->ingredient.data);
+  mcp_free_type_Slot(&this->result);
 }
 
 /**
@@ -54,6 +88,7 @@ void mcp_encode_type_Tag(mcp_type_Tag* this, mcp_buffer_t* dest);
 void mcp_decode_type_Tag(mcp_type_Tag* this, mcp_buffer_t* src);
 void mcp_length_type_Tag(mcp_type_Tag* this, size_t* length);
 static inline void mcp_free_type_Tag(mcp_type_Tag* this) { 
+  free(this->tag_name);
   free(this->entries.data);
 }
 
@@ -66,33 +101,73 @@ void mcp_length_type_EntityEquipment(mcp_type_EntityEquipment* this, size_t* len
 
 /**
  * minecraft entity metadata
+ * 
+ * @note skip function moves past the metadata without decoding its values
  */
 void mcp_encode_type_EntityMetadata(mcp_type_EntityMetadata* this, mcp_buffer_t* dest);
 void mcp_decode_type_EntityMetadata(mcp_type_EntityMetadata* this, mcp_buffer_t* src);
 void mcp_length_type_EntityMetadata(mcp_type_EntityMetadata* this, size_t* length);
+void mcp_skip_type_EntityMetadata(mcp_buffer_t* src);
+static inline void mcp_free_type_EntityMetadata(mcp_type_EntityMetadata* this) {
+  free(this->entries);
+}
 
 /**
  * utility macro for creating number encoders/decoders
+ * 
+ * @warning number decoders do not check the buffer size,
+ *            generated decoders check it once for a run of fixed size fields
+ * @note put and get functions access a number at a fixed offset
+ *         without touching the buffer index, they are used
+ *         by the generated codecs of fixed layout packets
  */
 #define __mcp_number(type, postfix, encode_converter, decode_converter)   \
 static inline void mcp_encode_##postfix(type this, mcp_buffer_t* dest) { \
+  mcp_buffer_reserve(dest, sizeof(type));                                 \
   *((type*) mcp_buffer_current(dest)) = encode_converter(this);          \
   mcp_buffer_increment(dest, sizeof(type));                               \
 }                                                                         \
 static inline void mcp_decode_##postfix(type* this, mcp_buffer_t* src) {  \
   *this = decode_converter(*((type*) mcp_buffer_current(src)));           \
   mcp_buffer_increment(src, sizeof(type));                                \
-}   
+}                                                                         \
+static inline void mcp_put_##postfix(char* dest, type this) {            \
+  type bits = encode_converter(this);                                     \
+  memcpy(dest, &bits, sizeof(type));                                      \
+}                                                                         \
+static inline type mcp_get_##postfix(const char* src) {                   \
+  type bits;                                                              \
+  memcpy(&bits, src, sizeof(type));                                       \
+  return decode_converter(bits);                                          \
+}
 
 #define __mcp_number_a(type, actual, postfix, encode_converter, decode_converter) \
 static inline void mcp_encode_##postfix(type this, mcp_buffer_t* dest) {         \
-  *((actual*) mcp_buffer_current(dest)) = encode_converter((actual) this);       \
+  actual bits;                                                                    \
+  memcpy(&bits, &this, sizeof(actual));                                           \
+  mcp_buffer_reserve(dest, sizeof(actual));                                       \
+  *((actual*) mcp_buffer_current(dest)) = encode_converter(bits);                \
   mcp_buffer_increment(dest, sizeof(actual));                                     \
 }                                                                                 \
 static inline void mcp_decode_##postfix(type* this, mcp_buffer_t* src) {          \
-  *this = (type) decode_converter(*((actual*) mcp_buffer_current(src)));          \
+  actual bits = decode_converter(*((actual*) mcp_buffer_current(src)));           \
+  memcpy(this, &bits, sizeof(actual));                                            \
   mcp_buffer_increment(src, sizeof(actual));                                      \
-}   
+}                                                                                 \
+static inline void mcp_put_##postfix(char* dest, type this) {                    \
+  actual bits;                                                                    \
+  memcpy(&bits, &this, sizeof(actual));                                           \
+  bits = encode_converter(bits);                                                  \
+  memcpy(dest, &bits, sizeof(actual));                                            \
+}                                                                                 \
+static inline type mcp_get_##postfix(const char* src) {                           \
+  actual bits;                                                                    \
+  type this;                                                                      \
+  memcpy(&bits, src, sizeof(actual));                                             \
+  bits = decode_converter(bits);                                                  \
+  memcpy(&this, &bits, sizeof(actual));                                           \
+  return this;                                                                    \
+}
 
 #define __mcp_dummy_converter(x) x
 
@@ -164,6 +239,13 @@ __mcp_number_a(double, uint64_t, lef64, htole64, le64toh)
 void mcp_encode_stream_varint(uint64_t src, mcp_stream_t dest);
 uint64_t mcp_decode_stream_varint(mcp_stream_t src);
 
+/**
+ * variable sized number (from memory of limited size)
+ * 
+ * @return number of bytes read, or 0 if the number is incomplete
+ */
+size_t mcp_peek_varint(char* src, size_t size, uint64_t* dest);
+
 /**
  * calculate varnum size for fixed integer
  */
@@ -203,16 +285,15 @@ static inline size_t mcp_length_varlong(uint64_t varlong) {
 /**
  * minecraft position
  */
-static inline void mcp_encode_type_Position(mcp_type_Position* this, mcp_buffer_t* dest) {
-  mcp_encode_be64((uint64_t) (
+static inline void mcp_put_type_Position(char* dest, mcp_type_Position* this) {
+  mcp_put_be64(dest, (uint64_t) (
     ((uint64_t) this->x & 0x3FFFFFFUL) << 38 |
     ((uint64_t) this->z & 0x3FFFFFFUL) << 12 |
     ((uint64_t) this->y & 0xFFFUL)
-  ), dest);
+  ));
 }
-static inline void mcp_decode_type_Position(mcp_type_Position* this, mcp_buffer_t* src) {
-  uint64_t tmp;
-  mcp_decode_be64(&tmp, src);
+static inline void mcp_get_type_Position(mcp_type_Position* this, const char* src) {
+  uint64_t tmp = mcp_get_be64(src);
   if ((this->x = tmp >> 38) & (1UL << 25))
     this->x -= 1UL << 26;
   if ((this->z = tmp >> 12 & 0x3FFFFFFUL) & (1UL << 25))
@@ -220,15 +301,37 @@ static inline void mcp_decode_type_Position(mcp_type_Position* this, mcp_buffer_
   if ((this->y = tmp & 0xFFFUL) & (1UL << 11))
     this->y -= 1UL << 12;
 }
+static inline void mcp_encode_type_Position(mcp_type_Position* this, mcp_buffer_t* dest) {
+  mcp_buffer_reserve(dest, sizeof(uint64_t));
+  mcp_put_type_Position(mcp_buffer_current(dest), this);
+  mcp_buffer_increment(dest, sizeof(uint64_t));
+}
+static inline void mcp_decode_type_Position(mcp_type_Position* this, mcp_buffer_t* src) {
+  mcp_get_type_Position(this, mcp_buffer_current(src));
+  mcp_buffer_increment(src, sizeof(uint64_t));
+}
 static inline void mcp_length_type_Position(mcp_type_Position* this, size_t* length) {
   *length += sizeof(uint64_t);
 }
 
+/**
+ * minecraft uuid at a fixed offset
+ */
+static inline void mcp_put_type_UUID(char* dest, mcp_type_UUID* this) {
+  mcp_put_be64(dest, this->msb);
+  mcp_put_be64(dest + sizeof(uint64_t), this->lsb);
+}
+static inline void mcp_get_type_UUID(mcp_type_UUID* this, const char* src) {
+  this->msb = mcp_get_be64(src);
+  this->lsb = mcp_get_be64(src + sizeof(uint64_t));
+}
+
 /**
  * string
  * 
  * @warning strings are encoded length-prefixed and without null terminator, 
- *            but decoder returns regular null-terminated string
+ *            but decoder returns regular null-terminated string,
+ *            or NULL if the string does not fit into the buffer
  */
 void mcp_encode_string(char* this, mcp_buffer_t* dest);
 void mcp_decode_string(char** this, mcp_buffer_t* src);
@@ -244,25 +347,156 @@ static inline void mcp_length_string(const char* this, size_t* length) {
  * buffer
  */
 static inline void mcp_encode_buffer(char_vector_t* this, mcp_buffer_t* dest) {
+  mcp_buffer_reserve(dest, this->size);
   memcpy(mcp_buffer_current(dest), this->data, this->size);
   mcp_buffer_increment(dest, this->size);
 }
 static inline void mcp_decode_buffer(char_vector_t* this, mcp_buffer_t* src) {
+  if (!mcp_buffer_check(src, this->size)) {
+    this->size = 0;
+  }
   this->data = mcp_buffer_current(src);
   mcp_buffer_increment(src, this->size);
 }
 
 /**
  * variable sized integer
+ * 
+ * @note decoder returns 0 and marks the buffer as malformed
+ *         if the number is incomplete or longer than 5 bytes
+ * @note numbers are 32-bit, they are encoded truncated to 32 bits
+ *         and decoded with sign extension
  */
 void mcp_encode_varint(uint64_t this, mcp_buffer_t* dest);
 uint64_t mcp_decode_varint(mcp_buffer_t* src);
 
 /**
- * @todo nbt stub
+ * variable sized long integer
+ *
+ * @note decoder returns 0 and marks the buffer as malformed
+ *         if the number is incomplete
+ * @note numbers are 64-bit, without truncation or sign extension
  */
-void mcp_encode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* dest);
-void mcp_decode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src);
-void mcp_read_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src);
+void mcp_encode_varlong(uint64_t this, mcp_buffer_t* dest);
+uint64_t mcp_decode_varlong(mcp_buffer_t* src);
+
+/**
+ * store a variable sized integer at a pointer
+ * 
+ * @return number of stored bytes, at most 10
+ * @warning there should be space for 10 bytes
+ * @note all 64 bits are stored, 32-bit varint fields
+ *         should be cast to uint32_t before
+ */
+static inline size_t mcp_put_varint(char* dest, uint64_t this) {
+  size_t length = 0;
+  for(; this >= 0x80; this >>= 7) {
+    dest[length++] = (char) 0x80 | (this & 0x7F);
+  }
+  dest[length++] = (char) this;
+  return length;
+}
+
+/**
+ * store a variable sized long integer at a pointer
+ *
+ * @return number of stored bytes, at most 10
+ * @warning there should be space for 10 bytes
+ */
+static inline size_t mcp_put_varlong(char* dest, uint64_t this) {
+  return mcp_put_varint(dest, this);
+}
+
+/**
+ * array of variable sized integers
+ * 
+ * @note values are 32-bit integers, they are encoded truncated to 32 bits
+ *         and decoded with sign extension, as single 32-bit varints are,
+ *         varints longer than 5 bytes mark the buffer as malformed,
+ *         vector kernels are used when the cpu supports them
+ */
+void mcp_encode_varint_array(int32_t* this, size_t count, mcp_buffer_t* dest);
+void mcp_decode_varint_array(int32_t* this, size_t count, mcp_buffer_t* src);
+void mcp_encode_varint_array64(int64_t* this, size_t count, mcp_buffer_t* dest);
+void mcp_decode_varint_array64(int64_t* this, size_t count, mcp_buffer_t* src);
+
+/**
+ * skip a variable sized integer or a string without decoding it
+ */
+static inline void mcp_skip_varint(mcp_buffer_t* src) {
+  size_t index = src->index;
+  while (index < src->size && src->data[index] & 0x80) {
+    index++;
+  }
+  if (index == src->size) {
+    mcp_buffer_fail(src);
+    return;
+  }
+  src->index = index + 1;
+}
+static inline void mcp_skip_string(mcp_buffer_t* src) {
+  size_t size = mcp_decode_varint(src);
+  mcp_buffer_skip(src, size);
+}
+
+/**
+ * string view
+ * 
+ * @warning decoded view points into the source buffer,
+ *            so it is valid only as long as the buffer is
+ */
+static inline void mcp_encode_string_view(string_view_t* this, mcp_buffer_t* dest) {
+  mcp_encode_varint(this->size, dest);
+  mcp_buffer_reserve(dest, this->size);
+  memcpy(mcp_buffer_current(dest), this->data, this->size);
+  mcp_buffer_increment(dest, this->size);
+}
+static inline void mcp_decode_string_view(string_view_t* this, mcp_buffer_t* src) {
+  this->size = mcp_decode_varint(src);
+  if (!mcp_buffer_check(src, this->size)) {
+    this->size = 0;
+  }
+  this->data = mcp_buffer_current(src);
+  mcp_buffer_increment(src, this->size);
+}
+static inline void mcp_length_string_view(string_view_t* this, size_t* length) {
+  *length += mcp_length_varlong(this->size) + this->size;
+}
+
+/**
+ * @brief create a view of a null-terminated string
+ * 
+ * @param string the string
+ */
+static inline string_view_t mcp_string_view(char* string) {
+  string_view_t view = { string, strlen(string) };
+  return view;
+}
+
+/**
+ * @brief compare a string view with a null-terminated string
+ * 
+ * @param this   the string view
+ * @param string the string
+ */
+static inline bool mcp_string_view_equals(string_view_t* this, const char* string) {
+  size_t size = strlen(string);
+  return this->size == size && memcmp(this->data, string, size) == 0;
+}
+
+/**
+ * @brief copy a string view into a null-terminated string
+ * 
+ * @param this the string view
+ * 
+ * @warning result should be deallocated with mcp_free_string after usage
+ */
+static inline char* mcp_string_view_copy(string_view_t* this) {
+  char* string = malloc(this->size + 1);
+  assertd_not_null("mcp_string_view_copy", string);
+  memcpy(string, this->data, this->size);
+  string[this->size] = 0;
+  return string;
+}
 
 #endif /* MCP_CODEC_H */
\ No newline at end of file
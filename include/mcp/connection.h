@@ -11,9 +11,19 @@
 
     /* includes */
 #include "mcp/io/buffer.h" /* buffered io */
+#include "mcp/io/region.h" /* reusable memory */
+#include "mcp/io/input.h"  /* read-ahead input */
+#include "mcp/io/output.h" /* queued output */
+#include "mcp/io/compression.h" /* compression state */
 #include "mcp/type.h"      /* data types */
 #include <stdint.h>        /* integer types */
 
+    /* defines */
+/**
+ * @brief maximum accepted length of a packet, compressed or not
+ */
+#define MCP_PACKET_MAX_LENGTH (1 << 23)
+
     /* typedefs */
 /**
  * @brief packet source enum
@@ -56,16 +66,80 @@ typedef struct mcp_client_t {
     mcp_type_UUID uuid;
 } mcp_client_t;
 
+/**
+ * @brief packet handler table type
+ */
+typedef struct mcp_handler_table_t mcp_handler_table_t;
+
+/**
+ * @brief packet capture recorder type
+ */
+typedef struct mcp_capture_t mcp_capture_t;
+
+/**
+ * @brief packet metrics type
+ */
+typedef struct mcp_metrics_t mcp_metrics_t;
+
+/**
+ * @brief protocol version descriptor type
+ */
+typedef struct mcp_protocol_t mcp_protocol_t;
+
 /**
  * @brief connection context
+ * 
+ * @note input buffers the stream in large chunks and holds received frames,
+ *         frame region holds decompressed packets, packet region holds
+ *         encoded packets, all are reused for every packet of the connection
+ * @note output queues frames sent while the context is corked
+ * @note compression state is shared by the thread when not set,
+ *         otherwise it is owned by the caller
+ * @note when buffer.arena is set, packets are decoded into it and released
+ *         at once after the handler returns, so they should not be freed
+ *         with mcp_free functions, the arena could be shared by contexts
+ *         handled on the same thread
+ * @note transport holds the state of the reactor backend driving the context
+ * @note handlers are taken from the global protocol tables when not set,
+ *         user is never accessed by the library
+ * @note packets with mcp_handler_Forward handler are copied to peer,
+ *         raw frames are passed through without decoding when both
+ *         contexts have the same compression threshold
+ * @note packets are recorded into capture when it is set, received
+ *         packets with the context source and sent ones with the other,
+ *         raw frames are not forwarded while either context is captured
+ * @note packets are counted in metrics when it is set, they could be
+ *         shared by the contexts handled on the same thread, forwarded
+ *         raw frames are counted as received and sent without being handled
+ * @note protocol is the version spoken on the stream, the library version
+ *         when not set, it is selected by the handshake packet otherwise,
+ *         packets of other versions are translated through inbound and
+ *         outbound regions, so handlers and encoders always use the
+ *         library version, raw frames are forwarded only between
+ *         contexts of the same version
  */
 typedef struct mcp_context_t {
     mcp_server_t server;
     mcp_client_t client;
     mcp_buffer_t buffer;
+    mcp_input_t input;
+    mcp_region_t frame;
+    mcp_region_t packet;
+    mcp_output_t output;
+    bool corked;
+    void* transport;
+    mcp_compression_t* compression;
     mcp_state_t state;
     mcp_source_t source;
     int compression_threshold;
+    mcp_handler_table_t* handlers;
+    mcp_capture_t* capture;
+    mcp_metrics_t* metrics;
+    const mcp_protocol_t* protocol;
+    mcp_region_t inbound;
+    mcp_region_t outbound;
+    struct mcp_context_t* peer;
+    void* user;
 } mcp_context_t;
 
 /**
@@ -73,19 +147,152 @@ typedef struct mcp_context_t {
  */
 typedef void mcp_handler_t(mcp_context_t* context);
 
+/**
+ * @brief packet decoder or encoder type
+ */
+typedef void mcp_packet_codec_t(void* packet, mcp_buffer_t* buffer);
+
+/**
+ * @brief packet deallocator type
+ */
+typedef void mcp_packet_free_t(void* packet);
+
+/**
+ * @brief generated packet descriptor
+ *
+ * @note sample is a synthetic encoding of the packet without its id,
+ *         numbers are zero, strings and arrays are short and optionals
+ *         are present, it is NULL if the packet has a type without a decoder
+ * @note min_length is a lower bound of the encoded packet length
+ *         without its id, shorter packets are always malformed
+ */
+typedef struct mcp_packet_info_t {
+    const char* name;
+    size_t size;
+    mcp_packet_codec_t* decode;
+    mcp_packet_codec_t* encode;
+    mcp_packet_free_t* free;
+    const char* sample;
+    size_t sample_size;
+    size_t min_length;
+} mcp_packet_info_t;
+
     /* functions */
+/**
+ * @brief initialize a connection context
+ * 
+ * @param context connection context
+ * @param stream  connection stream
+ * 
+ * @note receive and send memory is capped with MCP_REGION_DEFAULT_LIMIT, it could be
+ *         changed through context->input.region.limit, context->frame.limit
+ *         and context->packet.limit
+ * @warning context should be deallocated with mcp_context_free after usage
+ */
+void mcp_context_init(mcp_context_t* context, mcp_stream_t stream);
+
+/**
+ * @brief free memory owned by a connection context
+ * 
+ * @param context connection context
+ */
+void mcp_context_free(mcp_context_t* context);
+
 /**
  * @brief interface for receiving packets
  * 
  * @param context connection context
+ * 
+ * @return false if the stream was closed or the frame is malformed
+ * @note a packet is malformed also if its handler decodes it past its end,
+ *         decoders never read past the frame and mark the buffer as failed
+ * @note frames are read ahead, so several packets could be received
+ *         with a single read from the stream
+ * @note forwarded frames are parsed only up to the packet id, the part
+ *         which is not read ahead yet is spliced to the peer stream,
+ *         the id of a compressed frame is peeked only when built with zlib,
+ *         with libdeflate compressed frames are read and decompressed whole
+ *         before they are forwarded
+ * @note packets dropped by the version translation are consumed
+ *         without calling a handler
  */
-void mcp_receive(mcp_context_t* context);
+bool mcp_receive(mcp_context_t* context);
+
+/**
+ * @brief check if a whole packet is already buffered
+ * 
+ * @param context connection context
+ * 
+ * @return true if next mcp_receive call does not read from the stream
+ */
+bool mcp_receive_pending(mcp_context_t* context);
+
+/**
+ * @brief receive every packet that is already buffered, without reading from the stream
+ * 
+ * @param context connection context
+ * 
+ * @return number of received packets, or -1 if the stream is malformed
+ */
+int mcp_receive_buffered(mcp_context_t* context);
+
+/**
+ * @brief receive a frame which is already in memory, without using the stream
+ * 
+ * @param context connection context
+ * @param frame   frame without its length header
+ * @param length  frame length
+ * 
+ * @return false if the frame is malformed or has an unknown packet id,
+ *           or if its handler decodes it past its end
+ * @note the packet is passed to its handler even if it is mcp_handler_Forward,
+ *         the frame is not recorded into the capture
+ */
+bool mcp_receive_frame(mcp_context_t* context, char* frame, size_t length);
 
 /**
  * @brief interface for sending packets
  * 
- * @param context connection context with filled buffer
+ * @param context connection context with a packet encoded into the buffer
+ * 
+ * @return false if the stream failed
+ * @note frame header is written into the space reserved before the packet,
+ *         so the frame is written with a single call,
+ *         or queued until mcp_flush if the context is corked
+ * @note packets dropped by the version translation are not sent,
+ *         they are not a failure
+ * @note packets which could not be compressed are sent uncompressed
+ */
+bool mcp_send(mcp_context_t* context);
+
+/**
+ * @brief start queueing sent packets
+ * 
+ * @param context connection context
+ */
+static inline void mcp_cork(mcp_context_t* context) {
+    context->corked = true;
+}
+
+/**
+ * @brief write all queued packets with a single call
+ * 
+ * @param context connection context
+ * 
+ * @return false if the stream failed
+ */
+bool mcp_flush(mcp_context_t* context);
+
+/**
+ * @brief stop queueing sent packets and write the queued ones
+ * 
+ * @param context connection context
+ * 
+ * @return false if the stream failed
  */
-void mcp_send(mcp_context_t* context);
+static inline bool mcp_uncork(mcp_context_t* context) {
+    context->corked = false;
+    return mcp_flush(context);
+}
 
 #endif /* MCP_CONNECTION_H */
\ No newline at end of file
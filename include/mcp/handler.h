@@ -13,6 +13,18 @@
 #include "mcp/protocol.h" /* protocol */
 #include "csafe/assertd.h" /* debug assertions */
 
+    /* typedefs */
+/**
+ * @brief packet handler table
+ *
+ * holds a handler for every packet of every state and source,
+ * a table could be shared by the connections of a thread or owned
+ * by a single connection, so handlers are swapped without locks
+ */
+struct mcp_handler_table_t {
+    mcp_handler_t** handlers[MCP_STATE__MAX][MCP_SOURCE__MAX];
+};
+
     /* functions */
 /**
  * @brief get a handler for a packet
@@ -42,6 +54,64 @@ static inline void mcp_handler_set(mcp_state_t state, mcp_source_t source, mcp_p
     mcp_protocol_handlers[state][source][id] = handler;
 }
 
+/**
+ * @brief initialize a handler table with a copy of the global handlers
+ * 
+ * @param table pointer to the handler table
+ * 
+ * @warning table should be deallocated with mcp_handler_table_free after usage
+ */
+void mcp_handler_table_init(mcp_handler_table_t* table);
+
+/**
+ * @brief free a handler table
+ * 
+ * @param table pointer to the handler table
+ */
+void mcp_handler_table_free(mcp_handler_table_t* table);
+
+/**
+ * @brief get a handler for a packet from a handler table
+ * 
+ * @param table pointer to the handler table
+ * @param state connection state
+ * @param source packet source
+ * @param id packet id
+ */
+static inline mcp_handler_t* mcp_handler_table_get(mcp_handler_table_t* table, mcp_state_t state, mcp_source_t source, mcp_packet_id_t id) {
+    assertd_true_custom("mcp_handler_table_get", id < mcp_protocol_max_ids[state][source], "invalid packet id")
+    return table->handlers[state][source][id];
+}
+
+/**
+ * @brief set a handler for a packet in a handler table
+ * 
+ * @param table pointer to the handler table
+ * @param state connection state
+ * @param source packet source
+ * @param id packet id
+ * @param handler packet handler
+ */
+static inline void mcp_handler_table_set(mcp_handler_table_t* table, mcp_state_t state, mcp_source_t source, mcp_packet_id_t id, mcp_handler_t* handler) {
+    assertd_true_custom("mcp_handler_table_set", id < mcp_protocol_max_ids[state][source], "invalid packet id")
+    table->handlers[state][source][id] = handler;
+}
+
+/**
+ * @brief get a handler for a packet received by a connection
+ * 
+ * @param context connection context
+ * @param id packet id
+ * 
+ * @note uses the connection handler table if it is set, the global tables otherwise
+ */
+static inline mcp_handler_t* mcp_handler_find(mcp_context_t* context, mcp_packet_id_t id) {
+    if (context->handlers != NULL) {
+        return mcp_handler_table_get(context->handlers, context->state, context->source, id);
+    }
+    return mcp_handler_get(context->state, context->source, id);
+}
+
 /**
  * @brief blank packet handler
  * 
@@ -49,4 +119,15 @@ static inline void mcp_handler_set(mcp_state_t state, mcp_source_t source, mcp_p
  */
 void mcp_handler_Blank(mcp_context_t* context);
 
+/**
+ * @brief forwarding packet handler
+ * 
+ * @param context connection context
+ * 
+ * @note mcp_receive passes raw frames of packets with this handler
+ *         to the peer itself when possible, the handler is called only when
+ *         the peer uses a different compression threshold
+ */
+void mcp_handler_Forward(mcp_context_t* context);
+
 #endif /* MCP_HANDLER_H */
\ No newline at end of file
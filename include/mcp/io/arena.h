@@ -0,0 +1,108 @@
+/**
+ * @file arena.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief bump allocated memory for decoded packets
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_IO_ARENA_H
+#define MCP_IO_ARENA_H
+
+    /* includes */
+#include <stddef.h> /* size_t, max_align_t */
+#include <stdlib.h> /* memory functions */
+
+    /* defines */
+/**
+ * @brief size of the first block allocated by an arena
+ */
+#define MCP_ARENA_BLOCK_SIZE (1 << 16)
+
+/**
+ * @brief alignment of every allocation
+ */
+#define MCP_ARENA_ALIGNMENT (sizeof(max_align_t))
+
+    /* typedefs */
+/**
+ * @brief arena memory block
+ */
+typedef struct mcp_arena_block_t {
+    struct mcp_arena_block_t* next;
+    size_t size;
+    max_align_t data[];
+} mcp_arena_block_t;
+
+/**
+ * @brief bump allocator, released at once
+ *
+ * allocations are taken from the newest block, a larger block
+ * is added when it is exhausted, reset keeps only the newest block
+ * if it does not exceed the limit, zero limit means that
+ * the arena is never shrinked
+ */
+typedef struct mcp_arena_t {
+    mcp_arena_block_t* block;
+    size_t used;
+    size_t limit;
+} mcp_arena_t;
+
+    /* functions */
+/**
+ * @brief initialize an empty arena
+ *
+ * @param arena pointer to the arena
+ * @param limit maximum block size kept between uses
+ */
+static inline void mcp_arena_init(mcp_arena_t* arena, size_t limit) {
+    arena->block = NULL;
+    arena->used = 0;
+    arena->limit = limit;
+}
+
+/**
+ * @brief add a block large enough for an allocation
+ *
+ * @param arena pointer to the arena
+ * @param size  aligned allocation size
+ *
+ * @return pointer to the allocated memory
+ */
+void* mcp_arena_grow(mcp_arena_t* arena, size_t size);
+
+/**
+ * @brief allocate memory from an arena
+ *
+ * @param arena pointer to the arena
+ * @param size  allocation size
+ *
+ * @return pointer to the allocated memory, valid until the arena is reset
+ */
+static inline void* mcp_arena_allocate(mcp_arena_t* arena, size_t size) {
+    size = (size + MCP_ARENA_ALIGNMENT - 1) & ~(MCP_ARENA_ALIGNMENT - 1);
+    if (arena->block != NULL && size <= arena->block->size - arena->used) {
+        void* memory = (char*) arena->block->data + arena->used;
+        arena->used += size;
+        return memory;
+    }
+    return mcp_arena_grow(arena, size);
+}
+
+/**
+ * @brief release every allocation of an arena
+ *
+ * @param arena pointer to the arena
+ *
+ * @note cost does not depend on the number of allocations
+ */
+void mcp_arena_reset(mcp_arena_t* arena);
+
+/**
+ * @brief free an arena
+ *
+ * @param arena pointer to the arena
+ */
+void mcp_arena_free(mcp_arena_t* arena);
+
+#endif /* MCP_IO_ARENA_H */
@@ -11,18 +11,45 @@
 
     /* includes */
 #include "mcp/io/stream.h" /* stream io */
+#include "mcp/io/arena.h"  /* decode memory */
+#include "mcp/io/region.h" /* encode memory */
+#include <stdbool.h>       /* boolean type */
 #include <stddef.h>        /* size_t */
+#include <string.h>        /* memset, memcpy */
 #include <stdlib.h>        /* memory functions */
 
+    /* defines */
+/**
+ * @brief space reserved before an encoded packet for the frame header
+ */
+#define MCP_BUFFER_HEADROOM 10
+
+/**
+ * @brief initial size of an encode buffer without a region
+ */
+#define MCP_BUFFER_DEFAULT_SIZE 256
+
     /* typedefs */
 /**
  * @brief buffered stream data type
+ *
+ * @note memory of decoded arrays and strings is taken from the arena
+ *         when it is set, otherwise it is allocated with malloc
+ * @note encoded packets are written into the region when it is set,
+ *         otherwise into memory owned by the buffer,
+ *         the buffer grows while encoding in both cases
+ * @note failed is set when a decoded value does not fit into the buffer,
+ *         the index is moved to the end then, so every later check fails
+ *         and decoders return without reading past the data
  */
 typedef struct mcp_buffer_t {
     size_t size;
     size_t index;
     mcp_stream_t stream;
     char* data;
+    mcp_arena_t* arena;
+    mcp_region_t* region;
+    bool failed;
 } mcp_buffer_t;
 
     /* functions */
@@ -48,6 +75,85 @@ static inline void mcp_buffer_increment(mcp_buffer_t* buffer, size_t count) {
     buffer->index += count;
 }
 
+/**
+ * @brief get the number of bytes left after the current index
+ *
+ * @param buffer pointer to the buffer
+ */
+static inline size_t mcp_buffer_remaining(mcp_buffer_t* buffer) {
+    return buffer->size - buffer->index;
+}
+
+/**
+ * @brief mark a buffer as malformed
+ *
+ * @param buffer pointer to the buffer
+ */
+static inline void mcp_buffer_fail(mcp_buffer_t* buffer) {
+    buffer->index = buffer->size;
+    buffer->failed = true;
+}
+
+/**
+ * @brief make sure that count bytes could be decoded at the current index
+ *
+ * @param buffer pointer to the buffer
+ * @param count  number of bytes
+ *
+ * @return false if the buffer is too short, it is marked as malformed then
+ */
+static inline bool mcp_buffer_check(mcp_buffer_t* buffer, size_t count) {
+    if (buffer->size - buffer->index < count) {
+        mcp_buffer_fail(buffer);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief make sure that count values of at least size bytes could be decoded
+ *
+ * @param buffer pointer to the buffer
+ * @param count  number of values
+ * @param size   minimum value size, not zero
+ *
+ * @return false if the buffer is too short, it is marked as malformed then
+ * @note used before allocating decoded arrays, so a malformed count
+ *         could never allocate more than the buffer could hold
+ */
+static inline bool mcp_buffer_check_count(mcp_buffer_t* buffer, size_t count, size_t size) {
+    if (count > (buffer->size - buffer->index) / size) {
+        mcp_buffer_fail(buffer);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief move past count bytes without decoding them
+ *
+ * @param buffer pointer to the buffer
+ * @param count  number of bytes
+ */
+static inline void mcp_buffer_skip(mcp_buffer_t* buffer, size_t count) {
+    if (mcp_buffer_check(buffer, count)) {
+        mcp_buffer_increment(buffer, count);
+    }
+}
+
+/**
+ * @brief move past count values of size bytes without decoding them
+ *
+ * @param buffer pointer to the buffer
+ * @param count  number of values
+ * @param size   value size, not zero
+ */
+static inline void mcp_buffer_skip_count(mcp_buffer_t* buffer, size_t count, size_t size) {
+    if (mcp_buffer_check_count(buffer, count, size)) {
+        mcp_buffer_increment(buffer, count * size);
+    }
+}
+
 /**
  * @brief bind a buffer to a stream
  *
@@ -72,6 +178,111 @@ static inline void mcp_buffer_allocate(mcp_buffer_t* buffer, size_t size) {
     buffer->index = 0;
 }
 
+/**
+ * @brief grow a buffer to at least size bytes, preserving its contents
+ *
+ * @param buffer pointer to the buffer
+ * @param size   required size
+ */
+void mcp_buffer_grow(mcp_buffer_t* buffer, size_t size);
+
+/**
+ * @brief make sure that count bytes could be written at the current index
+ *
+ * @param buffer pointer to the buffer
+ * @param count  number of bytes
+ */
+static inline void mcp_buffer_reserve(mcp_buffer_t* buffer, size_t count) {
+    if (buffer->index + count > buffer->size) {
+        mcp_buffer_grow(buffer, buffer->index + count);
+    }
+}
+
+/**
+ * @brief start encoding a packet, leaving space for the frame header
+ *
+ * @param buffer pointer to the buffer
+ * @param size   expected packet size, zero if unknown
+ *
+ * @warning without a region, buffer should be deallocated
+ *            with mcp_buffer_free after usage
+ */
+static inline void mcp_buffer_begin(mcp_buffer_t* buffer, size_t size) {
+    if (buffer->region != NULL) {
+        buffer->data = mcp_region_reserve(buffer->region, MCP_BUFFER_HEADROOM + size);
+        buffer->size = buffer->region->capacity;
+    } else {
+        buffer->size = MCP_BUFFER_HEADROOM + (size > MCP_BUFFER_DEFAULT_SIZE ? size : MCP_BUFFER_DEFAULT_SIZE);
+        buffer->data = malloc(buffer->size);
+        assertd_not_null("mcp_buffer_begin", buffer->data);
+    }
+    buffer->index = MCP_BUFFER_HEADROOM;
+}
+
+/**
+ * @brief get a pointer to the packet encoded after mcp_buffer_begin
+ *
+ * @param buffer pointer to the buffer
+ */
+static inline char* mcp_buffer_packet(mcp_buffer_t* buffer) {
+    return &buffer->data[MCP_BUFFER_HEADROOM];
+}
+
+/**
+ * @brief get the length of the packet encoded after mcp_buffer_begin
+ *
+ * @param buffer pointer to the buffer
+ */
+static inline size_t mcp_buffer_packet_length(mcp_buffer_t* buffer) {
+    return buffer->index - MCP_BUFFER_HEADROOM;
+}
+
+/**
+ * @brief write bytes at the current index of a buffer
+ *
+ * @param buffer pointer to the buffer
+ * @param data   bytes to write, not inside of the buffer
+ * @param count  number of bytes
+ */
+static inline void mcp_buffer_append(mcp_buffer_t* buffer, const void* data, size_t count) {
+    mcp_buffer_reserve(buffer, count);
+    memcpy(mcp_buffer_current(buffer), data, count);
+    mcp_buffer_increment(buffer, count);
+}
+
+/**
+ * @brief allocate memory for a value decoded from a buffer
+ *
+ * @param buffer pointer to the buffer
+ * @param size   value size
+ *
+ * @warning values allocated from an arena should not be freed
+ */
+static inline void* mcp_buffer_decode_allocate(mcp_buffer_t* buffer, size_t size) {
+    if (buffer->arena != NULL) {
+        return mcp_arena_allocate(buffer->arena, size);
+    }
+    return malloc(size);
+}
+
+/**
+ * @brief allocate zeroed memory for a value decoded from a buffer
+ *
+ * @param buffer pointer to the buffer
+ * @param size   value size
+ *
+ * @note used for arrays of values which have to be freed,
+ *         so a partially decoded array could be freed too
+ * @warning values allocated from an arena should not be freed
+ */
+static inline void* mcp_buffer_decode_allocate_zeroed(mcp_buffer_t* buffer, size_t size) {
+    void* value = mcp_buffer_decode_allocate(buffer, size);
+    if (value != NULL) {
+        memset(value, 0, size);
+    }
+    return value;
+}
+
 /**
  * @brief assign already allocated data to a buffer
  *
@@ -82,6 +293,7 @@ static inline void mcp_buffer_allocate(mcp_buffer_t* buffer, size_t size) {
 static inline void mcp_buffer_set(mcp_buffer_t* buffer, char* data, size_t size) {
     buffer->data = data;
     buffer->size = size;
+    buffer->failed = false;
 }
 
 /**
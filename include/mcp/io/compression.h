@@ -0,0 +1,120 @@
+/**
+ * @file compression.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief cached zlib/libdeflate compression state
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_IO_COMPRESSION_H
+#define MCP_IO_COMPRESSION_H
+
+    /* includes */
+#include <stddef.h>  /* size_t */
+#include <stdbool.h> /* boolean type */
+
+    /* defines */
+/**
+ * @brief compression level used when none is specified
+ */
+#define MCP_COMPRESSION_DEFAULT_LEVEL 6
+
+    /* typedefs */
+/**
+ * @brief compressor and decompressor state
+ *
+ * state is allocated on first use and reused for every packet,
+ * zero level selects MCP_COMPRESSION_DEFAULT_LEVEL
+ */
+typedef struct mcp_compression_t {
+    int level;
+    void* compressor;
+    void* decompressor;
+} mcp_compression_t;
+
+    /* functions */
+/**
+ * @brief initialize compression state
+ *
+ * @param compression pointer to the compression state
+ * @param level       compression level
+ */
+void mcp_compression_init(mcp_compression_t* compression, int level);
+
+/**
+ * @brief change compression level
+ *
+ * @param compression pointer to the compression state
+ * @param level       compression level
+ */
+void mcp_compression_level(mcp_compression_t* compression, int level);
+
+/**
+ * @brief get the compression state shared by the current thread
+ *
+ * @note used by connections without their own compression state
+ * @warning should be deallocated with mcp_compression_thread_free before thread exit
+ */
+mcp_compression_t* mcp_compression_thread();
+
+/**
+ * @brief free the compression state of the current thread
+ */
+void mcp_compression_thread_free();
+
+/**
+ * @brief get maximum compressed size
+ *
+ * @param compression pointer to the compression state
+ * @param size        uncompressed size
+ */
+size_t mcp_compression_bound(mcp_compression_t* compression, size_t size);
+
+/**
+ * @brief compress data in zlib format
+ *
+ * @param compression pointer to the compression state
+ * @param src         uncompressed data
+ * @param src_size    uncompressed size
+ * @param dest        compressed data destination
+ * @param dest_size   destination size
+ *
+ * @return compressed size, or 0 on failure
+ */
+size_t mcp_compress(mcp_compression_t* compression, char* src, size_t src_size, char* dest, size_t dest_size);
+
+/**
+ * @brief decompress data in zlib format
+ *
+ * @param compression pointer to the compression state
+ * @param src         compressed data
+ * @param src_size    compressed size
+ * @param dest        uncompressed data destination
+ * @param dest_size   exact uncompressed size
+ *
+ * @return true on success
+ */
+bool mcp_decompress(mcp_compression_t* compression, char* src, size_t src_size, char* dest, size_t dest_size);
+
+/**
+ * @brief decompress leading bytes of data in zlib format
+ *
+ * @param compression pointer to the compression state
+ * @param src         compressed data, could be incomplete
+ * @param src_size    compressed size
+ * @param dest        uncompressed data destination
+ * @param dest_size   number of leading bytes to decompress
+ *
+ * @return number of decompressed bytes, 0 on failure
+ * @note libdeflate decompresses only whole buffers, so it always fails
+ */
+size_t mcp_decompress_prefix(mcp_compression_t* compression, char* src, size_t src_size, char* dest, size_t dest_size);
+
+/**
+ * @brief free compression state
+ *
+ * @param compression pointer to the compression state
+ */
+void mcp_compression_free(mcp_compression_t* compression);
+
+#endif /* MCP_IO_COMPRESSION_H */
\ No newline at end of file
@@ -0,0 +1,133 @@
+/**
+ * @file input.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief read-ahead stream input
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_IO_INPUT_H
+#define MCP_IO_INPUT_H
+
+    /* includes */
+#include "mcp/io/region.h" /* reusable memory */
+#include "mcp/io/stream.h" /* stream io */
+#include <stdbool.h>       /* boolean type */
+
+    /* defines */
+/**
+ * @brief size of a single read from a stream
+ */
+#define MCP_INPUT_DEFAULT_SIZE (1 << 16)
+
+    /* typedefs */
+/**
+ * @brief read-ahead input buffer
+ *
+ * data is read from a stream in large chunks and
+ * consumed from [begin, end) range of the region
+ */
+typedef struct mcp_input_t {
+    mcp_region_t region;
+    size_t begin;
+    size_t end;
+} mcp_input_t;
+
+    /* functions */
+/**
+ * @brief initialize an empty input buffer
+ *
+ * @param input pointer to the input buffer
+ * @param limit maximum capacity kept between packets
+ */
+static inline void mcp_input_init(mcp_input_t* input, size_t limit) {
+    mcp_region_init(&input->region, limit);
+    input->begin = 0;
+    input->end = 0;
+}
+
+/**
+ * @brief get number of buffered bytes
+ *
+ * @param input pointer to the input buffer
+ */
+static inline size_t mcp_input_available(mcp_input_t* input) {
+    return input->end - input->begin;
+}
+
+/**
+ * @brief get a pointer to the first buffered byte
+ *
+ * @param input pointer to the input buffer
+ *
+ * @warning pointer is invalidated by mcp_input_fill
+ */
+static inline char* mcp_input_current(mcp_input_t* input) {
+    return &input->region.data[input->begin];
+}
+
+/**
+ * @brief drop bytes from the beginning of the input buffer
+ *
+ * @param input pointer to the input buffer
+ * @param count number of bytes
+ */
+static inline void mcp_input_consume(mcp_input_t* input, size_t count) {
+    input->begin += count;
+    if (input->begin == input->end) {
+        input->begin = 0;
+        input->end = 0;
+    }
+}
+
+/**
+ * @brief append bytes to the input buffer
+ *
+ * @param input pointer to the input buffer
+ * @param src   data source
+ * @param count number of bytes
+ */
+void mcp_input_write(mcp_input_t* input, char* src, size_t count);
+
+/**
+ * @brief read from a stream until at least count bytes are buffered
+ *
+ * @param input  pointer to the input buffer
+ * @param stream the stream
+ * @param count  required number of buffered bytes
+ *
+ * @return false if the stream was closed or failed
+ */
+bool mcp_input_fill(mcp_input_t* input, mcp_stream_t stream, size_t count);
+
+/**
+ * @brief read once from a stream into the free space of the input buffer
+ *
+ * @param input  pointer to the input buffer
+ * @param stream the stream
+ *
+ * @return number of bytes read, 0 if the stream was closed, -1 on error
+ * @note buffer grows when it has no free space, so it is suitable
+ *         for non-blocking streams and frames of any size
+ */
+ssize_t mcp_input_receive(mcp_input_t* input, mcp_stream_t stream);
+
+/**
+ * @brief compact the input buffer and shrink it back to its limit
+ *
+ * @param input pointer to the input buffer
+ */
+void mcp_input_release(mcp_input_t* input);
+
+/**
+ * @brief free an input buffer
+ *
+ * @param input pointer to the input buffer
+ */
+static inline void mcp_input_free(mcp_input_t* input) {
+    mcp_region_free(&input->region);
+    input->begin = 0;
+    input->end = 0;
+}
+
+#endif /* MCP_IO_INPUT_H */
\ No newline at end of file
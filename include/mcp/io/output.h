@@ -0,0 +1,159 @@
+/**
+ * @file output.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief queued stream output
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_IO_OUTPUT_H
+#define MCP_IO_OUTPUT_H
+
+    /* includes */
+#include "mcp/io/region.h" /* reusable memory */
+#include "mcp/io/stream.h" /* stream io */
+#include <stdbool.h>       /* boolean type */
+#include <string.h>        /* memcpy */
+
+    /* typedefs */
+/**
+ * @brief range of queued bytes
+ */
+typedef struct mcp_output_segment_t {
+    size_t offset;
+    size_t length;
+} mcp_output_segment_t;
+
+/**
+ * @brief output queue
+ *
+ * queued bytes are stored in the region and described by segments,
+ * all segments are written to a stream with a single gathered write
+ *
+ * @note pipe is opened on first splice and kept until the queue is freed
+ */
+typedef struct mcp_output_t {
+    mcp_region_t region;
+    size_t size;
+    mcp_output_segment_t* segments;
+    size_t first;
+    size_t count;
+    size_t capacity;
+    int pipe[2];
+} mcp_output_t;
+
+    /* functions */
+/**
+ * @brief initialize an empty output queue
+ *
+ * @param output pointer to the output queue
+ * @param limit  maximum capacity kept between flushes
+ */
+static inline void mcp_output_init(mcp_output_t* output, size_t limit) {
+    mcp_region_init(&output->region, limit);
+    output->size = 0;
+    output->segments = NULL;
+    output->first = 0;
+    output->count = 0;
+    output->capacity = 0;
+    output->pipe[0] = -1;
+    output->pipe[1] = -1;
+}
+
+/**
+ * @brief check if the output queue has unwritten bytes
+ *
+ * @param output pointer to the output queue
+ */
+static inline bool mcp_output_pending(mcp_output_t* output) {
+    return output->first < output->count;
+}
+
+/**
+ * @brief get space for count bytes at the end of the output queue
+ *
+ * @param output pointer to the output queue
+ * @param count  number of bytes
+ *
+ * @return pointer to the free space
+ * @warning bytes are not queued until mcp_output_commit is called
+ */
+static inline char* mcp_output_reserve(mcp_output_t* output, size_t count) {
+    return &mcp_region_reserve(&output->region, output->size + count)[output->size];
+}
+
+/**
+ * @brief queue bytes from previously reserved space
+ *
+ * @param output pointer to the output queue
+ * @param skip   number of reserved bytes to leave unused
+ * @param length number of bytes to queue after the skipped ones
+ */
+void mcp_output_commit(mcp_output_t* output, size_t skip, size_t length);
+
+/**
+ * @brief copy bytes to the end of the output queue
+ *
+ * @param output pointer to the output queue
+ * @param src    data source
+ * @param count  number of bytes
+ */
+static inline void mcp_output_write(mcp_output_t* output, char* src, size_t count) {
+    memcpy(mcp_output_reserve(output, count), src, count);
+    mcp_output_commit(output, 0, count);
+}
+
+/**
+ * @brief drop written bytes from the beginning of the output queue
+ *
+ * @param output pointer to the output queue
+ * @param count  number of written bytes
+ *
+ * @note output queue is reset when all bytes are written
+ */
+void mcp_output_advance(mcp_output_t* output, size_t count);
+
+/**
+ * @brief write queued bytes to a stream
+ *
+ * @param output pointer to the output queue
+ * @param stream the stream, a socket
+ *
+ * @return false if the stream failed
+ * @note non-blocking streams keep the unwritten bytes queued
+ * @note written with MSG_NOSIGNAL, so a closed peer fails the flush
+ *         instead of raising SIGPIPE
+ */
+bool mcp_output_flush(mcp_output_t* output, mcp_stream_t stream);
+
+/**
+ * @brief move bytes from one stream to another through a pipe, without copying them
+ *
+ * @param output pointer to the output queue of the destination stream
+ * @param in     source stream
+ * @param out    destination stream
+ * @param count  number of bytes
+ *
+ * @return number of bytes taken from the source stream, less than count
+ *           if it has no more data or does not support splicing
+ * @note bytes which the destination stream does not accept are queued
+ * @warning output queue should be empty, otherwise the bytes are reordered
+ */
+size_t mcp_output_splice(mcp_output_t* output, mcp_stream_t in, mcp_stream_t out, size_t count);
+
+/**
+ * @brief free an output queue
+ *
+ * @param output pointer to the output queue
+ */
+static inline void mcp_output_free(mcp_output_t* output) {
+    mcp_region_free(&output->region);
+    free(output->segments);
+    if (output->pipe[0] >= 0) {
+        close(output->pipe[0]);
+        close(output->pipe[1]);
+    }
+    mcp_output_init(output, output->region.limit);
+}
+
+#endif /* MCP_IO_OUTPUT_H */
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file region.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief reusable memory regions
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_IO_REGION_H
+#define MCP_IO_REGION_H
+
+    /* includes */
+#include "csafe/assertd.h" /* debug assertions */
+#include <stddef.h>        /* size_t */
+#include <stdlib.h>        /* memory functions */
+
+    /* defines */
+/**
+ * @brief default amount of memory kept by a region between uses
+ */
+#define MCP_REGION_DEFAULT_LIMIT (1 << 21)
+
+    /* typedefs */
+/**
+ * @brief growable memory region, reused across packets
+ *
+ * region grows to the largest requested size (high-water mark)
+ * and keeps at most limit bytes allocated between uses,
+ * zero limit means that the region is never shrinked
+ */
+typedef struct mcp_region_t {
+    char* data;
+    size_t capacity;
+    size_t limit;
+} mcp_region_t;
+
+    /* functions */
+/**
+ * @brief initialize an empty region
+ *
+ * @param region pointer to the region
+ * @param limit  maximum capacity kept between uses
+ */
+static inline void mcp_region_init(mcp_region_t* region, size_t limit) {
+    region->data = NULL;
+    region->capacity = 0;
+    region->limit = limit;
+}
+
+/**
+ * @brief get at least size bytes of memory from a region
+ *
+ * @param region pointer to the region
+ * @param size   required size
+ *
+ * @return pointer to the region memory
+ *
+ * @warning previously returned pointers are invalidated,
+ *            but region contents are preserved
+ */
+static inline char* mcp_region_reserve(mcp_region_t* region, size_t size) {
+    if (size > region->capacity) {
+        size_t capacity = region->capacity * 2;
+        if (capacity < size) {
+            capacity = size;
+        }
+        region->data = realloc(region->data, capacity);
+        assertd_not_null("mcp_region_reserve", region->data);
+        region->capacity = capacity;
+    }
+    return region->data;
+}
+
+/**
+ * @brief shrink a region back to its limit after usage
+ *
+ * @param region pointer to the region
+ */
+static inline void mcp_region_release(mcp_region_t* region) {
+    if (region->limit != 0 && region->capacity > region->limit) {
+        region->data = realloc(region->data, region->limit);
+        assertd_not_null("mcp_region_release", region->data);
+        region->capacity = region->limit;
+    }
+}
+
+/**
+ * @brief free a region
+ *
+ * @param region pointer to the region
+ */
+static inline void mcp_region_free(mcp_region_t* region) {
+    free(region->data);
+    region->data = NULL;
+    region->capacity = 0;
+}
+
+#endif /* MCP_IO_REGION_H */
\ No newline at end of file
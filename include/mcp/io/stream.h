@@ -10,7 +10,8 @@
 #define MCP_IO_STREAM_H
 
     /* includes */
-#include <unistd.h> /* socket io */
+#include <unistd.h>  /* socket io */
+#include <stdbool.h> /* boolean type */
 
     /* typedefs */
 /**
@@ -37,4 +38,26 @@ void mcp_stream_write(mcp_stream_t stream, char* src, size_t count);
  */
 void mcp_stream_read(mcp_stream_t stream, char* dest, size_t count);
 
+/**
+ * @brief switch a stream between blocking and non-blocking mode
+ * 
+ * @param stream   the stream
+ * @param blocking true for blocking mode
+ * 
+ * @return false on failure
+ */
+bool mcp_stream_blocking(mcp_stream_t stream, bool blocking);
+
+/**
+ * @brief open a non-blocking listening stream
+ * 
+ * @param host  local address, NULL for any
+ * @param port  local port
+ * @param share allow several streams to listen on the same port,
+ *                incoming connections are balanced between them
+ * 
+ * @return the stream, or -1 on failure
+ */
+mcp_stream_t mcp_stream_listen(const char* host, const char* port, bool share);
+
 #endif /* MCP_IO_STREAM_H */
\ No newline at end of file
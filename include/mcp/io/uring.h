@@ -0,0 +1,98 @@
+/**
+ * @file uring.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief io_uring reactor backend
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_IO_URING_H
+#define MCP_IO_URING_H
+
+    /* includes */
+#include "mcp/reactor.h" /* reactor */
+#include <stdbool.h>     /* boolean type */
+
+    /* defines */
+/**
+ * @brief number of submission queue entries
+ */
+#define MCP_URING_ENTRIES 4096
+
+/**
+ * @brief number of provided receive buffers, must be a power of two
+ */
+#define MCP_URING_BUFFERS 1024
+
+/**
+ * @brief size of a provided receive buffer
+ */
+#define MCP_URING_BUFFER_SIZE (1 << 14)
+
+    /* functions */
+/**
+ * @brief create io_uring backend state for a reactor
+ *
+ * @param reactor pointer to the reactor
+ *
+ * @return backend state, NULL if io_uring is not supported
+ *           by the kernel or the library is built without it
+ */
+void* mcp_uring_create(mcp_reactor_t* reactor);
+
+/**
+ * @brief start accepting connections from the reactor listener
+ *
+ * @param reactor pointer to the reactor
+ *
+ * @return false on failure
+ */
+bool mcp_uring_listen(mcp_reactor_t* reactor);
+
+/**
+ * @brief start receiving from a connection
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ *
+ * @return false on failure
+ */
+bool mcp_uring_add(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief schedule queued output of a connection for the next submission
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ */
+void mcp_uring_flush(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief cancel operations on a connection
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ * @param notify  call the close callback when the operations are finished
+ *
+ * @note context is not accessed after the call when notify is false
+ */
+void mcp_uring_remove(mcp_reactor_t* reactor, mcp_context_t* context, bool notify);
+
+/**
+ * @brief submit queued operations, wait for completions and handle them
+ *
+ * @param reactor pointer to the reactor
+ * @param timeout maximum wait time in milliseconds, -1 for infinite
+ *
+ * @return number of handled completions, or -1 on failure
+ */
+int mcp_uring_run(mcp_reactor_t* reactor, int timeout);
+
+/**
+ * @brief free io_uring backend state
+ *
+ * @param reactor pointer to the reactor
+ */
+void mcp_uring_free(mcp_reactor_t* reactor);
+
+#endif /* MCP_IO_URING_H */
@@ -0,0 +1,253 @@
+/**
+ * @file metadata.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief entity metadata access and delta building
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_METADATA_H
+#define MCP_METADATA_H
+
+    /* includes */
+#include "mcp/codec.h" /* encoders/decoders */
+#include "mcp/nbt.h"   /* nbt compounds */
+#include "mcp/type.h"  /* metadata types */
+#include <stdbool.h>   /* boolean type */
+#include <stdint.h>    /* integer types */
+
+    /* defines */
+/**
+ * @brief index which terminates encoded metadata
+ */
+#define MCP_METADATA_END 0xFF
+
+    /* typedefs */
+/**
+ * @brief space of an index in the builder data
+ *
+ * @note capacity is kept when a smaller value is stored,
+ *         so the slot is reused by the later larger values
+ */
+typedef struct mcp_metadata_slot_t {
+  uint32_t offset;
+  uint32_t capacity;
+} mcp_metadata_slot_t;
+
+/**
+ * @brief entity metadata builder
+ *
+ * keeps the last value of every index of an entity
+ * and marks the indices whose value has changed,
+ * so only they are sent in the next metadata packet
+ *
+ * @note state is not a decoded metadata, it should not be
+ *         freed with mcp_free_type_EntityMetadata
+ * @note encoded values of an index are kept in its slot, a slot is moved
+ *         to the end of the data only when a value does not fit in it
+ */
+typedef struct mcp_metadata_builder_t {
+  mcp_type_EntityMetadata state;
+  size_t capacity;
+  size_t data_capacity;
+  mcp_type_EntityMetadataEntry* delta;
+  uint8_t positions[MCP_METADATA_END];
+  mcp_metadata_slot_t slots[MCP_METADATA_END];
+  uint64_t dirty[4];
+} mcp_metadata_builder_t;
+
+    /* functions */
+/**
+ * @brief check if values of a type are kept encoded in the metadata data
+ *
+ * @param type value type
+ */
+static inline bool mcp_metadata_is_data(uint8_t type) {
+  switch (type) {
+    case MCP_METADATA_STRING:
+    case MCP_METADATA_CHAT:
+    case MCP_METADATA_OPT_CHAT:
+    case MCP_METADATA_SLOT:
+    case MCP_METADATA_NBT:
+    case MCP_METADATA_PARTICLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief find an entry by its index
+ *
+ * @param this  the metadata
+ * @param index entry index
+ *
+ * @return the entry, NULL if there is none
+ */
+static inline mcp_type_EntityMetadataEntry* mcp_metadata_find(mcp_type_EntityMetadata* this, uint8_t index) {
+  for (size_t i = 0; i < this->count; i++) {
+    if (this->entries[i].index == index) {
+      return &this->entries[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief get the encoded value of an entry
+ *
+ * @param this  the metadata
+ * @param entry string, chat, slot, nbt or particle entry
+ */
+static inline char* mcp_metadata_data(mcp_type_EntityMetadata* this, mcp_type_EntityMetadataEntry* entry) {
+  return &this->data[entry->value.data.offset];
+}
+
+/**
+ * @brief get the value of a string or chat entry
+ *
+ * @param this  the metadata
+ * @param entry string, chat or optional chat entry
+ *
+ * @note view points into the metadata data
+ */
+static inline string_view_t mcp_metadata_string(mcp_type_EntityMetadata* this, mcp_type_EntityMetadataEntry* entry) {
+  uint64_t size = 0;
+  size_t header = mcp_peek_varint(mcp_metadata_data(this, entry), entry->value.data.size, &size);
+  return (string_view_t) { mcp_metadata_data(this, entry) + header, size };
+}
+
+/**
+ * @brief decode the value of a slot entry
+ *
+ * @param this  the metadata
+ * @param entry slot entry
+ * @param slot  destination slot
+ *
+ * @warning slot should be deallocated with mcp_free_type_Slot after usage
+ */
+static inline void mcp_metadata_slot(mcp_type_EntityMetadata* this, mcp_type_EntityMetadataEntry* entry, mcp_type_Slot* slot) {
+  mcp_buffer_t src = { 0 };
+  mcp_buffer_set(&src, mcp_metadata_data(this, entry), entry->value.data.size);
+  mcp_decode_type_Slot(slot, &src);
+}
+
+/**
+ * @brief build the tree of an nbt entry
+ *
+ * @param this     the metadata
+ * @param entry    nbt entry
+ * @param compound destination compound
+ *
+ * @return false if the compound is malformed
+ * @warning compound should be deallocated with mcp_free_type_NbtTagCompound after usage
+ */
+static inline bool mcp_metadata_nbt(mcp_type_EntityMetadata* this, mcp_type_EntityMetadataEntry* entry, mcp_type_NbtTagCompound* compound) {
+  return mcp_nbt_parse(compound, mcp_metadata_data(this, entry), entry->value.data.size);
+}
+
+/**
+ * @brief initialize a metadata builder
+ *
+ * @param builder pointer to the builder
+ *
+ * @warning builder should be deallocated with mcp_metadata_builder_free after usage
+ */
+void mcp_metadata_builder_init(mcp_metadata_builder_t* builder);
+
+/**
+ * @brief free a metadata builder
+ *
+ * @param builder pointer to the builder
+ */
+void mcp_metadata_builder_free(mcp_metadata_builder_t* builder);
+
+/**
+ * @brief set an inline value
+ *
+ * @param builder pointer to the builder
+ * @param entry   entry with the index, type and value, unused value bytes should be zero
+ *
+ * @return true if the value has changed
+ */
+bool mcp_metadata_set(mcp_metadata_builder_t* builder, mcp_type_EntityMetadataEntry* entry);
+
+/**
+ * @brief set an encoded value
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param type    string, chat, optional chat, slot, nbt or particle type
+ * @param data    encoded value, without the presence flag of optional chat
+ * @param size    value size
+ *
+ * @return true if the value has changed
+ * @note absent optional chat is set with a NULL data
+ */
+bool mcp_metadata_set_data(mcp_metadata_builder_t* builder, uint8_t index, uint8_t type, char* data, size_t size);
+
+/**
+ * @brief set a string or chat value
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param type    string, chat or optional chat type
+ * @param value   null-terminated string, NULL for absent optional chat
+ *
+ * @return true if the value has changed
+ */
+bool mcp_metadata_set_string(mcp_metadata_builder_t* builder, uint8_t index, uint8_t type, const char* value);
+
+/**
+ * @brief set an integer value
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param type    byte, boolean or varint based type
+ * @param value   the value
+ *
+ * @return true if the value has changed
+ */
+static inline bool mcp_metadata_set_integer(mcp_metadata_builder_t* builder, uint8_t index, uint8_t type, int32_t value) {
+  mcp_type_EntityMetadataEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.index = index;
+  entry.type = type;
+  entry.present = true;
+  entry.value.integer = value;
+  return mcp_metadata_set(builder, &entry);
+}
+
+/**
+ * @brief set a float value
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param value   the value
+ *
+ * @return true if the value has changed
+ */
+static inline bool mcp_metadata_set_float(mcp_metadata_builder_t* builder, uint8_t index, float value) {
+  mcp_type_EntityMetadataEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.index = index;
+  entry.type = MCP_METADATA_FLOAT;
+  entry.present = true;
+  entry.value.number = value;
+  return mcp_metadata_set(builder, &entry);
+}
+
+/**
+ * @brief get changed entries and clear the changes
+ *
+ * @param builder pointer to the builder
+ * @param delta   metadata with the changed entries
+ * @param full    get every entry instead of the changed ones
+ *
+ * @return number of entries
+ * @note delta refers to the builder memory, so it is valid until
+ *         the next call and should not be freed
+ */
+size_t mcp_metadata_builder_delta(mcp_metadata_builder_t* builder, mcp_type_EntityMetadata* delta, bool full);
+
+#endif /* MCP_METADATA_H */
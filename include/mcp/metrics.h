@@ -0,0 +1,201 @@
+/**
+ * @file metrics.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief per-packet counters and handler latency histograms
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_METRICS_H
+#define MCP_METRICS_H
+
+    /* includes */
+#include "mcp/connection.h" /* states and sources */
+#include <stdatomic.h>      /* relaxed counters */
+#include <stdint.h>         /* integer types */
+#include <stdio.h>          /* file streams */
+#include <time.h>           /* clock_gettime */
+
+    /* defines */
+/**
+ * @brief number of sub-buckets of every power of two, as a power of two
+ */
+#define MCP_METRICS_SUB_BITS 2
+
+/**
+ * @brief number of histogram buckets, 128 buckets cover times
+ *          up to about 8.6 seconds and the last one holds every longer time
+ */
+#define MCP_METRICS_BUCKETS 128
+
+    /* typedefs */
+/**
+ * @brief counter written by a single thread and read by any
+ */
+typedef _Atomic uint64_t mcp_metrics_counter_t;
+
+/**
+ * @brief metrics of a packet
+ *
+ * count includes sent and received packets, handled only received ones,
+ * wire bytes are frame bytes including the length header, packet bytes
+ * are uncompressed, nanoseconds and buckets hold handler latency
+ *
+ * @note buckets are logarithmic with MCP_METRICS_SUB_BITS of precision,
+ *         so every bucket is at most 25% wide
+ */
+typedef struct mcp_metrics_packet_t {
+    mcp_metrics_counter_t count;
+    mcp_metrics_counter_t handled;
+    mcp_metrics_counter_t wire_bytes;
+    mcp_metrics_counter_t packet_bytes;
+    mcp_metrics_counter_t nanoseconds;
+    mcp_metrics_counter_t buckets[MCP_METRICS_BUCKETS];
+} mcp_metrics_packet_t;
+
+/**
+ * @brief metrics of every packet of every state and source
+ *
+ * a metrics instance is written by a single thread, usually shared by
+ * its connections, and could be read by others at any time,
+ * counters are updated with relaxed stores, so recording takes
+ * no locks or atomic read-modify-write instructions
+ */
+struct mcp_metrics_t {
+    mcp_metrics_packet_t* packets[MCP_STATE__MAX][MCP_SOURCE__MAX];
+};
+
+    /* functions */
+/**
+ * @brief initialize metrics with zero counters
+ *
+ * @param metrics pointer to the metrics
+ *
+ * @warning metrics should be deallocated with mcp_metrics_free after usage
+ */
+void mcp_metrics_init(mcp_metrics_t* metrics);
+
+/**
+ * @brief free metrics
+ *
+ * @param metrics pointer to the metrics
+ */
+void mcp_metrics_free(mcp_metrics_t* metrics);
+
+/**
+ * @brief add metrics of another thread
+ *
+ * @param dest   destination metrics, owned by the calling thread
+ * @param source source metrics, could be written during the call
+ *
+ * @note counters of the source are read one by one, so a packet
+ *         recorded during the call could be partially added
+ */
+void mcp_metrics_merge(mcp_metrics_t* dest, mcp_metrics_t* source);
+
+/**
+ * @brief get the upper bound of a latency percentile
+ *
+ * @param packet   packet metrics
+ * @param quantile quantile between 0 and 1
+ *
+ * @return nanoseconds, 0 if the packet was never handled
+ */
+uint64_t mcp_metrics_percentile(mcp_metrics_packet_t* packet, double quantile);
+
+/**
+ * @brief write metrics of every seen packet as JSON, one object per line
+ *
+ * @param metrics pointer to the metrics
+ * @param file    destination file
+ */
+void mcp_metrics_write(mcp_metrics_t* metrics, FILE* file);
+
+/**
+ * @brief get a monotonic time in nanoseconds
+ */
+static inline uint64_t mcp_metrics_now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * @brief get the histogram bucket of a time
+ *
+ * @param nanoseconds the time
+ */
+static inline size_t mcp_metrics_bucket(uint64_t nanoseconds) {
+    if (nanoseconds < (1 << MCP_METRICS_SUB_BITS)) {
+        return nanoseconds;
+    }
+    unsigned bit = 63 - __builtin_clzll(nanoseconds);
+    size_t bucket = (size_t) (bit - MCP_METRICS_SUB_BITS + 1) << MCP_METRICS_SUB_BITS
+                  | ((nanoseconds >> (bit - MCP_METRICS_SUB_BITS)) & ((1 << MCP_METRICS_SUB_BITS) - 1));
+    return bucket < MCP_METRICS_BUCKETS ? bucket : MCP_METRICS_BUCKETS - 1;
+}
+
+/**
+ * @brief get the lowest time of a histogram bucket
+ *
+ * @param bucket the bucket
+ */
+static inline uint64_t mcp_metrics_bucket_value(size_t bucket) {
+    if (bucket < (1 << MCP_METRICS_SUB_BITS)) {
+        return bucket;
+    }
+    unsigned bit = (bucket >> MCP_METRICS_SUB_BITS) + MCP_METRICS_SUB_BITS - 1;
+    return (uint64_t) ((1 << MCP_METRICS_SUB_BITS) | (bucket & ((1 << MCP_METRICS_SUB_BITS) - 1))) << (bit - MCP_METRICS_SUB_BITS);
+}
+
+/**
+ * @brief add to a counter owned by the calling thread
+ *
+ * @param counter the counter
+ * @param value   added value
+ */
+static inline void mcp_metrics_add(mcp_metrics_counter_t* counter, uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**
+ * @brief get the metrics of a packet
+ *
+ * @param metrics pointer to the metrics
+ * @param state   packet state
+ * @param source  packet source
+ * @param id      packet id
+ */
+static inline mcp_metrics_packet_t* mcp_metrics_get(mcp_metrics_t* metrics, mcp_state_t state, mcp_source_t source, mcp_packet_id_t id) {
+    return &metrics->packets[state][source][id];
+}
+
+/**
+ * @brief record a sent packet
+ *
+ * @param packet       packet metrics
+ * @param wire_bytes   frame length
+ * @param packet_bytes uncompressed packet length
+ */
+static inline void mcp_metrics_sent(mcp_metrics_packet_t* packet, size_t wire_bytes, size_t packet_bytes) {
+    mcp_metrics_add(&packet->count, 1);
+    mcp_metrics_add(&packet->wire_bytes, wire_bytes);
+    mcp_metrics_add(&packet->packet_bytes, packet_bytes);
+}
+
+/**
+ * @brief record a received packet
+ *
+ * @param packet       packet metrics
+ * @param wire_bytes   frame length
+ * @param packet_bytes uncompressed packet length
+ * @param nanoseconds  handler time
+ */
+static inline void mcp_metrics_received(mcp_metrics_packet_t* packet, size_t wire_bytes, size_t packet_bytes, uint64_t nanoseconds) {
+    mcp_metrics_sent(packet, wire_bytes, packet_bytes);
+    mcp_metrics_add(&packet->handled, 1);
+    mcp_metrics_add(&packet->nanoseconds, nanoseconds);
+    mcp_metrics_add(&packet->buckets[mcp_metrics_bucket(nanoseconds)], 1);
+}
+
+#endif /* MCP_METRICS_H */
@@ -0,0 +1,368 @@
+/**
+ * @file nbt.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief named binary tag reader, tree and writer
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_NBT_H
+#define MCP_NBT_H
+
+    /* includes */
+#include "mcp/codec.h" /* encoders/decoders */
+#include "mcp/type.h"  /* nbt types */
+#include <stdbool.h>   /* boolean type */
+#include <stdint.h>    /* integer types */
+
+    /* defines */
+/**
+ * @brief maximum nesting of compounds and lists
+ */
+#define MCP_NBT_MAX_DEPTH 512
+
+    /* typedefs */
+/**
+ * @brief nbt reader event
+ *
+ * tag is MCP_NBT_TAG_END when a compound or a list ends,
+ * value points to the big-endian payload in the source data,
+ * size is the number of elements of a list or an array and the
+ * length of a string, name is empty for list elements
+ *
+ * @note container is set for compounds and lists of non-number values,
+ *         they are followed by their elements and an end event,
+ *         lists of numbers are reported like arrays
+ */
+typedef struct mcp_nbt_event_t {
+  mcp_type_NbtTag tag;
+  mcp_type_NbtTag element;
+  string_view_t name;
+  char* value;
+  size_t size;
+  size_t depth;
+  bool container;
+} mcp_nbt_event_t;
+
+/**
+ * @brief nbt reader callback
+ *
+ * @param event the event
+ * @param user  user data
+ *
+ * @return false to stop reading
+ */
+typedef bool mcp_nbt_visitor_t(mcp_nbt_event_t* event, void* user);
+
+    /* functions */
+/**
+ * @brief read a named tag, calling a visitor for every value
+ *
+ * @param data    encoded tag after its type byte
+ * @param size    data size
+ * @param tag     tag type
+ * @param visitor visitor callback, NULL to only validate the tag
+ * @param user    visitor user data
+ * @param nodes   number of tree nodes of the tag, could be NULL
+ *
+ * @return length of the tag, 0 if it is malformed or the visitor stopped
+ * @note reader does not allocate memory and does not recurse
+ */
+size_t mcp_nbt_read(char* data, size_t size, mcp_type_NbtTag tag, mcp_nbt_visitor_t* visitor, void* user, size_t* nodes);
+
+/**
+ * @brief measure a named tag without reading its values
+ *
+ * @param data  encoded tag after its type byte
+ * @param size  data size
+ * @param tag   tag type
+ * @param nodes number of tree nodes of the tag, could be NULL
+ *
+ * @return length of the tag, 0 if it is malformed
+ */
+static inline size_t mcp_nbt_measure(char* data, size_t size, mcp_type_NbtTag tag, size_t* nodes) {
+  return mcp_nbt_read(data, size, tag, NULL, NULL, nodes);
+}
+
+/**
+ * @brief build a compound tree from encoded data
+ *
+ * @param this the compound
+ * @param data encoded compound starting with its type byte
+ * @param size data size
+ *
+ * @return false if the data is malformed
+ * @note end tag is parsed as an empty compound
+ * @warning compound should be deallocated with mcp_free_type_NbtTagCompound after usage
+ */
+bool mcp_nbt_parse(mcp_type_NbtTagCompound* this, char* data, size_t size);
+
+/**
+ * @brief get the root node of a compound
+ *
+ * @param this the compound
+ *
+ * @return root node, NULL if the compound is empty
+ */
+static inline mcp_type_NbtNode* mcp_nbt_root(mcp_type_NbtTagCompound* this) {
+  return this->nodes;
+}
+
+/**
+ * @brief get the first child of a compound or list node
+ *
+ * @param this the compound
+ * @param node parent node
+ *
+ * @return first child, NULL if the node has no children
+ */
+static inline mcp_type_NbtNode* mcp_nbt_child(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node) {
+  return node->next > (uint32_t) (node - this->nodes) + 1 ? node + 1 : NULL;
+}
+
+/**
+ * @brief get the next child of a parent node
+ *
+ * @param this   the compound
+ * @param parent parent node
+ * @param node   current child
+ *
+ * @return next child, NULL after the last one
+ */
+static inline mcp_type_NbtNode* mcp_nbt_next(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* parent, mcp_type_NbtNode* node) {
+  return node->next < parent->next ? &this->nodes[node->next] : NULL;
+}
+
+/**
+ * @brief find a child of a compound node by its name
+ *
+ * @param this     the compound
+ * @param compound compound node
+ * @param name     child name
+ *
+ * @return the child, NULL if there is none
+ */
+mcp_type_NbtNode* mcp_nbt_find(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* compound, const char* name);
+
+/**
+ * @brief get the name of a node
+ *
+ * @param this the compound
+ * @param node the node
+ */
+static inline string_view_t mcp_nbt_name(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node) {
+  return (string_view_t) { &this->data[node->name], node->name_size };
+}
+
+/**
+ * @brief get the payload of a node
+ *
+ * @param this the compound
+ * @param node the node
+ *
+ * @note array and number list elements are big-endian
+ */
+static inline char* mcp_nbt_value(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node) {
+  return &this->data[node->value];
+}
+
+/**
+ * @brief get the value of a string node
+ *
+ * @param this the compound
+ * @param node the node
+ */
+static inline string_view_t mcp_nbt_string(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node) {
+  return (string_view_t) { mcp_nbt_value(this, node), node->size };
+}
+
+/**
+ * @brief convert a big-endian number to an integer
+ *
+ * @param tag   number tag
+ * @param value number payload
+ */
+static inline int64_t mcp_nbt_number_integer(mcp_type_NbtTag tag, char* value) {
+  switch (tag) {
+    case MCP_NBT_TAG_BYTE:
+      return (int8_t) value[0];
+    case MCP_NBT_TAG_SHORT: {
+      uint16_t number;
+      memcpy(&number, value, sizeof(number));
+      return (int16_t) be16toh(number);
+    }
+    case MCP_NBT_TAG_INT:
+    case MCP_NBT_TAG_FLOAT: {
+      uint32_t number;
+      memcpy(&number, value, sizeof(number));
+      return (int32_t) be32toh(number);
+    }
+    case MCP_NBT_TAG_LONG:
+    case MCP_NBT_TAG_DOUBLE: {
+      uint64_t number;
+      memcpy(&number, value, sizeof(number));
+      return (int64_t) be64toh(number);
+    }
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief get the value of an integer node
+ *
+ * @param this the compound
+ * @param node byte, short, int or long node
+ */
+static inline int64_t mcp_nbt_integer(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node) {
+  if (node->tag == MCP_NBT_TAG_FLOAT || node->tag == MCP_NBT_TAG_DOUBLE) {
+    return 0;
+  }
+  return mcp_nbt_number_integer(node->tag, mcp_nbt_value(this, node));
+}
+
+/**
+ * @brief get the value of a floating point node
+ *
+ * @param this the compound
+ * @param node float or double node, integers are converted
+ */
+static inline double mcp_nbt_number(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node) {
+  int64_t bits = mcp_nbt_number_integer(node->tag, mcp_nbt_value(this, node));
+  if (node->tag == MCP_NBT_TAG_FLOAT) {
+    float number;
+    int32_t single = (int32_t) bits;
+    memcpy(&number, &single, sizeof(number));
+    return number;
+  } else if (node->tag == MCP_NBT_TAG_DOUBLE) {
+    double number;
+    memcpy(&number, &bits, sizeof(number));
+    return number;
+  }
+  return bits;
+}
+
+/**
+ * @brief get an element of an array node or a list of integers
+ *
+ * @param this  the compound
+ * @param node  the node
+ * @param index element index
+ */
+static inline int64_t mcp_nbt_element(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* node, size_t index) {
+  switch (node->tag) {
+    case MCP_NBT_TAG_BYTE_ARRAY:
+      return mcp_nbt_number_integer(MCP_NBT_TAG_BYTE, mcp_nbt_value(this, node) + index);
+    case MCP_NBT_TAG_INT_ARRAY:
+      return mcp_nbt_number_integer(MCP_NBT_TAG_INT, mcp_nbt_value(this, node) + index * 4);
+    case MCP_NBT_TAG_LONG_ARRAY:
+      return mcp_nbt_number_integer(MCP_NBT_TAG_LONG, mcp_nbt_value(this, node) + index * 8);
+    case MCP_NBT_TAG_LIST: {
+      static const uint8_t sizes[] = { 0, 1, 2, 4, 8, 4, 8 };
+      if (node->element == MCP_NBT_TAG_END || node->element > MCP_NBT_TAG_DOUBLE) {
+        return 0;
+      }
+      return mcp_nbt_number_integer(node->element, mcp_nbt_value(this, node) + index * sizes[node->element]);
+    }
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief write the type byte and the name of a tag
+ *
+ * @param dest destination buffer
+ * @param tag  tag type
+ * @param name tag name
+ *
+ * @note a compound is closed with mcp_nbt_write_end,
+ *         an end tag is written without a name
+ * @warning names and string values should not be longer
+ *            than UINT16_MAX bytes, this is asserted
+ */
+void mcp_nbt_write_tag(mcp_buffer_t* dest, mcp_type_NbtTag tag, const char* name);
+
+/**
+ * @brief close a compound
+ *
+ * @param dest destination buffer
+ */
+static inline void mcp_nbt_write_end(mcp_buffer_t* dest) {
+  mcp_encode_byte(MCP_NBT_TAG_END, dest);
+}
+
+/**
+ * @brief write a number tag
+ *
+ * @param dest  destination buffer
+ * @param name  tag name
+ * @param value tag value
+ */
+static inline void mcp_nbt_write_byte(mcp_buffer_t* dest, const char* name, int8_t value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_BYTE, name);
+  mcp_encode_byte(value, dest);
+}
+static inline void mcp_nbt_write_short(mcp_buffer_t* dest, const char* name, int16_t value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_SHORT, name);
+  mcp_encode_be16(value, dest);
+}
+static inline void mcp_nbt_write_int(mcp_buffer_t* dest, const char* name, int32_t value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_INT, name);
+  mcp_encode_be32(value, dest);
+}
+static inline void mcp_nbt_write_long(mcp_buffer_t* dest, const char* name, int64_t value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_LONG, name);
+  mcp_encode_be64(value, dest);
+}
+static inline void mcp_nbt_write_float(mcp_buffer_t* dest, const char* name, float value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_FLOAT, name);
+  mcp_encode_bef32(value, dest);
+}
+static inline void mcp_nbt_write_double(mcp_buffer_t* dest, const char* name, double value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_DOUBLE, name);
+  mcp_encode_bef64(value, dest);
+}
+
+/**
+ * @brief write a string tag
+ *
+ * @param dest  destination buffer
+ * @param name  tag name
+ * @param value null-terminated string
+ */
+void mcp_nbt_write_string(mcp_buffer_t* dest, const char* name, const char* value);
+
+/**
+ * @brief write the header of a list tag
+ *
+ * @param dest    destination buffer
+ * @param name    tag name
+ * @param element element tag type
+ * @param count   number of elements
+ *
+ * @note elements are written after the header without type bytes and names
+ */
+void mcp_nbt_write_list(mcp_buffer_t* dest, const char* name, mcp_type_NbtTag element, int32_t count);
+
+/**
+ * @brief write an array tag
+ *
+ * @param dest   destination buffer
+ * @param name   tag name
+ * @param tag    byte, int or long array tag type
+ * @param values int8_t, int32_t or int64_t values
+ * @param count  number of values
+ */
+void mcp_nbt_write_array(mcp_buffer_t* dest, const char* name, mcp_type_NbtTag tag, void* values, int32_t count);
+
+/**
+ * @brief get the encoded length of a type byte and a tag name
+ *
+ * @param name tag name
+ */
+static inline size_t mcp_nbt_length_tag(const char* name) {
+  return sizeof(uint8_t) + sizeof(uint16_t) + strlen(name);
+}
+
+#endif /* MCP_NBT_H */
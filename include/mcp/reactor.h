@@ -0,0 +1,217 @@
+/**
+ * @file reactor.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief non-blocking event loop for many connections
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_REACTOR_H
+#define MCP_REACTOR_H
+
+    /* includes */
+#include "mcp/connection.h" /* connection context */
+#include "mcp/io/region.h"  /* reusable memory */
+#include <stdbool.h>        /* boolean type */
+
+    /* defines */
+/**
+ * @brief maximum number of events handled by a single iteration
+ */
+#define MCP_REACTOR_EVENTS 256
+
+/**
+ * @brief memory kept by each reactor connection between packets
+ */
+#define MCP_REACTOR_CONTEXT_LIMIT (1 << 14)
+
+    /* typedefs */
+/**
+ * @brief reactor type
+ */
+typedef struct mcp_reactor_t mcp_reactor_t;
+
+/**
+ * @brief reactor backend
+ *
+ * @note MCP_REACTOR_AUTO selects io_uring when the library is built with it
+ *         and the kernel supports it, otherwise epoll
+ */
+typedef enum mcp_reactor_backend_t {
+    MCP_REACTOR_AUTO,
+    MCP_REACTOR_EPOLL,
+    MCP_REACTOR_IO_URING
+} mcp_reactor_backend_t;
+
+/**
+ * @brief connection close callback type
+ *
+ * @note called after the connection is removed from the reactor,
+ *         the callback owns the stream and the context
+ */
+typedef void mcp_reactor_close_t(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief connection accept callback type
+ *
+ * @return initialized connection context for the stream,
+ *           or NULL to reject the connection
+ * @note the stream is closed by the reactor when the connection is rejected
+ */
+typedef mcp_context_t* mcp_reactor_accept_t(mcp_reactor_t* reactor, mcp_stream_t stream);
+
+/**
+ * @brief reactor
+ *
+ * owns non-blocking connections and calls their packet handlers
+ * when whole packets arrive, received data is shared by all connections
+ * and only incomplete frames are copied into the connection
+ *
+ * @note uring is set when the io_uring backend is used, epoll otherwise
+ * @note handlers are assigned to added connections without a handler table,
+ *         metrics to connections without metrics
+ * @note batch holds the epoll events being handled, events of connections
+ *         removed while handling it are cleared, so they are skipped
+ */
+struct mcp_reactor_t {
+    int epoll;
+    void* uring;
+    void* batch;
+    int batch_size;
+    size_t count;
+    mcp_region_t input;
+    mcp_reactor_close_t* close;
+    mcp_stream_t listener;
+    mcp_reactor_accept_t* accept;
+    mcp_handler_table_t* handlers;
+    mcp_metrics_t* metrics;
+};
+
+    /* functions */
+/**
+ * @brief initialize a reactor
+ *
+ * @param reactor pointer to the reactor
+ * @param close   connection close callback
+ *
+ * @return false on failure
+ * @warning reactor should be deallocated with mcp_reactor_free after usage
+ */
+bool mcp_reactor_init(mcp_reactor_t* reactor, mcp_reactor_close_t* close);
+
+/**
+ * @brief initialize a reactor with a specific backend
+ *
+ * @param reactor pointer to the reactor
+ * @param close   connection close callback
+ * @param backend requested backend
+ *
+ * @return false on failure or if the backend is not available
+ * @warning reactor should be deallocated with mcp_reactor_free after usage
+ */
+bool mcp_reactor_init_backend(mcp_reactor_t* reactor, mcp_reactor_close_t* close, mcp_reactor_backend_t backend);
+
+/**
+ * @brief add a connection to a reactor
+ *
+ * @param reactor pointer to the reactor
+ * @param context initialized connection context
+ *
+ * @return false on failure
+ * @note connection stream is switched to non-blocking mode,
+ *         sent packets which could not be written are queued
+ * @note io_uring backend corks the context, its packets are sent
+ *         together after the handlers of the current iteration
+ */
+bool mcp_reactor_add(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief accept connections from a listening stream
+ *
+ * @param reactor pointer to the reactor
+ * @param stream  non-blocking listening stream
+ * @param accept  connection accept callback
+ *
+ * @return false on failure
+ * @note only one listening stream is supported, it is not closed by the reactor
+ */
+bool mcp_reactor_listen(mcp_reactor_t* reactor, mcp_stream_t stream, mcp_reactor_accept_t* accept);
+
+/**
+ * @brief create a connection for an accepted stream and add it to a reactor
+ *
+ * @param reactor pointer to the reactor
+ * @param stream  accepted stream
+ *
+ * @return false if the connection was rejected or could not be added
+ */
+bool mcp_reactor_adopt(mcp_reactor_t* reactor, mcp_stream_t stream);
+
+/**
+ * @brief remove a connection from a reactor without closing it
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ */
+void mcp_reactor_remove(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief send packets queued by a connection outside of its handlers
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ *
+ * @note io_uring backend submits the data on the next mcp_reactor_run,
+ *         epoll backend writes it immediately and closes the connection on failure
+ */
+void mcp_reactor_flush(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief handle data received by a connection
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ * @param src     received data
+ * @param size    number of received bytes
+ *
+ * @return false if the connection should be closed
+ * @note whole frames are handled directly from src,
+ *         only an incomplete frame is copied into the connection input
+ */
+bool mcp_reactor_deliver(mcp_reactor_t* reactor, mcp_context_t* context, char* src, size_t size);
+
+/**
+ * @brief remove a connection and pass it to the close callback
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ *
+ * @note io_uring backend calls the callback once its operations on the connection are finished
+ */
+void mcp_reactor_close(mcp_reactor_t* reactor, mcp_context_t* context);
+
+/**
+ * @brief wait for events and handle them
+ *
+ * @param reactor pointer to the reactor
+ * @param timeout maximum wait time in milliseconds, -1 for infinite
+ *
+ * @return number of handled events, or -1 on failure
+ * @note handlers could close other connections with mcp_reactor_close,
+ *         their remaining events of the iteration are skipped then
+ * @warning handlers should not close or free their own connections,
+ *            connections are freed by the close callback
+ *            after they are removed from the reactor
+ */
+int mcp_reactor_run(mcp_reactor_t* reactor, int timeout);
+
+/**
+ * @brief free a reactor
+ *
+ * @param reactor pointer to the reactor
+ *
+ * @note connections are not closed
+ */
+void mcp_reactor_free(mcp_reactor_t* reactor);
+
+#endif /* MCP_REACTOR_H */
\ No newline at end of file
@@ -0,0 +1,135 @@
+/**
+ * @file shard.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief multi-threaded connection sharding
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_SHARD_H
+#define MCP_SHARD_H
+
+    /* includes */
+#include "mcp/reactor.h"    /* reactor */
+#include "mcp/handler.h"    /* handler tables */
+#include "mcp/io/arena.h"   /* decode memory */
+#include "mcp/metrics.h"    /* packet metrics */
+#include <pthread.h>        /* threads */
+#include <stdatomic.h>      /* running flag */
+#include <stdbool.h>        /* boolean type */
+
+    /* defines */
+/**
+ * @brief maximum time between checks of the running flag in milliseconds
+ */
+#define MCP_SHARD_TIMEOUT 100
+
+    /* typedefs */
+/**
+ * @brief shard group type
+ */
+typedef struct mcp_shard_group_t mcp_shard_group_t;
+
+/**
+ * @brief shard
+ *
+ * worker thread with its own reactor, listening stream and handler table,
+ * connections accepted by a shard are never touched by other threads
+ *
+ * @note reactor is the first member, so reactor callbacks
+ *         could get their shard with mcp_shard_get
+ * @note arena is not used by the shard, accept callbacks could
+ *         assign it to context->buffer.arena to decode packets into it
+ * @note metrics are counted for every connection of the shard
+ *         and could be read by other threads
+ */
+typedef struct mcp_shard_t {
+    mcp_reactor_t reactor;
+    mcp_handler_table_t handlers;
+    mcp_metrics_t metrics;
+    mcp_arena_t arena;
+    mcp_stream_t listener;
+    pthread_t thread;
+    size_t index;
+    mcp_shard_group_t* group;
+    void* user;
+} mcp_shard_t;
+
+/**
+ * @brief shard group
+ *
+ * all shards listen on the same port with SO_REUSEPORT,
+ * so incoming connections are balanced between them by the kernel
+ */
+struct mcp_shard_group_t {
+    mcp_shard_t* shards;
+    size_t count;
+    atomic_bool running;
+    void* user;
+};
+
+    /* functions */
+/**
+ * @brief initialize a shard group
+ *
+ * @param group  pointer to the shard group
+ * @param count  number of shards, 0 for the number of online processors
+ * @param host   local address, NULL for any
+ * @param port   local port
+ * @param accept connection accept callback
+ * @param close  connection close callback
+ *
+ * @return false on failure
+ * @note shard handler tables are copies of the global tables at the moment of the call
+ * @warning shard group should be deallocated with mcp_shard_group_free after usage
+ */
+bool mcp_shard_group_init(mcp_shard_group_t* group, size_t count, const char* host, const char* port,
+                          mcp_reactor_accept_t* accept, mcp_reactor_close_t* close);
+
+/**
+ * @brief start the shard threads
+ *
+ * @param group pointer to the shard group
+ *
+ * @return false if a thread could not be started
+ * @note shard threads are pinned to processors when possible
+ */
+bool mcp_shard_group_start(mcp_shard_group_t* group);
+
+/**
+ * @brief stop the shard threads and wait for them to finish
+ *
+ * @param group pointer to the shard group
+ */
+void mcp_shard_group_stop(mcp_shard_group_t* group);
+
+/**
+ * @brief free a shard group
+ *
+ * @param group pointer to the shard group
+ *
+ * @note connections are not closed
+ */
+void mcp_shard_group_free(mcp_shard_group_t* group);
+
+/**
+ * @brief add metrics of every shard
+ *
+ * @param group    pointer to the shard group
+ * @param snapshot metrics initialized with mcp_metrics_init
+ *
+ * @note shards are not stopped, so the snapshot could miss
+ *         packets handled during the call
+ */
+void mcp_shard_group_metrics(mcp_shard_group_t* group, mcp_metrics_t* snapshot);
+
+/**
+ * @brief get the shard owning a reactor
+ *
+ * @param reactor reactor of a shard
+ */
+static inline mcp_shard_t* mcp_shard_get(mcp_reactor_t* reactor) {
+    return (mcp_shard_t*) reactor;
+}
+
+#endif /* MCP_SHARD_H */
@@ -39,9 +39,21 @@ typedef struct type##_vector_t { \
  */
 typedef char* string_t;
 
+/**
+ * @brief string view type
+ * 
+ * points to the string bytes inside of another buffer,
+ * data is not null-terminated
+ */
+typedef struct string_view_t {
+  char* data;
+  size_t size;
+} string_view_t;
+
 mcp_generic_vector(char)
 mcp_generic_vector(int32_t)
 mcp_generic_optional(string_t)
+mcp_generic_optional(string_view_t)
 mcp_generic_optional(int32_t)
 
       /* typedefs */
@@ -73,12 +85,6 @@ typedef struct mcp_type_Tag {
 } mcp_type_Tag;
 mcp_generic_vector(mcp_type_Tag)
 
-/**
- * @brief nbt tag stub
- */
-typedef void* mcp_type_NbtTagCompound;
-mcp_generic_optional(mcp_type_NbtTagCompound)
-
 /**
  * @brief nbt type enum
  */
@@ -95,14 +101,113 @@ typedef enum mcp_type_NbtTag {
   MCP_NBT_TAG_LIST,
   MCP_NBT_TAG_COMPOUND,
   MCP_NBT_TAG_INT_ARRAY,
-  MCP_NBT_TAG_LONG_ARRAY
+  MCP_NBT_TAG_LONG_ARRAY,
+  MCP_NBT_TAG__MAX
 } mcp_type_NbtTag;
 
+/**
+ * @brief nbt tree node
+ * 
+ * name and value are offsets into the encoded compound, value points
+ * to the big-endian payload, size is the number of children of a compound,
+ * the number of elements of a list or an array and the length of a string,
+ * next is the index of the node after the subtree of this one
+ * 
+ * @note lists of numbers are stored as a single node, like arrays
+ */
+typedef struct mcp_type_NbtNode {
+  uint8_t tag;
+  uint8_t element;
+  uint16_t name_size;
+  uint32_t name;
+  uint32_t value;
+  uint32_t size;
+  uint32_t next;
+} mcp_type_NbtNode;
+
+/**
+ * @brief nbt compound
+ * 
+ * flat tree of the compound, nodes are stored in document order
+ * in a single allocation followed by a copy of the encoded compound,
+ * root node is the first one, compound without nodes is empty
+ */
+typedef struct mcp_type_NbtTagCompound {
+  mcp_type_NbtNode* nodes;
+  size_t count;
+  char* data;
+  size_t size;
+} mcp_type_NbtTagCompound;
+mcp_generic_optional(mcp_type_NbtTagCompound)
+
+/**
+ * @brief entity metadata value type enum
+ * 
+ * @note numbering of 1.13 and later versions,
+ *         the last three types were added in 1.14
+ */
+typedef enum mcp_type_EntityMetadataType {
+  MCP_METADATA_BYTE,
+  MCP_METADATA_VARINT,
+  MCP_METADATA_FLOAT,
+  MCP_METADATA_STRING,
+  MCP_METADATA_CHAT,
+  MCP_METADATA_OPT_CHAT,
+  MCP_METADATA_SLOT,
+  MCP_METADATA_BOOLEAN,
+  MCP_METADATA_ROTATION,
+  MCP_METADATA_POSITION,
+  MCP_METADATA_OPT_POSITION,
+  MCP_METADATA_DIRECTION,
+  MCP_METADATA_OPT_UUID,
+  MCP_METADATA_OPT_BLOCK_ID,
+  MCP_METADATA_NBT,
+  MCP_METADATA_PARTICLE,
+  MCP_METADATA_VILLAGER_DATA,
+  MCP_METADATA_OPT_VARINT,
+  MCP_METADATA_POSE,
+  MCP_METADATA__MAX
+} mcp_type_EntityMetadataType;
+
+/**
+ * @brief entity metadata entry
+ * 
+ * numbers, rotations, positions and uuids are stored inline,
+ * strings, chat, slots, nbt and particles are kept encoded
+ * in the metadata data at the given offset,
+ * present is false only for absent optional values
+ * 
+ * @note optional block ids and varints keep their encoded value, 0 is absent
+ */
+typedef struct mcp_type_EntityMetadataEntry {
+  uint8_t index;
+  uint8_t type;
+  bool present;
+  union {
+    int32_t integer;
+    float number;
+    float rotation[3];
+    int32_t villager[3];
+    mcp_type_Position position;
+    mcp_type_UUID uuid;
+    struct {
+      uint32_t offset;
+      uint32_t size;
+    } data;
+  } value;
+} mcp_type_EntityMetadataEntry;
+
 /**
  * @brief minecraft entity metadata
+ * 
+ * decoded entries are stored in a single allocation
+ * followed by the encoded values they refer to
  */
 typedef struct mcp_type_EntityMetadata {
-  mcp_type_NbtTag* data;
+  mcp_type_EntityMetadataEntry* entries;
+  size_t count;
+  char* data;
+  size_t size;
 } mcp_type_EntityMetadata;
 
 /**
@@ -0,0 +1,139 @@
+/**
+ * @file version.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief protocol versions and packet translation between them
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_VERSION_H
+#define MCP_VERSION_H
+
+    /* includes */
+#include "mcp/connection.h" /* connection context */
+#include "mcp/io/buffer.h"  /* buffered io */
+#include "mcp/io/region.h"  /* translated packet memory */
+#include <stdbool.h>        /* boolean type */
+
+    /* typedefs */
+/**
+ * @brief packet translation mode
+ *
+ * @note dropped packets have no counterpart in the other version
+ *         or could not be translated without decoding them,
+ *         including packets with fields encoded differently by the versions,
+ *         raw packets have the same layout and only their id is replaced,
+ *         encoded packets are rebuilt from the fields of the source packet
+ */
+typedef enum mcp_translation_mode_t {
+    MCP_TRANSLATION_DROP,
+    MCP_TRANSLATION_RAW,
+    MCP_TRANSLATION_ENCODE
+} mcp_translation_mode_t;
+
+/**
+ * @brief generated packet translator type
+ *
+ * @note src is positioned after the packet id, the translated packet
+ *         is encoded into dest with its id after mcp_buffer_begin
+ */
+typedef bool mcp_translate_t(mcp_buffer_t* src, mcp_buffer_t* dest);
+
+/**
+ * @brief translation of a packet to the other version
+ */
+typedef struct mcp_translation_t {
+    mcp_translation_mode_t mode;
+    mcp_packet_id_t id;
+    mcp_translate_t* translate;
+} mcp_translation_t;
+
+/**
+ * @brief generated protocol version descriptor
+ *
+ * @note inbound tables are indexed by packet ids of this version
+ *         and translate to the library version, outbound tables are indexed
+ *         by library packet ids and translate to this version,
+ *         both are NULL for the library version itself
+ */
+struct mcp_protocol_t {
+    const char* name;
+    int version;
+    mcp_packet_id_t max_ids[MCP_STATE__MAX][MCP_SOURCE__MAX];
+    const mcp_translation_t* inbound[MCP_STATE__MAX][MCP_SOURCE__MAX];
+    const mcp_translation_t* outbound[MCP_STATE__MAX][MCP_SOURCE__MAX];
+};
+
+    /* variables */
+/**
+ * @brief generated versions, the library version first, terminated with NULL
+ */
+extern const mcp_protocol_t* const mcp_protocols[];
+
+    /* functions */
+/**
+ * @brief find a generated version
+ *
+ * @param version protocol version number
+ *
+ * @return version descriptor, or NULL if the version is not generated
+ */
+const mcp_protocol_t* mcp_version_find(int version);
+
+/**
+ * @brief set the protocol version spoken on the stream of a connection
+ *
+ * @param context connection context
+ * @param version protocol version number
+ *
+ * @return false if the version is not generated, the context is not changed then
+ */
+bool mcp_version_select(mcp_context_t* context, int version);
+
+/**
+ * @brief select the version of a connection from its handshake packet
+ *
+ * @param context connection context with a received handshake packet in its buffer
+ *
+ * @note called by the receive functions for the first handshake packet
+ *         when no version is selected, unknown versions are left unselected
+ */
+void mcp_version_handshake(mcp_context_t* context);
+
+/**
+ * @brief get the protocol version spoken on the stream of a connection
+ *
+ * @param context connection context
+ */
+static inline const mcp_protocol_t* mcp_version_get(mcp_context_t* context) {
+    return context->protocol != NULL ? context->protocol : mcp_protocols[0];
+}
+
+/**
+ * @brief check if packets of a connection are translated
+ *
+ * @param context connection context
+ */
+static inline bool mcp_version_translated(mcp_context_t* context) {
+    return context->protocol != NULL && context->protocol != mcp_protocols[0];
+}
+
+/**
+ * @brief translate a packet
+ *
+ * @param translation translation of the packet, not dropped
+ * @param packet      buffer with the packet from its id, positioned after the id
+ * @param region      memory for the translated packet
+ *
+ * @return false if the packet is malformed, which is the only failure,
+ *           the buffer is marked as failed by the generated translator then
+ * @warning dropped translations should be handled by the caller,
+ *            they are not checked here
+ * @note the buffer is set to the translated packet and positioned after its id,
+ *         the packet is written into the region after MCP_BUFFER_HEADROOM bytes,
+ *         so it could be sent from there, the source packet is never modified
+ *         and a raw packet which keeps its id is not copied
+ */
+bool mcp_version_translate(const mcp_translation_t* translation, mcp_buffer_t* packet, mcp_region_t* region);
+
+#endif /* MCP_VERSION_H */
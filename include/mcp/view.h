@@ -0,0 +1,86 @@
+/**
+ * @file view.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief lazy access to packet fields
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_VIEW_H
+#define MCP_VIEW_H
+
+    /* includes */
+#include "mcp/io/buffer.h" /* buffered io */
+#include <stdbool.h>       /* boolean type */
+#include <stdint.h>        /* integer types */
+
+    /* defines */
+/**
+ * @brief maximum number of top level fields of a packet with a view
+ */
+#define MCP_VIEW_MAX_FIELDS 64
+
+    /* typedefs */
+/**
+ * @brief lazy packet view
+ *
+ * fields are located by skipping the previous ones and decoded
+ * only when they are requested, field offsets are remembered,
+ * so every field is scanned at most once
+ *
+ * @note fields which are referenced by later fields (switch keys,
+ *         array counts) are always decoded while scanning
+ * @note view reads the source buffer data, so it is valid
+ *         only as long as the buffer is
+ * @note a field past the end of the packet is left zeroed
+ *         and marks the view source as malformed
+ */
+typedef struct mcp_view_t mcp_view_t;
+
+/**
+ * @brief generated field scanner
+ *
+ * @param view   pointer to the view
+ * @param field  field index
+ * @param decode decode the field instead of skipping it
+ *
+ * @note view source index is set to the field offset before the call
+ */
+typedef void mcp_view_scan_t(mcp_view_t* view, size_t field, bool decode);
+
+struct mcp_view_t {
+    mcp_buffer_t src;
+    mcp_view_scan_t* scan;
+    uint64_t eager;
+    uint64_t decoded;
+    size_t scanned;
+    uint32_t offsets[MCP_VIEW_MAX_FIELDS + 1];
+};
+
+    /* functions */
+/**
+ * @brief initialize a view over a packet
+ *
+ * @param view  pointer to the view
+ * @param src   buffer positioned at the first packet field
+ * @param scan  generated field scanner
+ * @param eager mask of the fields decoded while scanning
+ */
+static inline void mcp_view_init(mcp_view_t* view, mcp_buffer_t* src, mcp_view_scan_t* scan, uint64_t eager) {
+    view->src = *src;
+    view->scan = scan;
+    view->eager = eager;
+    view->decoded = 0;
+    view->scanned = 0;
+    view->offsets[0] = src->index;
+}
+
+/**
+ * @brief decode a packet field if it is not decoded yet
+ *
+ * @param view  pointer to the view
+ * @param field field index
+ */
+void mcp_view_field(mcp_view_t* view, size_t field);
+
+#endif /* MCP_VIEW_H */
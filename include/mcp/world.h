@@ -0,0 +1,279 @@
+/**
+ * @file world.h
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief world state cache kept current from chunk and block packets
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* header guard */
+#ifndef MCP_WORLD_H
+#define MCP_WORLD_H
+
+    /* includes */
+#include "mcp/chunk.h"    /* chunk sections */
+#include "mcp/protocol.h" /* block and chunk packets */
+#include "mcp/type.h"     /* position type */
+#include <endian.h>       /* byte swap */
+#include <stdbool.h>      /* boolean type */
+#include <stdint.h>       /* integer types */
+
+    /* defines */
+/**
+ * @brief number of biome ids of a column
+ */
+#define MCP_WORLD_BIOMES 1024
+
+    /* typedefs */
+/**
+ * @brief paletted section storage
+ *
+ * uniform sections keep their state without data,
+ * others keep 4 or 8 bit palette indices or 16 bit states
+ * in big-endian longs, followed by the palette in one allocation
+ *
+ * @note states never span longs, so the data matches
+ *         the network layout of the same bits
+ */
+typedef struct mcp_world_section_t {
+  uint64_t* data;
+  int32_t* palette;
+  uint16_t size;
+  uint16_t value;
+  uint8_t bits;
+} mcp_world_section_t;
+
+/**
+ * @brief cached column
+ *
+ * @note biomes are NULL if they were never received
+ */
+typedef struct mcp_world_column_t {
+  int32_t x;
+  int32_t z;
+  mcp_world_section_t sections[MCP_CHUNK_SECTIONS];
+  int32_t* biomes;
+} mcp_world_column_t;
+
+/**
+ * @brief column table entry, empty if column is NULL
+ */
+typedef struct mcp_world_entry_t {
+  uint64_t key;
+  mcp_world_column_t* column;
+} mcp_world_entry_t;
+
+/**
+ * @brief world state cache
+ *
+ * open addressing table of columns keyed by their position,
+ * scratch is a dense column used for chunk conversion
+ */
+typedef struct mcp_world_t {
+  mcp_world_entry_t* entries;
+  size_t capacity;
+  size_t count;
+  unsigned shift;
+  mcp_chunk_column_t* scratch;
+} mcp_world_t;
+
+    /* functions */
+/**
+ * @brief initialize a world
+ *
+ * @param world pointer to the world
+ *
+ * @warning world should be deallocated with mcp_world_free after usage
+ */
+void mcp_world_init(mcp_world_t* world);
+
+/**
+ * @brief free a world and its columns
+ *
+ * @param world pointer to the world
+ */
+void mcp_world_free(mcp_world_t* world);
+
+/**
+ * @brief find a column
+ *
+ * @param world pointer to the world
+ * @param x     column x coordinate
+ * @param z     column z coordinate
+ *
+ * @return the column, NULL if it is not loaded
+ */
+mcp_world_column_t* mcp_world_find(mcp_world_t* world, int32_t x, int32_t z);
+
+/**
+ * @brief find a column, loading an empty one if there is none
+ *
+ * @param world pointer to the world
+ * @param x     column x coordinate
+ * @param z     column z coordinate
+ */
+mcp_world_column_t* mcp_world_load(mcp_world_t* world, int32_t x, int32_t z);
+
+/**
+ * @brief unload a column
+ *
+ * @param world pointer to the world
+ * @param x     column x coordinate
+ * @param z     column z coordinate
+ */
+void mcp_world_unload(mcp_world_t* world, int32_t x, int32_t z);
+
+/**
+ * @brief get the index of a block in its section
+ *
+ * @param position block position
+ */
+static inline size_t mcp_world_index(mcp_type_Position* position) {
+  return (position->y & 15) << 8 | (position->z & 15) << 4 | (position->x & 15);
+}
+
+/**
+ * @brief get a state of a section
+ *
+ * @param section the section
+ * @param index   block index
+ */
+static inline uint16_t mcp_world_section_get(mcp_world_section_t* section, size_t index) {
+  if (section->bits == 0) {
+    return section->value;
+  }
+  size_t bit = index * section->bits;
+  uint64_t word = be64toh(section->data[bit >> 6]);
+  uint32_t value = (word >> (bit & 63)) & ((1u << section->bits) - 1);
+  return section->palette != NULL ? section->palette[value] : value;
+}
+
+/**
+ * @brief set a state of a section
+ *
+ * @param section the section
+ * @param index   block index
+ * @param state   block state
+ *
+ * @note storage grows when the palette is full
+ */
+void mcp_world_section_set(mcp_world_section_t* section, size_t index, uint16_t state);
+
+/**
+ * @brief replace the states of a section
+ *
+ * @param section the section
+ * @param blocks  MCP_CHUNK_SECTION_BLOCKS states
+ */
+void mcp_world_section_store(mcp_world_section_t* section, const uint16_t* blocks);
+
+/**
+ * @brief expand the states of a section
+ *
+ * @param section the section
+ * @param blocks  destination of MCP_CHUNK_SECTION_BLOCKS states
+ */
+void mcp_world_section_load(mcp_world_section_t* section, uint16_t* blocks);
+
+/**
+ * @brief free a section, leaving it filled with air
+ *
+ * @param section the section
+ */
+void mcp_world_section_free(mcp_world_section_t* section);
+
+/**
+ * @brief get a block state
+ *
+ * @param world    pointer to the world
+ * @param position block position
+ *
+ * @return block state, air if the column is not loaded
+ */
+uint16_t mcp_world_get_block(mcp_world_t* world, mcp_type_Position* position);
+
+/**
+ * @brief set a block state
+ *
+ * @param world    pointer to the world
+ * @param position block position
+ * @param state    block state
+ *
+ * @return false if the column is not loaded or y is out of the world
+ */
+bool mcp_world_set_block(mcp_world_t* world, mcp_type_Position* position, uint16_t state);
+
+/**
+ * @brief apply chunk data to a column
+ *
+ * @param world     pointer to the world
+ * @param x         column x coordinate
+ * @param z         column z coordinate
+ * @param data      chunk data
+ * @param size      data size
+ * @param mask      primary bit mask of sent sections
+ * @param full      column is full, unsent sections are cleared
+ * @param sky_light sections have sky light
+ * @param format    chunk data format
+ *
+ * @return false if the data is malformed
+ * @note light arrays and biomes of the chunk data are not cached
+ */
+bool mcp_world_apply_chunk(mcp_world_t* world, int32_t x, int32_t z, char* data, size_t size, uint16_t mask, bool full, bool sky_light, mcp_chunk_format_t* format);
+
+/**
+ * @brief expand a column into a dense one
+ *
+ * @param column source column
+ * @param dest   destination column, sections with blocks are set in its mask
+ */
+void mcp_world_export(mcp_world_column_t* column, mcp_chunk_column_t* dest);
+
+/**
+ * @brief apply a block change packet
+ *
+ * @param world  pointer to the world
+ * @param packet the packet
+ *
+ * @return false if the column is not loaded
+ */
+bool mcp_world_apply_block_change(mcp_world_t* world, mcp_packet_server_BlockChange* packet);
+
+#if MCP_PROTOCOL_VERSION >= 751
+/**
+ * @brief apply a multi block change packet
+ *
+ * @param world  pointer to the world
+ * @param packet the packet
+ *
+ * @return false if the column is not loaded
+ */
+bool mcp_world_apply_multi_block_change(mcp_world_t* world, mcp_packet_server_MultiBlockChange* packet);
+
+/**
+ * @brief apply a map chunk packet
+ *
+ * @param world  pointer to the world
+ * @param packet the packet
+ *
+ * @return false if the chunk data is malformed
+ * @note biomes of a full column are cached
+ */
+bool mcp_world_apply_map_chunk(mcp_world_t* world, mcp_packet_server_MapChunk* packet);
+
+/**
+ * @brief create a map chunk packet from a cached column
+ *
+ * @param world  pointer to the world
+ * @param x      column x coordinate
+ * @param z      column z coordinate
+ * @param packet destination packet
+ * @param data   buffer holding the chunk data, could be reused between packets
+ *
+ * @return false if the column is not loaded
+ * @note column is sent full if its biomes are known
+ * @warning packet should be deallocated with mcp_free_packet_server_MapChunk after usage
+ */
+bool mcp_world_create_packet(mcp_world_t* world, int32_t x, int32_t z, mcp_packet_server_MapChunk* packet, mcp_buffer_t* data);
+#endif /* MCP_PROTOCOL_VERSION */
+
+#endif /* MCP_WORLD_H */
@@ -9,11 +9,19 @@
 
 from functools import reduce
 import minecraft_data
+import json
 import re
 import os
 
 indent = "  "
 
+# MCP_STRING_VIEWS=1 decodes strings as views into the receive buffer
+string_views = os.environ.get("MCP_STRING_VIEWS", "0") not in ("", "0")
+
+# MCP_VERSIONS=1.15.2,1.12.2 generates translation of these versions
+# to and from the MCP_MC version
+extra_versions = [v for v in os.environ.get("MCP_VERSIONS", "").split(",") if v]
+
 mcd_type_map = {}
 type_pre_definitions = dict(
     char_vector_t="",
@@ -22,6 +30,7 @@ type_pre_definitions = dict(
     mcp_type_Tag_vector_t="",
     mcp_type_Item_vector_t="",
     string_t_optional_t="",
+    string_view_t_optional_t="",
     mcp_type_NbtTagCompound_optional_t="",
     int32_t_optional_t="",
     mcp_type_UUID_optional_t="",
@@ -31,6 +40,7 @@ type_definitions = type_pre_definitions.copy()
 length_functions = dict()
 packet_length_variable = "_this_packet_length"
 packet_tmp_variable = "_this_tmp_variable"
+view_max_fields = 64
 
 
 def mc_data_name(typename):
@@ -40,6 +50,12 @@ def mc_data_name(typename):
 
     return inner
 
+def string_compare(comp, case):
+    if string_views:
+        return f"mcp_string_view_equals(&{comp}, {case})"
+    # Strings are NULL when they did not fit into the buffer
+    return f"{comp} != NULL && !strcmp({comp}, {case})"
+
 def remove_prefix(string):
     if string.startswith("mcp_"):
         return string[4:]
@@ -67,6 +83,84 @@ def varnum_length(varnum):
     return 10
 
 
+# Packet samples are synthetic encodings used by the benchmarks. Every number
+# is zero, strings hold sample_string, prefixed arrays hold sample_count
+# elements, optionals are present and switches take the branch of a zero
+sample_string = b"sample"
+sample_count = 2
+sample_particles = []
+
+def sample_varint(value):
+    ret = []
+    while value >= 0x80:
+        ret.append((value & 0x7F) | 0x80)
+        value >>= 7
+    ret.append(value)
+    return ret
+
+def sample_number(count_type, value):
+    if count_type in (mc_varint, mc_varlong):
+        return sample_varint(value)
+    return list(value.to_bytes(count_type.size, "big"))
+
+def sample_str():
+    return [*sample_varint(len(sample_string)), *sample_string]
+
+# Compound with a single int tag
+def sample_nbt():
+    return [0x0A, 0, 0, 0x03, 0, 1, ord("a"), 0, 0, 0, 1, 0]
+
+def sample_slot():
+    return [1, 1, 1, *sample_nbt()]
+
+def sample_fields(fields):
+    ret = []
+    for field in fields:
+        sample = field.sample()
+        if sample is None:
+            return None
+        ret.extend(sample)
+    return ret
+
+
+# Decoders never read past the buffer. Fields of a fixed size are decoded
+# without checks, so the buffer is checked once before a run of them, every
+# other field checks the buffer itself. The check before a run covers the
+# minimum size of the rest of the fields, so the first one of a packet is
+# its minimum length. A failed check marks the buffer and returns, leaving
+# the rest of the packet zeroed
+def buffer_check(size):
+    return (
+        f"if (!mcp_buffer_check(src, {size})) {{",
+        f"{indent}return;",
+        "}"
+    )
+
+def count_check(name, size):
+    return (
+        f"if (!mcp_buffer_check_count(src, {name}.size, {size})) {{",
+        f"{indent}{name}.size = 0;",
+        f"{indent}{name}.data = NULL;",
+        f"{indent}return;",
+        "}"
+    )
+
+def decode_fields(fields, decoder=lambda field: field.decoder()):
+    ret = []
+    covered = 0
+    for index, field in enumerate(fields):
+        size = field.fixed_size()
+        if size is None:
+            covered = 0
+        else:
+            if size > covered:
+                covered = sum(f.min_size() for f in fields[index:])
+                ret.extend(buffer_check(covered))
+            covered -= size
+        ret.extend(decoder(field))
+    return ret
+
+
 # MCD/Protodef has two elements of note, "fields" and "types"
 # "Fields" are JSON objects with the following members:
 #   * "name" (optional): Name of the field
@@ -155,6 +249,37 @@ class generic_type:
             f"mcp_decode_{self.postfix}(&{self.name}, src);"
         )
 
+    # Lines that move src past the field without decoding it,
+    # None if the field has to be decoded to find its end
+    def skipper(self):
+        return None
+
+    # Encoded size of the field if it is always the same, None otherwise
+    def fixed_size(self):
+        return None
+
+    # Lower bound of the encoded size of the field
+    def min_size(self):
+        return 0
+
+    # Lines that store and load the field at a fixed offset of out and in,
+    # None if the field can not be accessed at a fixed offset
+    def put(self, offset):
+        return None
+
+    def get(self, offset):
+        return None
+
+    # Lines that store a field of a varying size at an offset of out and move
+    # out past it, None if the field can not be stored without a buffer
+    def put_varying(self, offset):
+        return None
+
+    # Synthetic encoding of the field as a list of bytes,
+    # None if the field has no working decoder
+    def sample(self):
+        return None
+
     # This comes up enough to write some dedicated functions for it
     # Conglomerate types take one of two approaches to fundamental types:
     # * Set the field name _every_ time prior to decl/enc/dec
@@ -196,6 +321,26 @@ class numeric_type(simple_type):
     def encoder(self):
         return f"mcp_encode_{self.postfix}({self.name}, dest);",
 
+    def skipper(self):
+        if self.size == 0:
+            return None
+        return f"mcp_buffer_skip(src, {self.size});",
+
+    def fixed_size(self):
+        return self.size
+
+    def min_size(self):
+        return self.size
+
+    def put(self, offset):
+        return f"mcp_put_{self.postfix}(&out[{offset}], {self.name});",
+
+    def get(self, offset):
+        return f"{self.name} = mcp_get_{self.postfix}(&in[{offset}]);",
+
+    def sample(self):
+        return [0] * self.size
+
 # These exist because MCD switches use them. I hate MCD switches
 @mc_data_name("void")
 class void_type(numeric_type):
@@ -219,6 +364,12 @@ class void_type(numeric_type):
     def decoder(self):
         return f"/* '{self.name}' is a void type */",
 
+    def put(self, offset):
+        return ()
+
+    def get(self, offset):
+        return ()
+
 
 @mc_data_name("u8")
 class num_u8(numeric_type):
@@ -308,6 +459,12 @@ class num_position(num_u64):
     def length(self, variable):
         return f"mcp_length_type_Position(&{self.name}, {variable});",
 
+    def put(self, offset):
+        return f"mcp_put_{self.postfix}(&out[{offset}], &{self.name});",
+
+    def get(self, offset):
+        return f"mcp_get_{self.postfix}(&{self.name}, &in[{offset}]);",
+
 
 @mc_data_name("UUID")
 class num_uuid(numeric_type):
@@ -318,6 +475,12 @@ class num_uuid(numeric_type):
     def encoder(self):
         return f"mcp_encode_{self.postfix}(&{self.name}, dest);",
 
+    def put(self, offset):
+        return f"mcp_put_{self.postfix}(&out[{offset}], &{self.name});",
+
+    def get(self, offset):
+        return f"mcp_get_{self.postfix}(&{self.name}, &in[{offset}]);",
+
 @mc_data_name("varint")
 class mc_varint(numeric_type):
     # typename = "std::int32_t"
@@ -332,31 +495,94 @@ class mc_varint(numeric_type):
     def decoder(self):
         return f"{self.name} = mcp_decode_{self.postfix}(src);",
 
+    def skipper(self):
+        return "mcp_skip_varint(src);",
+
+    def fixed_size(self):
+        return None
+
+    def put(self, offset):
+        return None
+
+    def get(self, offset):
+        return None
+
+    def put_varying(self, offset):
+        if offset == 0:
+            return f"out += mcp_put_varint(out, (uint32_t) {self.name});",
+        return f"out += {offset} + mcp_put_varint(&out[{offset}], (uint32_t) {self.name});",
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return [0]
+
 
 @mc_data_name("varlong")
 class mc_varlong(numeric_type):
     typename = "int64_t"
-    # Decoding varlongs is the same as decoding varints
-    postfix = "varint"
+    postfix = "varlong"
     
     def length(self, variable):
         return f"*{variable} += mcp_length_varlong({self.name});",
 
+    def decoder(self):
+        return f"{self.name} = mcp_decode_{self.postfix}(src);",
+
+    def skipper(self):
+        return "mcp_skip_varint(src);",
+
+    def fixed_size(self):
+        return None
+
+    def put(self, offset):
+        return None
+
+    def get(self, offset):
+        return None
+
+    def put_varying(self, offset):
+        if offset == 0:
+            return f"out += mcp_put_{self.postfix}(out, {self.name});",
+        return f"out += {offset} + mcp_put_{self.postfix}(&out[{offset}], {self.name});",
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return [0]
+
 
 @mc_data_name("string")
 class mc_string(simple_type):
-    typename = "string_t"
-    postfix = "string"
+    typename = "string_view_t" if string_views else "string_t"
+    postfix = "string_view" if string_views else "string"
 
     def encoder(self):
+        if string_views:
+            return f"mcp_encode_{self.postfix}(&{self.name}, dest);",
         return f"mcp_encode_{self.postfix}({self.name}, dest);",
     
     def length(self, variable):
-        return f"mcp_length_string({self.name}, {variable});",
+        if string_views:
+            return f"mcp_length_{self.postfix}(&{self.name}, {variable});",
+        return f"mcp_length_{self.postfix}({self.name}, {variable});",
     
     def free(self):
+        if string_views:
+            return ()
         return f"mcp_free_{self.postfix}(&{self.name});",
 
+    def skipper(self):
+        return "mcp_skip_string(src);",
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return sample_str()
+
 
 @mc_data_name("buffer")
 class mc_buffer(simple_type):
@@ -381,10 +607,21 @@ class mc_buffer(simple_type):
 
     def decoder(self):
         return (
-            *self.count(f'{self.name}.size', self).decoder(),
+            *decode_fields([self.count(f'{self.name}.size', self)]),
             f"mcp_decode_buffer(&{self.name}, src);",
         )
 
+    def skipper(self):
+        if self.count is not mc_varint:
+            return None
+        return "mcp_buffer_skip(src, mcp_decode_varint(src));",
+
+    def min_size(self):
+        return self.count("", self).min_size()
+
+    def sample(self):
+        return [*sample_number(self.count, 8), *range(8)]
+
 
 @mc_data_name("restBuffer")
 class mc_rest_buffer(simple_type):
@@ -403,19 +640,38 @@ class mc_rest_buffer(simple_type):
             f"mcp_decode_buffer(&{self.name}, src);",
         )
 
+    def skipper(self):
+        return "src->index = src->size;",
+
+    def sample(self):
+        return list(range(16))
+
 
 @mc_data_name("nbt")
 class mc_nbt(simple_type):
     typename = "mcp_type_NbtTagCompound"
+    postfix = "type_NbtTagCompound"
     
     def length(self, variable):
-        return f"/* todo nbt length */",
+        return f"mcp_length_{self.postfix}(&{self.name}, {variable});",
 
     def encoder(self):
-        return f"mcp_encode_type_NbtTagCompound(&{self.name}, dest);", 
+        return f"mcp_encode_{self.postfix}(&{self.name}, dest);", 
 
     def decoder(self):
-        return f"mcp_decode_type_NbtTagCompound(&{self.name}, src);",
+        return f"mcp_decode_{self.postfix}(&{self.name}, src);",
+
+    def free(self):
+        return f"mcp_free_{self.postfix}(&{self.name});",
+
+    def skipper(self):
+        return f"mcp_skip_{self.postfix}(src);",
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return sample_nbt()
 
 
 @mc_data_name("optionalNbt")
@@ -423,7 +679,13 @@ class mc_optional_nbt(simple_type):
     typename = "mcp_type_NbtTagCompound_optional_t"
     
     def length(self, variable):
-        return f"/* todo nbt length */",
+        return (
+            f"if ({self.name}.has_value) {{",
+            f"{indent}mcp_length_type_NbtTagCompound(&{self.name}.value, {variable});",
+            f"}} else {{",
+            f"{indent}*{variable} += sizeof(uint8_t);",
+            "}"
+        )
 
     def encoder(self):
         return (
@@ -437,18 +699,52 @@ class mc_optional_nbt(simple_type):
 
     def decoder(self):
         return (
-            f"mcp_decode_byte(&{packet_tmp_variable}, src);"
-            f"if ({packet_tmp_variable} == MCP_NBT_TAG_COMPOUND) {{",
-            f"{indent}{self.name}.has_value = true;",
+            *buffer_check(1),
+            f"mcp_decode_byte(&{packet_tmp_variable}, src);",
+            f"{self.name}.has_value = {packet_tmp_variable} == MCP_NBT_TAG_COMPOUND;",
+            f"if ({self.name}.has_value) {{",
             f"{indent}mcp_read_type_NbtTagCompound(&{self.name}.value, src);",
+            f"}} else if ({packet_tmp_variable} != MCP_NBT_TAG_END) {{",
+            f"{indent}mcp_buffer_fail(src);",
+            "}"
+        )
+
+    def free(self):
+        return (
+            f"if ({self.name}.has_value) {{",
+            f"{indent}mcp_free_type_NbtTagCompound(&{self.name}.value);",
             "}"
         )
 
+    def skipper(self):
+        return "mcp_skip_type_NbtTagCompound(src);",
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return sample_nbt()
+
 @mc_data_name("slot")
 class mc_slot(simple_type):
     typename = "mcp_type_Slot"
     postfix = "type_Slot"
 
+    def length(self, variable):
+        return f"mcp_length_{self.postfix}(&{self.name}, {variable});",
+
+    def free(self):
+        return f"mcp_free_{self.postfix}(&{self.name});",
+
+    def skipper(self):
+        return f"mcp_skip_{self.postfix}(src);",
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return sample_slot()
+
 
 @mc_data_name("minecraft_smelting_format")
 class mc_smelting(simple_type):
@@ -458,6 +754,13 @@ class mc_smelting(simple_type):
     def free(self):
         return f"mcp_free_{self.postfix}(&{self.name});",
 
+    # Group, ingredient count, result, experience and cook time
+    def min_size(self):
+        return 1 + 1 + 1 + 4 + 1
+
+    def sample(self):
+        return [*sample_str(), 1, *sample_slot(), *sample_slot(), 0, 0, 0, 0, 0]
+
 
 @mc_data_name("entityMetadata")
 class mc_metadata(simple_type):
@@ -467,6 +770,19 @@ class mc_metadata(simple_type):
     def length(self, variable):
         return f"mcp_length_type_EntityMetadata(&{self.name}, {variable});",
 
+    def free(self):
+        return f"mcp_free_{self.postfix}(&{self.name});",
+
+    def skipper(self):
+        return f"mcp_skip_{self.postfix}(src);",
+
+    def min_size(self):
+        return 1
+
+    # A byte entry and a varint entry
+    def sample(self):
+        return [0, 0, 0, 1, 1, 5, 0xFF]
+
 
 # This is not how topBitSetTerminatedArray works, but the real solution is hard
 # and this solution is easy. As long as this type is only found in the Entity
@@ -491,9 +807,23 @@ class mc_particle(simple_type):
     def length(self, variable):
         return f"mcp_length_type_Particle(&{self.name}, {variable});",
 
+    def free(self):
+        return f"mcp_free_{self.postfix}(&{self.name});",
+
     def decoder(self):
         return f"mcp_decode_{self.postfix}(&{self.name}, (mcp_type_ParticleType) this->{self.id_field}, src);",
 
+    # The particle id is zero, so the data is the one of the first particle
+    def sample(self):
+        first = sample_particles[0] if sample_particles else ""
+        if first in ("blockdust", "block", "fallingdust", "falling_dust"):
+            return [0]
+        if first in ("reddust", "dust"):
+            return [0] * 16
+        if first in ("iconcrack", "item"):
+            return sample_slot()
+        return []
+
 
 class vector_type(simple_type):
     element = ""
@@ -543,22 +873,33 @@ class vector_type(simple_type):
 
     def decoder(self):
         iterator = f"i{self.depth}"
+        allocate = "mcp_buffer_decode_allocate_zeroed" if self.should_free_element else "mcp_buffer_decode_allocate"
         return (
             *self.count(f"{self.name}.size", self).decoder(),
-            f"{self.name}.data = malloc({self.name}.size * sizeof({self.element}));",
+            *count_check(self.name, 1),
+            f"{self.name}.data = {allocate}(src, {self.name}.size * sizeof({self.element}));",
             f"for (size_t {iterator} = 0; {iterator} < {self.name}.size; {iterator}++) {{",
             f"{indent}mcp_decode_{self.element_postfix}(&{self.name}.data[{iterator}], src);",
             "}"
         )
 
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        return [*sample_varint(sample_count), *self.element_sample() * sample_count]
+
 
 @mc_data_name("ingredient")
 class mc_ingredient(vector_type):
     element = "mcp_type_Slot"
     element_postfix = "type_Slot"
-    should_free_element = False
+    should_free_element = True
     typename = "mcp_type_Slot_vector_t"
 
+    def element_sample(self):
+        return sample_slot()
+
 
 @mc_data_name("tags")
 class mc_tags(vector_type):
@@ -567,6 +908,9 @@ class mc_tags(vector_type):
     should_free_element = True
     typename = "mcp_type_Tag_vector_t"
 
+    def element_sample(self):
+        return [*sample_str(), 2, 0, 0]
+
 
 @mc_data_name("option")
 class mc_option(simple_type):
@@ -631,6 +975,7 @@ class mc_option(simple_type):
 
     def decoder(self):
         ret = [
+            *buffer_check(1),
             f"mcp_decode_byte((uint8_t*) &{packet_tmp_variable}, src);",
             f"if ({packet_tmp_variable} == true) {{"
         ]
@@ -639,13 +984,42 @@ class mc_option(simple_type):
             self.field.temp_name(self.name)
         ret.append(f"{indent}{self.name}.has_value = true;")
         self.field.temp_name(f"{self.name}.value")
-        ret.extend(indent + line for line in self.field.decoder())
+        ret.extend(indent + line for line in decode_fields([self.field]))
         self.field.reset_name()
         ret.append("}")
         return ret
 
+    def skipper(self):
+        field_skip_code = self.field.skipper()
+        if field_skip_code is None:
+            return None
+        return (
+            "mcp_buffer_skip(src, 1);",
+            "if (!src->failed && src->data[src->index - 1]) {",
+            *(indent + line for line in field_skip_code),
+            "}"
+        )
+
+    def min_size(self):
+        return 1
+
+    def sample(self):
+        field_sample = self.field.sample()
+        if field_sample is None:
+            return None
+        return [1, *field_sample]
+
 
 class complex_type(generic_type):
+    def fixed_size(self):
+        sizes = [field.fixed_size() for field in self.fields]
+        if None in sizes:
+            return None
+        return sum(sizes)
+
+    def min_size(self):
+        return sum(field.min_size() for field in self.fields)
+
     def length(self, variable):
         ret = []
         for field in self.fields:
@@ -771,6 +1145,15 @@ class mc_bitfield(complex_type):
         self.storage = lookup_unsigned[total](f"{name}_", self)
         self.size = total // 8
 
+    def fixed_size(self):
+        return self.size
+
+    def min_size(self):
+        return self.size
+
+    def sample(self):
+        return [0] * self.size
+
     def length(self, variable):
         return f"*{variable} += sizeof({self.storage.typename});",
 
@@ -914,19 +1297,24 @@ class mc_switch(simple_type):
             suffix = ""
         else:
             suffix = "."
-        for field in fields:
+        def code(field):
             if has_name:
                 field.temp_name(f"{self.parent.name}{suffix}{field.name}")
             if mode == 0:
-                ret.extend(f"{indent}{l}" for l in field.encoder())
+                lines = list(field.encoder())
             elif mode == 1:
-                ret.extend(f"{indent}{l}" for l in field.decoder())
+                lines = list(field.decoder())
             elif mode == 2:
-                ret.extend(f"{indent}{l}" for l in field.length(variable))
+                lines = list(field.length(variable))
             elif mode == 3:
-                ret.extend(f"{indent}{l}" for l in field.free())
+                lines = list(field.free())
             if has_name:
                 field.reset_name()
+            return lines
+        if mode == 1:
+            ret.extend(f"{indent}{l}" for l in decode_fields(fields, code))
+        else:
+            ret.extend(f"{indent}{l}" for field in fields for l in code(field))
         return ret
 
     def inverse(self, comp, mode, variable=None):
@@ -951,7 +1339,7 @@ class mc_switch(simple_type):
         elif case.isdigit():
             ret.append(f"if ({comp} == {case}) {{")
         else:
-            ret.append(f"if (!strcmp({comp}, {case})) {{")
+            ret.append(f"if ({string_compare(comp, case)}) {{")
         self.code_fields(ret, fields, mode, variable)
         ret.append("}")
         return ret
@@ -959,10 +1347,10 @@ class mc_switch(simple_type):
     def str_switch(self, comp, mode, variable=None):
         items = list(self.field_dict.items())
         case, fields = items[0]
-        ret = [f"if (!strcmp({comp}, {case})) {{"]
+        ret = [f"if ({string_compare(comp, case)}) {{"]
         self.code_fields(ret, fields, mode, variable)
         for case, fields in items[1:]:
-            ret.append(f"}} else if (!strcmp({comp}, {case})) {{")
+            ret.append(f"}} else if ({string_compare(comp, case)}) {{")
             self.code_fields(ret, fields, mode, variable)
         ret.append("}")
         return ret
@@ -1022,6 +1410,20 @@ class mc_switch(simple_type):
             return self.str_switch(comp, 1)
         return self.union_multi(comp, 1)
 
+    # Compared fields are zero or the sample string, which matches no case
+    def sample(self):
+        if self.null_switch or self.is_str_switch:
+            return []
+        if self.is_inverse:
+            if len(self.field_dict) != 1:
+                return None
+            case = next(iter(self.field_dict))
+            return [] if case in ("0", "false") else sample_fields(self.fields)
+        for case in ("0", "false"):
+            if case in self.field_dict:
+                return sample_fields(self.field_dict[case])
+        return []
+
     def process_fields(self, name, fields):
         for key, field_info in fields.items():
             if not key.isdigit() and key not in ("true", "false"):
@@ -1159,7 +1561,7 @@ class mc_array(simple_type):
         if mode == 0:
             ret.extend(indent + l for l in self.field.encoder())
         elif mode == 1:
-            ret.extend(indent + l for l in self.field.decoder())
+            ret.extend(indent + l for l in decode_fields([self.field]))
         elif mode == 2:
             ret.extend(indent + l for l in self.field.length(variable))
         elif mode == 3:
@@ -1168,9 +1570,18 @@ class mc_array(simple_type):
         self.field.reset_name()
         return ret
 
+    # Varint arrays are handled by the bulk kernels instead of a loop
+    def is_varint_array(self):
+        return isinstance(self.field, mc_varint)
+
     def prefixed_encode(self):
         iterator = f"i{self.depth}"
         self.count.name = f"{self.name}.size"
+        if self.is_varint_array():
+            return (
+                *self.count.encoder(),
+                f"mcp_encode_varint_array64({self.name}.data, {self.name}.size, dest);"
+            )
         self.field.temp_name(f"{self.name}.data[{iterator}]")
         result = (
             *self.count.encoder(),
@@ -1181,19 +1592,35 @@ class mc_array(simple_type):
         self.field.reset_name()
         return result
 
-    def prefixed_decode(self):
+    # Elements are allocated after checking that the buffer could hold
+    # their count, fixed size elements are not checked one by one then,
+    # elements which have to be freed are zeroed
+    def element_decode(self):
         iterator = f"i{self.depth}"
-        self.count.name = f"{self.name}.size"
+        if self.is_varint_array():
+            return (
+                *count_check(self.name, 1),
+                f"{self.name}.data = mcp_buffer_decode_allocate(src, {self.name}.size * sizeof({self.f_type}));",
+                f"mcp_decode_varint_array64({self.name}.data, {self.name}.size, src);"
+            )
         self.field.temp_name(f"{self.name}.data[{iterator}]")
+        zeroed = len(self.field.free()) != 0
         result = (
-            *self.count.decoder(),
-            f"{self.name}.data = malloc({self.name}.size * sizeof({self.f_type}));",
+            *count_check(self.name, max(self.field.min_size(), 1)),
+            f"{self.name}.data = mcp_buffer_decode_allocate{'_zeroed' if zeroed else ''}(src, {self.name}.size * sizeof({self.f_type}));",
             f"for (size_t {iterator} = 0; {iterator} < {self.name}.size; {iterator}++) {{",
             *(indent + l for l in self.field.decoder()),
             "}"
         )
         self.field.reset_name()
         return result
+
+    def prefixed_decode(self):
+        self.count.name = f"{self.name}.size"
+        return (
+            *decode_fields([self.count]),
+            *self.element_decode()
+        )
     
     def prefixed_length(self, variable):
         iterator = f"i{self.depth}"
@@ -1227,6 +1654,8 @@ class mc_array(simple_type):
 
     def foreign_encode(self):
         iterator = f"i{self.depth}"
+        if self.is_varint_array():
+            return f"mcp_encode_varint_array64({self.name}.data, {self.name}.size, dest);",
         self.field.temp_name(f"{self.name}.data[{iterator}]")
         result = (
             f"for (size_t {iterator} = 0; {iterator} < {self.name}.size; {iterator}++) {{",
@@ -1237,17 +1666,25 @@ class mc_array(simple_type):
         return result
 
     def foreign_decode(self):
-        iterator = f"i{self.depth}"
-        self.field.temp_name(f"{self.name}.data[{iterator}]")
-        result = (
+        return (
             f"{self.name}.size = {self.get_foreign()};",
-            f"{self.name}.data = malloc({self.name}.size * sizeof({self.f_type}));",
-            f"for (size_t {iterator} = 0; {iterator} < {self.name}.size; {iterator}++) {{",
-            *(indent + l for l in self.field.decoder()),
+            *self.element_decode()
+        )
+
+    def skipper(self):
+        if not self.is_prefixed or not isinstance(self.count, mc_varint):
+            return None
+        field_skip_code = self.field.skipper()
+        if field_skip_code is None:
+            return None
+        if isinstance(self.field, numeric_type) and not isinstance(self.field, (mc_varint, mc_varlong)):
+            return f"mcp_buffer_skip_count(src, mcp_decode_varint(src), {self.field.size});",
+        iterator = f"i{self.depth}"
+        return (
+            f"for (size_t {iterator} = 0, count = mcp_decode_varint(src); {iterator} < count && !src->failed; {iterator}++) {{",
+            *(indent + line for line in field_skip_code),
             "}"
         )
-        self.field.reset_name()
-        return result
 
     def foreign_length(self, variable):
         iterator = f"i{self.depth}"
@@ -1280,6 +1717,24 @@ class mc_array(simple_type):
         else:
             return f"free({self.name}.data);",
 
+    def min_size(self):
+        if self.is_fixed:
+            return self.count * self.field.min_size()
+        if self.is_prefixed:
+            return self.count.min_size()
+        return 0
+
+    # Foreign counts refer to zero fields
+    def sample(self):
+        field_sample = self.field.sample()
+        if field_sample is None:
+            return None
+        if self.is_fixed:
+            return field_sample * self.count
+        if self.is_prefixed:
+            return [*sample_number(type(self.count), sample_count), *field_sample * sample_count]
+        return []
+
     def encoder(self):
         if self.is_fixed:
             return self.fixed(0)
@@ -1347,12 +1802,12 @@ class mc_container(complex_type):
                 suffix = ""
             else:
                 suffix = "."
-            for field in self.fields:
+            for field in reversed(self.fields):
                 field.temp_name(f"{self.name}{suffix}{field.name}")
                 ret.extend(field.free())
                 field.reset_name()
         else:
-            for field in self.fields:
+            for field in reversed(self.fields):
                 ret.extend(field.free())
         return ret
 
@@ -1372,21 +1827,22 @@ class mc_container(complex_type):
                 ret.extend(field.encoder())
         return ret
 
+    # A fixed size container is checked by its caller
     def decoder(self):
-        ret = []
-        if self.name:
-            if self.name.endswith("->"):
-                suffix = ""
-            else:
-                suffix = "."
-            for field in self.fields:
-                field.temp_name(f"{self.name}{suffix}{field.name}")
-                ret.extend(field.decoder())
-                field.reset_name()
-        else:
-            for field in self.fields:
-                ret.extend(field.decoder())
-        return ret
+        suffix = "" if self.name.endswith("->") else "."
+        def decoder(field):
+            if not self.name:
+                return list(field.decoder())
+            field.temp_name(f"{self.name}{suffix}{field.name}")
+            ret = list(field.decoder())
+            field.reset_name()
+            return ret
+        if self.fixed_size() is not None:
+            return [l for field in self.fields for l in decoder(field)]
+        return decode_fields(self.fields, decoder)
+
+    def sample(self):
+        return sample_fields(self.fields)
 
     def __eq__(self, value):
         if not super().__eq__(value) or len(self.fields) != len(value.fields):
@@ -1417,6 +1873,24 @@ def get_free(field):
     field.reset_name()
     return string
 
+def get_put(field, offset):
+    field.temp_name("this->" + field.name)
+    string = field.put(offset)
+    field.reset_name()
+    return string
+
+def get_get(field, offset):
+    field.temp_name("this->" + field.name)
+    string = field.get(offset)
+    field.reset_name()
+    return string
+
+def get_put_varying(field, offset):
+    field.temp_name("this->" + field.name)
+    string = field.put_varying(offset)
+    field.reset_name()
+    return string
+
 class packet:
     def __init__(self, state, direction, packet_id, packet_id_int, packet_name, data):
         self.state = state
@@ -1453,10 +1927,35 @@ class packet:
             f"void mcp_encode_{self.postfix}({self.class_name}* this, mcp_buffer_t* src);", 
         ]
 
+    # Packets of fixed size fields and varints have a fixed layout, fixed size
+    # fields between varints are stored at constant offsets, so they are
+    # encoded into a buffer of the maximum size without growing it and decoded
+    # after a single check per run, without moving the buffer index
+    # between the fields, packets without varints have a constant length
+    def fixed_layout(self):
+        return all(field.put(0) is not None or field.put_varying(0) is not None for field in self.fields)
+
+    # Length of the packet id and fixed size fields
+    def fixed_length(self):
+        return varnum_length(self.packet_id_int) + sum(field.fixed_size() or 0 for field in self.fields)
+
+    # Encoded size of the packet, the longest varints take 10 bytes
+    def max_length(self):
+        return self.fixed_length() + sum(10 for field in self.fields if field.fixed_size() is None)
+
     def length(self):
         global packet_length_variable
         previous = packet_length_variable
         packet_length_variable = "length"
+        if self.fixed_layout():
+            lengths = [*(indent + l for f in self.fields if f.fixed_size() is None for l in get_length(f))]
+            packet_length_variable = previous
+            return [
+                f"static inline void mcp_length_{self.postfix}({self.class_name}* this, size_t* length) {{",
+                f"{indent}*length = {self.fixed_length()};",
+                *lengths,
+                "}"
+            ]
         lengths = [*(indent + l for f in self.fields for l in get_length(f))]
         packet_length_variable = previous
         tmp = []
@@ -1472,7 +1971,8 @@ class packet:
         ]
 
     def free(self):
-        fields = [*(indent + l for f in self.fields for l in get_free(f))]
+        # reversed, switches are freed before the fields they compare
+        fields = [*(indent + l for f in reversed(self.fields) for l in get_free(f))]
         tmp = []
         for line in fields:
             if packet_tmp_variable in line:
@@ -1484,7 +1984,37 @@ class packet:
             "}"
         ]
 
+    def fixed_encoder(self):
+        offset = varnum_length(self.packet_id_int)
+        if offset == 1:
+            fields = [f"out[0] = {self.packet_id};"]
+        else:
+            fields = [f"out[{i}] = (char) 0x{byte:02x};" for i, byte in enumerate(sample_varint(self.packet_id_int))]
+        for field in self.fields:
+            if field.fixed_size() is not None:
+                fields.extend(get_put(field, offset))
+                offset += field.fixed_size()
+            else:
+                fields.extend(get_put_varying(field, offset))
+                offset = 0
+        if self.max_length() == self.fixed_length():
+            length = self.fixed_length()
+        elif offset == 0:
+            length = "out - mcp_buffer_current(dest)"
+        else:
+            length = f"out + {offset} - mcp_buffer_current(dest)"
+        return [
+            f"void mcp_encode_{self.postfix}({self.class_name}* this, mcp_buffer_t* dest) {{",
+            f"{indent}mcp_buffer_begin(dest, {self.max_length()});",
+            f"{indent}char* out = mcp_buffer_current(dest);",
+            *(indent + l for l in fields),
+            f"{indent}mcp_buffer_increment(dest, {length});",
+            "}"
+        ]
+
     def encoder(self):
+        if self.fixed_layout():
+            return self.fixed_encoder()
         fields = [*(indent + l for f in self.fields for l in get_encoder(f))]
         tmp = []
         for line in fields:
@@ -1492,28 +2022,93 @@ class packet:
                 tmp = [f"{indent}uint8_t {packet_tmp_variable} = 0;"]
         return [
             f"void mcp_encode_{self.postfix}({self.class_name}* this, mcp_buffer_t* dest) {{",
-            f"{indent}size_t {packet_length_variable};",
             *tmp,
+            "#ifdef MCP_ENCODE_EXACT_LENGTH",
+            f"{indent}size_t {packet_length_variable};",
             f"{indent}mcp_length_{self.postfix}(this, &{packet_length_variable});",
-            f"{indent}mcp_buffer_allocate(dest, {packet_length_variable});",
+            f"{indent}mcp_buffer_begin(dest, {packet_length_variable});",
+            "#else",
+            f"{indent}mcp_buffer_begin(dest, 0);",
+            "#endif /* MCP_ENCODE_EXACT_LENGTH */",
             f"{indent}mcp_encode_varint({self.packet_id}, dest);",
             *fields,
             "}"
         ]
 
+    def min_size(self):
+        return sum(field.min_size() for field in self.fields)
+
+    # Packets which have to be freed are zeroed first,
+    # so a partially decoded packet could be freed too
+    def zeroed(self):
+        return any(len(get_free(field)) != 0 for field in self.fields)
+
+    def fixed_decoder(self):
+        fields = []
+        covered = 0
+        index = 0
+        while index < len(self.fields):
+            field = self.fields[index]
+            if field.fixed_size() is None:
+                fields.extend(get_decoder(field))
+                covered = 0
+                index += 1
+                continue
+            run = []
+            while index < len(self.fields) and self.fields[index].fixed_size() is not None:
+                run.append(self.fields[index])
+                index += 1
+            size = sum(f.fixed_size() for f in run)
+            if size > covered:
+                covered = sum(f.min_size() for f in self.fields[index - len(run):])
+                fields.extend(buffer_check(covered))
+            covered -= size
+            fields.append("in = mcp_buffer_current(src);")
+            offset = 0
+            for f in run:
+                fields.extend(get_get(f, offset))
+                offset += f.fixed_size()
+            fields.append(f"mcp_buffer_increment(src, {size});")
+        if len(fields) == 0:
+            return [f"void mcp_decode_{self.postfix}({self.class_name}* this, mcp_buffer_t* src) {{ }}"]
+        declaration = [f"{indent}const char* in;"] if "in = mcp_buffer_current(src);" in fields else []
+        return [
+            f"void mcp_decode_{self.postfix}({self.class_name}* this, mcp_buffer_t* src) {{",
+            *declaration,
+            *(indent + l for l in fields),
+            "}"
+        ]
+
     def decoder(self):
-        fields = [*(indent + l for f in self.fields for l in get_decoder(f))]
+        if self.fixed_layout():
+            return self.fixed_decoder()
+        fields = [*(indent + l for l in decode_fields(self.fields, get_decoder))]
         tmp = []
         for line in fields:
             if packet_tmp_variable in line:
                 tmp = [f"{indent}uint8_t {packet_tmp_variable} = 0;"]
+        zero = [f"{indent}memset(this, 0, sizeof({self.class_name}));"] if self.zeroed() else []
         return [
             f"void mcp_decode_{self.postfix}({self.class_name}* this, mcp_buffer_t* src) {{",
             *tmp,
+            *zero,
             *fields,
             "}"
         ]
 
+    # Descriptor table entry, with the sample as a string literal
+    def info(self):
+        sample = sample_fields(self.fields)
+        if sample is None:
+            sample_literal = "NULL, 0"
+        else:
+            sample_literal = "\"" + "".join(f"\\x{byte:02x}" for byte in sample) + f"\", {len(sample)}"
+        return (
+            f"{{\"{self.packet_name}\", sizeof({self.class_name}), "
+            f"(mcp_packet_codec_t*) mcp_decode_{self.postfix}, (mcp_packet_codec_t*) mcp_encode_{self.postfix}, "
+            f"(mcp_packet_free_t*) mcp_free_{self.postfix}, {sample_literal}, {self.min_size()}}}"
+        )
+
     def constructor(self):
         return [
             f"void mcp_create_{self.postfix}({self.class_name}* this{self.parameters()}) {{",
@@ -1521,6 +2116,119 @@ class packet:
             "}"
         ]
 
+    # Lazy views are generated for packets whose fields fit the view masks
+    def has_view(self):
+        return 0 < len(self.fields) <= view_max_fields
+
+    # Type of a field as declared in the packet struct, None if it
+    # is declared with more than one line
+    def field_type(self, field):
+        declaration = field.declaration()
+        declaration = [declaration] if isinstance(declaration, str) else list(declaration)
+        if len(declaration) != 1 or not declaration[0].endswith(f" {field.name};"):
+            return None
+        return declaration[0][:-len(f" {field.name};")]
+
+    # Fields referenced by the decoders of later fields have to be
+    # decoded while scanning
+    def eager_mask(self):
+        mask = 0
+        decoders = ["\n".join(get_decoder(f)) for f in self.fields]
+        for index, field in enumerate(self.fields):
+            reference = re.compile(rf"this->{re.escape(field.name)}\b")
+            if any(reference.search(decoder) for decoder in decoders[index + 1:]):
+                mask |= 1 << index
+        return mask
+
+    def view_declaration(self):
+        if not self.has_view():
+            return []
+        view_name = f"mcp_view_{self.postfix}"
+        getters = []
+        for field in self.fields:
+            field_type = self.field_type(field)
+            if field_type is not None:
+                getters.append(f"{field_type}* mcp_get_{self.postfix}_{field.name}({view_name}* view);")
+        return [
+            f"typedef struct {view_name} {{",
+            f"{indent}mcp_view_t view;",
+            f"{indent}{self.class_name} packet;",
+            f"}} {view_name};",
+            f"void mcp_init_view_{self.postfix}({view_name}* view, mcp_buffer_t* src);",
+            f"void mcp_free_view_{self.postfix}({view_name}* view);",
+            *getters
+        ]
+
+    def view(self):
+        if not self.has_view():
+            return []
+        view_name = f"mcp_view_{self.postfix}"
+        cases = []
+        for index, field in enumerate(self.fields):
+            decoder = decode_fields([field], get_decoder)
+            field.temp_name("this->" + field.name)
+            skipper = field.skipper()
+            field.reset_name()
+            # set first, so a partially decoded field is freed too
+            decoded = f"view->decoded |= (uint64_t) 1 << {index};"
+            cases.append(f"{indent}case {index}:")
+            if skipper is None:
+                cases.extend(indent * 2 + l for l in (decoded, *decoder))
+            else:
+                cases.extend((
+                    f"{indent * 2}if (decode) {{",
+                    *(indent * 3 + l for l in (decoded, *decoder)),
+                    f"{indent * 2}}} else {{",
+                    *(indent * 3 + l for l in skipper),
+                    f"{indent * 2}}}"
+                ))
+            cases.append(f"{indent * 2}break;")
+        tmp = []
+        if any(packet_tmp_variable in l for l in cases):
+            tmp = [f"{indent}uint8_t {packet_tmp_variable} = 0;"]
+        frees = []
+        for index, field in enumerate(self.fields):
+            free = get_free(field)
+            if len(free) != 0:
+                frees.extend((
+                    f"{indent}if (view->view.decoded >> {index} & 1) {{",
+                    *(indent * 2 + l for l in free),
+                    f"{indent}}}"
+                ))
+        free_tmp = []
+        if any(packet_tmp_variable in l for l in frees):
+            free_tmp = [f"{indent}uint8_t {packet_tmp_variable} = 0;"]
+        getters = []
+        for index, field in enumerate(self.fields):
+            field_type = self.field_type(field)
+            if field_type is not None:
+                getters.extend((
+                    f"{field_type}* mcp_get_{self.postfix}_{field.name}({view_name}* view) {{",
+                    f"{indent}mcp_view_field(&view->view, {index});",
+                    f"{indent}return &view->packet.{field.name};",
+                    "}"
+                ))
+        return [
+            f"static void mcp_scan_{self.postfix}(mcp_view_t* view, size_t field, bool decode) {{",
+            f"{indent}{self.class_name}* this = &(({view_name}*) view)->packet;",
+            f"{indent}mcp_buffer_t* src = &view->src;",
+            *tmp,
+            f"{indent}switch (field) {{",
+            *(indent + l for l in cases),
+            f"{indent}}}",
+            "}",
+            f"void mcp_init_view_{self.postfix}({view_name}* view, mcp_buffer_t* src) {{",
+            *([f"{indent}memset(&view->packet, 0, sizeof({self.class_name}));"] if self.zeroed() else []),
+            f"{indent}mcp_view_init(&view->view, src, mcp_scan_{self.postfix}, {hex(self.eager_mask())}ULL);",
+            "}",
+            f"void mcp_free_view_{self.postfix}({view_name}* view) {{",
+            *([f"{indent}{self.class_name}* this = &view->packet;"] if free_tmp or frees else []),
+            *free_tmp,
+            *frees,
+            "}",
+            *getters
+        ]
+
 
 mc_states = "handshaking", "status", "login", "play"
 mc_directions = "toClient", "toServer"
@@ -1584,8 +2292,274 @@ def extract_infos_from_listing(listing):
     return ret
 
 
+def to_symbol(version):
+    return version.replace(".", "_")
+
+
+# Packets of a version by state and direction, the id of a packet is its index
+def extract_packets(proto):
+    packets = {}
+    for state in mc_states:
+        packets[state] = {}
+        for direction in mc_directions:
+            packets[state][direction] = []
+            for index, info in enumerate(extract_infos_from_listing(proto[state][direction])):
+                if info[1] == "LegacyServerListPing":
+                    continue
+                packet_data = proto[state][direction]["types"][info[2]][1]
+                packets[state][direction].append(packet(state, direction, to_enum(info[1], direction, state), index, info[1], packet_data))
+    return packets
+
+
+# Packets are translated between versions without decoding them. Fields are
+# matched by their name and MCD type. A packet with the same field types is
+# passed as it is with its id replaced, otherwise the matching fields are
+# copied, fields missing from the source are written blank and the rest is
+# left out. Packets without a counterpart, with fields which could not be
+# skipped or written blank, with fields which changed their type, or with
+# fields whose encoding changes between the versions are dropped
+
+# Protocol versions whose registries (block states, items, entity types and
+# particles) are renumbered, values of registry ids are never translated
+registry_versions = (107, 315, 335, 393, 477, 573, 735, 751)
+
+# Protocol versions which change the encoding of a native type, the same
+# MCD type name does not mean the same bytes across them
+native_boundaries = {
+    "position": (477,),  # bit order of the coordinates
+    "slot": registry_versions + (404,),  # 1.13 and 1.13.2 layouts, item ids
+    "ingredient": registry_versions + (404,),
+    "minecraft_smelting_format": registry_versions + (404,),
+    "entityMetadata": registry_versions,  # value type ids, entity fields
+    "particleData": registry_versions,
+    "particle": registry_versions,
+    "tags": registry_versions,
+}
+
+# Protocol versions which change the meaning of a packet field
+field_boundaries = {
+    ("MapChunk", "chunkData"): registry_versions,  # block states, 1.16 packing
+    ("MultiBlockChange", "records"): registry_versions,
+    ("BlockChange", "type"): registry_versions,
+    ("SpawnEntity", "type"): registry_versions,
+    ("SpawnEntityLiving", "type"): registry_versions,
+    ("WorldParticles", "particleId"): registry_versions,
+}
+
+# Type names used by an MCD type, including the nested ones
+def type_names(type_field):
+    if isinstance(type_field, str):
+        return {type_field}
+    names = set()
+    if isinstance(type_field, list):
+        for item in type_field:
+            names |= type_names(item)
+    elif isinstance(type_field, dict):
+        for key, value in type_field.items():
+            if key not in ("name", "compareTo", "mappings"):
+                names |= type_names(value)
+    return names
+
+def crosses(boundaries, versions):
+    low, high = sorted(versions)
+    return any(low < boundary <= high for boundary in boundaries)
+
+# Field whose encoding or meaning differs between the protocol versions
+def field_changed(pak, data_field, versions):
+    name = extract_field(data_field)[0]
+    if crosses(field_boundaries.get((pak.packet_name, name), ()), versions):
+        return True
+    return any(crosses(native_boundaries.get(t, ()), versions) for t in type_names(data_field["type"]))
+
+def field_layouts(pak):
+    return [(extract_field(f)[0], json.dumps(f["type"], sort_keys=True)) for f in pak.data]
+
+# Lines that move src past a field, None if it has to be decoded to find its end
+def skip_field(field):
+    skipper = field.skipper()
+    if skipper is not None:
+        return list(skipper)
+    size = field.fixed_size()
+    if size is None:
+        return None
+    return [f"mcp_buffer_skip(src, {size});"] if size != 0 else []
+
+# Encoding of a zero, empty or absent field, None if there is no such value
+def blank_field(field):
+    if isinstance(field, (mc_varint, mc_varlong, mc_string, mc_option, mc_optional_nbt)):
+        return [0]
+    if isinstance(field, mc_buffer) and field.count is mc_varint:
+        return [0]
+    if isinstance(field, mc_array) and field.is_prefixed and isinstance(field.count, mc_varint):
+        return [0]
+    if isinstance(field, mc_metadata):
+        return [0xFF]
+    if isinstance(field, mc_nbt):
+        return [0x0A, 0, 0, 0]
+    size = field.fixed_size()
+    return [0] * size if size is not None else None
+
+def byte_literal(data):
+    return "\"" + "".join(f"\\x{byte:02x}" for byte in data) + "\""
+
+# Translation table entry and the lines of its function
+def translation(name, src, dst, versions):
+    drop = "{MCP_TRANSLATION_DROP, 0, NULL}", []
+    if dst is None:
+        return drop
+    src_layout = field_layouts(src)
+    dst_layout = field_layouts(dst)
+    if any(layout in src_layout and field_changed(dst, data_field, versions) for layout, data_field in zip(dst_layout, dst.data)):
+        return drop
+    # a field which changed its type is not missing, it could not be blank
+    src_types = {field_name: layout for field_name, layout in src_layout if field_name}
+    if any(src_types.get(field_name, layout) != layout for field_name, layout in dst_layout if field_name):
+        return drop
+    if [l for _, l in src_layout] == [l for _, l in dst_layout]:
+        return f"{{MCP_TRANSLATION_RAW, {dst.packet_id_int}, NULL}}", []
+
+    # common tail is copied at once, without finding the end of its fields
+    tail = 0
+    while tail < min(len(src_layout), len(dst_layout)) and src_layout[-1 - tail] == dst_layout[-1 - tail]:
+        tail += 1
+    src_head = len(src_layout) - tail
+    positions = {layout: index for index, layout in enumerate(src_layout[:src_head])}
+
+    # copied ranges as field indices of src, None is its end, and blank bytes
+    parts = []
+    for index, layout in enumerate(dst_layout[:len(dst_layout) - tail]):
+        position = positions.get(layout)
+        if position is not None:
+            if parts and parts[-1][0] == "copy" and parts[-1][2] == position:
+                parts[-1] = ("copy", parts[-1][1], position + 1)
+            else:
+                parts.append(("copy", position, position + 1))
+            continue
+        blank = blank_field(dst.fields[index])
+        if blank is None:
+            return drop
+        if len(blank) == 0:
+            continue
+        if parts and parts[-1][0] == "bytes":
+            parts[-1][1].extend(blank)
+        else:
+            parts.append(("bytes", list(blank)))
+    if tail != 0:
+        if parts and parts[-1][0] == "copy" and parts[-1][2] == src_head:
+            parts[-1] = ("copy", parts[-1][1], None)
+        else:
+            parts.append(("copy", src_head, None))
+
+    offsets = max([0, *(i for part in parts if part[0] == "copy" for i in part[1:] if i is not None)])
+    lines = [f"size_t offsets[{offsets + 1}];", "offsets[0] = src->index;"]
+    for index in range(offsets):
+        skipper = skip_field(src.fields[index])
+        if skipper is None:
+            return drop
+        lines.extend(skipper)
+        lines.append(f"offsets[{index + 1}] = src->index;")
+    lines.extend((
+        "if (src->failed) {",
+        f"{indent}return false;",
+        "}"
+    ))
+
+    packet_id = sample_varint(dst.packet_id_int)
+    length = [str(len(packet_id) + sum(len(part[1]) for part in parts if part[0] == "bytes"))]
+    appends = [f"mcp_buffer_append(dest, {byte_literal(packet_id)}, {len(packet_id)});"]
+    for part in parts:
+        if part[0] == "bytes":
+            appends.append(f"mcp_buffer_append(dest, {byte_literal(part[1])}, {len(part[1])});")
+            continue
+        end = "src->size" if part[2] is None else f"offsets[{part[2]}]"
+        length.append(f"({end} - offsets[{part[1]}])")
+        appends.append(f"mcp_buffer_append(dest, &src->data[offsets[{part[1]}]], {end} - offsets[{part[1]}]);")
+    return f"{{MCP_TRANSLATION_ENCODE, {dst.packet_id_int}, {name}}}", [
+        f"static bool {name}(mcp_buffer_t* src, mcp_buffer_t* dest) {{",
+        *(indent + l for l in lines),
+        f"{indent}mcp_buffer_begin(dest, {' + '.join(length)});",
+        *(indent + l for l in appends),
+        f"{indent}return true;",
+        "}"
+    ]
+
+
+# Translation unit of a version other than MCP_MC, only its descriptor
+# mcp_protocol_<version> is exported
+def run_translation(version, library_packets, library_version, path):
+    mcd = minecraft_data(version)
+    symbol = to_symbol(version)
+    wire_packets = extract_packets(mcd.protocol)
+    functions = []
+    tables = []
+    max_ids = []
+    inbound = []
+    outbound = []
+    for state in mc_states:
+        state_max_ids = []
+        state_inbound = []
+        state_outbound = []
+        for direction in ("toServer", "toClient"):
+            dr = "server" if direction == "toClient" else "client"
+            wire = wire_packets[state][direction]
+            library = library_packets[state][direction]
+            state_max_ids.append(str(len(wire)))
+            for table, sources, targets, tables_list in (
+                ("inbound", wire, library, state_inbound),
+                ("outbound", library, wire, state_outbound)
+            ):
+                if len(sources) == 0:
+                    tables_list.append("NULL")
+                    continue
+                table_name = f"mcp_{table}_{symbol}_{dr}_{state}"
+                targets = {pak.packet_name: pak for pak in targets}
+                entries = []
+                for pak in sources:
+                    entry, function = translation(f"mcp_{table}_{symbol}_{dr}_{state}_{pak.packet_name}", pak, targets.get(pak.packet_name), (mcd.version["version"], library_version))
+                    entries.append(f"{indent}{entry},")
+                    if function:
+                        functions.extend((*function, ""))
+                entries[-1] = entries[-1][:-1]
+                tables.extend((f"static const mcp_translation_t {table_name}[] = {{", *entries, "};", ""))
+                tables_list.append(table_name)
+        max_ids.append(f"{indent * 2}{{{', '.join(state_max_ids)}}},")
+        inbound.append(f"{indent * 2}{{{', '.join(state_inbound)}}},")
+        outbound.append(f"{indent * 2}{{{', '.join(state_outbound)}}},")
+    for lines in (max_ids, inbound, outbound):
+        lines[-1] = lines[-1][:-1]
+
+    impl = [
+        "/**",
+        f" * @file protocol_{symbol}.c",
+        *warning_impl[2:],
+        f"/* MCD version {version} */",
+        "#include \"mcp/version.h\"",
+        "#include \"mcp/codec.h\"",
+        "",
+        *functions,
+        *tables,
+        f"const mcp_protocol_t mcp_protocol_{symbol} = {{",
+        f"{indent}\"{version}\",",
+        f"{indent}{mcd.version['version']},",
+        f"{indent}{{",
+        *max_ids,
+        f"{indent}}},",
+        f"{indent}{{",
+        *inbound,
+        f"{indent}}},",
+        f"{indent}{{",
+        *outbound,
+        f"{indent}}}",
+        "};",
+        ""
+    ]
+    with open(f"{path}protocol_{symbol}.c", "w") as f:
+        f.write("\n".join(impl))
+
+
 def run(version):
     mcd = minecraft_data(version)
+    versions = [version, *(v for v in dict.fromkeys(extra_versions) if v != version)]
     version = version.replace(".", "_")
     proto = mcd.protocol
     header_upper = [
@@ -1594,20 +2568,25 @@ def run(version):
         "#define MCP_PROTOCOL_H",
         "",
         "#include \"mcp/connection.h\"",
+        "#include \"mcp/version.h\"",
         "#include \"mcp/io/buffer.h\"",
+        "#include \"mcp/view.h\"",
         "#include \"mcp/particle.h\"",
         "#include \"mcp/type.h\"",
         "",
         f"#define MCP_MC_VERSION \"{version.replace('_', '.')}\"",
         f"#define MCP_PROTOCOL_VERSION {mcd.version['version']}",
+        *(("#define MCP_STRING_VIEWS",) if string_views else ()),
         "",
     ]
     header_lower = [
         "#ifndef NDEBUG",
         f"{indent}extern const char** mcp_protocol_cstrings[MCP_STATE__MAX][MCP_SOURCE__MAX];",
-        f"{indent}extern const mcp_packet_id_t mcp_protocol_max_ids[MCP_STATE__MAX][MCP_SOURCE__MAX];",
         "#endif /* NDEBUG */",
+        "extern const mcp_packet_id_t mcp_protocol_max_ids[MCP_STATE__MAX][MCP_SOURCE__MAX];",
         "extern mcp_handler_t** mcp_protocol_handlers[MCP_STATE__MAX][MCP_SOURCE__MAX];",
+        "extern const mcp_packet_info_t* mcp_protocol_packets[MCP_STATE__MAX][MCP_SOURCE__MAX];",
+        *(f"extern const mcp_protocol_t mcp_protocol_{to_symbol(v)};" for v in versions),
         ""
     ]
     impl_upper = [
@@ -1630,6 +2609,7 @@ def run(version):
         "typedef enum mcp_type_ParticleType {"
     ]
     particle_header.extend(f"{indent}MCP_PARTICLE_{x.upper()}," for x in mcd.particles_name)
+    sample_particles[:] = mcd.particles_name
     particle_header[-1] = particle_header[-1][:-1]
     particle_header += ["} mcp_type_ParticleType;", ""]
     if all(x in mcd.particles_name for x in ("iconcrack", "reddust", "fallingdust", "blockdust")):
@@ -1671,6 +2651,7 @@ def run(version):
                 if info[1] != "LegacyServerListPing":
                     packets[state][direction].append(pak)
                 header_lower += pak.declaration()
+                header_lower += pak.view_declaration()
                 header_lower.append("")
 
                 impl_lower += pak.free()
@@ -1678,6 +2659,7 @@ def run(version):
                 impl_lower += pak.length()
                 impl_lower += pak.decoder()
                 impl_lower += pak.encoder()
+                impl_lower += pak.view()
                 impl_lower.append("")
 
     for state in mc_states: 
@@ -1692,6 +2674,7 @@ def run(version):
             header_upper.append("#ifndef NDEBUG")
             header_upper.append(f"{indent}extern const char* mcp_{dr}_{state}_cstrings[MCP_{dr.upper()}_{state.upper()}__MAX];")
             header_upper.append("#endif /* NDEBUG */")
+            header_upper.append(f"extern const mcp_packet_info_t mcp_{dr}_{state}_packets[MCP_{dr.upper()}_{state.upper()}__MAX];")
             header_upper.append("")
 
     for state in mc_states:
@@ -1706,10 +2689,15 @@ def run(version):
             impl_upper.extend((f"{indent}}};", ""))
             impl_upper.append("#endif /* NDEBUG */")
             impl_upper.append(f"mcp_handler_t* mcp_{dr}_{state}_handlers[MCP_{dr.upper()}_{state.upper()}__MAX] = {{")
-            if len(packets[state][direction]) > 1:
+            if packets[state][direction]:
                 impl_upper.extend([f"{indent}&mcp_handler_Blank,"] * (len(packet_enum[state][direction]) - 1))
                 impl_upper[-1] = impl_upper[-1][:-1]
             impl_upper.extend(("};", ""))
+            impl_upper.append(f"const mcp_packet_info_t mcp_{dr}_{state}_packets[MCP_{dr.upper()}_{state.upper()}__MAX] = {{")
+            impl_upper.extend(f"{indent}{pak.info()}," for pak in packets[state][direction])
+            if packets[state][direction]:
+                impl_upper[-1] = impl_upper[-1][:-1]
+            impl_upper.extend(("};", ""))
 
     impl_upper += [
         "#ifndef NDEBUG",
@@ -1719,15 +2707,15 @@ def run(version):
         f"{indent*2}{{mcp_client_login_cstrings, mcp_server_login_cstrings}},",
         f"{indent*2}{{mcp_client_play_cstrings, mcp_server_play_cstrings}}",
         f"{indent}}};",
-        "",
-        f"{indent}const mcp_packet_id_t mcp_protocol_max_ids[MCP_STATE__MAX][MCP_SOURCE__MAX] = {{",
-        f"{indent*2}{{MCP_CLIENT_HANDSHAKING__MAX, MCP_SERVER_HANDSHAKING__MAX}},",
-        f"{indent*2}{{MCP_CLIENT_STATUS__MAX, MCP_SERVER_STATUS__MAX}},",
-        f"{indent*2}{{MCP_CLIENT_LOGIN__MAX, MCP_SERVER_LOGIN__MAX}},",
-        f"{indent*2}{{MCP_CLIENT_PLAY__MAX, MCP_SERVER_PLAY__MAX}}",
-        f"{indent}}};",
         "#endif /* NDEBUG */",
         "",
+        "const mcp_packet_id_t mcp_protocol_max_ids[MCP_STATE__MAX][MCP_SOURCE__MAX] = {",
+        f"{indent}{{MCP_CLIENT_HANDSHAKING__MAX, MCP_SERVER_HANDSHAKING__MAX}},",
+        f"{indent}{{MCP_CLIENT_STATUS__MAX, MCP_SERVER_STATUS__MAX}},",
+        f"{indent}{{MCP_CLIENT_LOGIN__MAX, MCP_SERVER_LOGIN__MAX}},",
+        f"{indent}{{MCP_CLIENT_PLAY__MAX, MCP_SERVER_PLAY__MAX}}",
+        "};",
+        "",
         "mcp_handler_t** mcp_protocol_handlers[MCP_STATE__MAX][MCP_SOURCE__MAX] = {",
         f"{indent}{{mcp_client_handshaking_handlers, mcp_server_handshaking_handlers}},",
         f"{indent}{{mcp_client_status_handlers, mcp_server_status_handlers}},",
@@ -1735,6 +2723,29 @@ def run(version):
         f"{indent}{{mcp_client_play_handlers, mcp_server_play_handlers}}",
         "};",
         "",
+        "const mcp_packet_info_t* mcp_protocol_packets[MCP_STATE__MAX][MCP_SOURCE__MAX] = {",
+        f"{indent}{{mcp_client_handshaking_packets, mcp_server_handshaking_packets}},",
+        f"{indent}{{mcp_client_status_packets, mcp_server_status_packets}},",
+        f"{indent}{{mcp_client_login_packets, mcp_server_login_packets}},",
+        f"{indent}{{mcp_client_play_packets, mcp_server_play_packets}}",
+        "};",
+        "",
+        f"const mcp_protocol_t mcp_protocol_{version} = {{",
+        f"{indent}MCP_MC_VERSION,",
+        f"{indent}MCP_PROTOCOL_VERSION,",
+        f"{indent}{{",
+        f"{indent*2}{{MCP_CLIENT_HANDSHAKING__MAX, MCP_SERVER_HANDSHAKING__MAX}},",
+        f"{indent*2}{{MCP_CLIENT_STATUS__MAX, MCP_SERVER_STATUS__MAX}},",
+        f"{indent*2}{{MCP_CLIENT_LOGIN__MAX, MCP_SERVER_LOGIN__MAX}},",
+        f"{indent*2}{{MCP_CLIENT_PLAY__MAX, MCP_SERVER_PLAY__MAX}}",
+        f"{indent}}}",
+        "};",
+        "",
+        "const mcp_protocol_t* const mcp_protocols[] = {",
+        *(f"{indent}&mcp_protocol_{to_symbol(v)}," for v in versions),
+        f"{indent}NULL",
+        "};",
+        "",
     ]
 
     for type_pre_definition in type_pre_definitions:
@@ -1765,6 +2776,9 @@ def run(version):
     with open(f"{path}mcp/protocol.h", "w") as f:
         f.write("\n".join(header))
 
+    for extra_version in versions[1:]:
+        run_translation(extra_version, packets, mcd.version["version"], path)
+
 
 if __name__ == "__main__":
     run(os.environ["MCP_MC"])
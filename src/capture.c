@@ -0,0 +1,218 @@
+/**
+ * @file capture.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief packet capture recorder and replay driver implementations
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/capture.h"  /* this */
+#include "mcp/codec.h"    /* varint decoder */
+#include <endian.h>       /* byte order */
+#include <fcntl.h>        /* open */
+#include <string.h>       /* memcpy, memcmp */
+#include <sys/mman.h>     /* mmap */
+#include <sys/stat.h>     /* fstat */
+#include <time.h>         /* clock_gettime */
+#include <unistd.h>       /* close */
+
+    /* defines */
+/**
+ * @brief size of a record with its padding
+ */
+#define mcp_capture_padded(length) (((length) + 7) & ~(size_t) 7)
+
+    /* functions */
+/**
+ * @brief get a clock in nanoseconds
+ *
+ * @param clock clock id
+ */
+static inline uint64_t mcp_capture_clock(clockid_t clock) {
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * @brief create a capture file
+ *
+ * @param capture pointer to the recorder
+ * @param path    file path
+ * @param raw     record frames as they are on the stream
+ */
+bool mcp_capture_open(mcp_capture_t* capture, const char* path, bool raw) {
+    capture->file = fopen(path, "wb");
+    if (capture->file == NULL) {
+        return false;
+    }
+    capture->start = mcp_capture_clock(CLOCK_MONOTONIC);
+    capture->raw = raw;
+    mcp_capture_header_t header = {
+        .magic = MCP_CAPTURE_MAGIC,
+        .version = htole32(MCP_CAPTURE_VERSION),
+        .start = htole64(mcp_capture_clock(CLOCK_REALTIME))
+    };
+    return fwrite(&header, sizeof(header), 1, capture->file) == 1;
+}
+
+/**
+ * @brief close a capture file
+ *
+ * @param capture pointer to the recorder
+ */
+bool mcp_capture_close(mcp_capture_t* capture) {
+    bool failed = ferror(capture->file);
+    return fclose(capture->file) == 0 && !failed;
+}
+
+/**
+ * @brief append a record
+ *
+ * @param capture  pointer to the recorder
+ * @param protocol protocol version number
+ * @param state    packet state
+ * @param source   packet source
+ * @param flags    MCP_CAPTURE_RAW and MCP_CAPTURE_COMPRESSED flags
+ * @param data     packet or frame data
+ * @param length   data length
+ */
+void mcp_capture_write(mcp_capture_t* capture, int protocol, mcp_state_t state, mcp_source_t source, uint8_t flags, const char* data, size_t length) {
+    static const char padding[8] = { 0 };
+    mcp_capture_record_t record = {
+        .time = htole64(mcp_capture_clock(CLOCK_MONOTONIC) - capture->start),
+        .length = htole32(length),
+        .protocol = htole16(protocol),
+        .state = state,
+        .flags = flags | (source == MCP_SOURCE_SERVER ? MCP_CAPTURE_SERVER : 0)
+    };
+    flockfile(capture->file);
+    fwrite_unlocked(&record, sizeof(record), 1, capture->file);
+    fwrite_unlocked(data, 1, length, capture->file);
+    fwrite_unlocked(padding, 1, mcp_capture_padded(length) - length, capture->file);
+    funlockfile(capture->file);
+}
+
+/**
+ * @brief map a capture file
+ *
+ * @param replay pointer to the replay driver
+ * @param path   file path
+ */
+bool mcp_replay_open(mcp_replay_t* replay, const char* path) {
+    int file = open(path, O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || (size_t) status.st_size < sizeof(mcp_capture_header_t)) {
+        close(file);
+        return false;
+    }
+    replay->size = status.st_size;
+    replay->data = mmap(NULL, replay->size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (replay->data == MAP_FAILED) {
+        return false;
+    }
+    madvise(replay->data, replay->size, MADV_SEQUENTIAL);
+
+    mcp_capture_header_t header;
+    memcpy(&header, replay->data, sizeof(header));
+    if (memcmp(header.magic, MCP_CAPTURE_MAGIC, sizeof(header.magic)) != 0 || le32toh(header.version) != MCP_CAPTURE_VERSION) {
+        munmap(replay->data, replay->size);
+        return false;
+    }
+    replay->start = le64toh(header.start);
+    mcp_replay_rewind(replay);
+    return true;
+}
+
+/**
+ * @brief unmap a capture file
+ *
+ * @param replay pointer to the replay driver
+ */
+void mcp_replay_close(mcp_replay_t* replay) {
+    munmap(replay->data, replay->size);
+}
+
+/**
+ * @brief read the next record
+ *
+ * @param replay pointer to the replay driver
+ * @param record destination record header
+ * @param data   destination pointer to the record data
+ */
+bool mcp_replay_next(mcp_replay_t* replay, mcp_capture_record_t* record, char** data) {
+    if (replay->size - replay->offset < sizeof(mcp_capture_record_t)) {
+        return false;
+    }
+    memcpy(record, &replay->data[replay->offset], sizeof(mcp_capture_record_t));
+    record->time = le64toh(record->time);
+    record->length = le32toh(record->length);
+    record->protocol = le16toh(record->protocol);
+    size_t offset = replay->offset + sizeof(mcp_capture_record_t);
+    if (replay->size - offset < record->length || record->state >= MCP_STATE__MAX) {
+        return false;
+    }
+    *data = &replay->data[offset];
+    offset += mcp_capture_padded(record->length);
+    replay->offset = offset < replay->size ? offset : replay->size;
+    return true;
+}
+
+/**
+ * @brief pass a record through the receive path of a connection
+ *
+ * @param context connection context
+ * @param record  record header
+ * @param data    record data
+ */
+bool mcp_replay_packet(mcp_context_t* context, mcp_capture_record_t* record, char* data) {
+    if (!mcp_version_select(context, record->protocol)) {
+        return false;
+    }
+    context->state = record->state;
+    context->source = record->flags & MCP_CAPTURE_SERVER ? MCP_SOURCE_SERVER : MCP_SOURCE_CLIENT;
+    if (!(record->flags & MCP_CAPTURE_RAW)) {
+        int threshold = context->compression_threshold;
+        context->compression_threshold = 0;
+        bool received = mcp_receive_frame(context, data, record->length);
+        context->compression_threshold = threshold;
+        return received;
+    }
+
+    uint64_t length;
+    size_t header = mcp_peek_varint(data, record->length, &length);
+    if (header == 0 || length != record->length - header) {
+        return false;
+    }
+    int threshold = context->compression_threshold;
+    context->compression_threshold = record->flags & MCP_CAPTURE_COMPRESSED ? 1 : 0;
+    bool received = mcp_receive_frame(context, data + header, length);
+    context->compression_threshold = threshold;
+    return received;
+}
+
+/**
+ * @brief pass every remaining record through the receive path of a connection
+ *
+ * @param replay  pointer to the replay driver
+ * @param context connection context
+ */
+long mcp_replay_run(mcp_replay_t* replay, mcp_context_t* context) {
+    long count = 0;
+    mcp_capture_record_t record;
+    char* data;
+    while (mcp_replay_next(replay, &record, &data)) {
+        if (mcp_version_find(record.protocol) == NULL) {
+            continue;
+        }
+        if (!mcp_replay_packet(context, &record, data)) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
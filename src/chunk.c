@@ -0,0 +1,717 @@
+/**
+ * @file chunk.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief chunk column and section decoders and encoders
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * block state longs are first turned into one little-endian bit stream,
+ * 1.16 longs are compacted by dropping their unused high bits,
+ * then every 8 states take whole bytes of the stream and are
+ * extracted at once with a shuffle, a shift and a mask,
+ * the kernel is chosen at runtime from the cpu features
+ *
+ * encoders build the palette with a small hash table, then
+ * join every 8 palette indices into whole bytes of a stream
+ * with vector shifts and turn the stream back into longs
+ */
+    /* includes */
+#include "mcp/chunk.h"     /* this */
+#include "mcp/codec.h"     /* varint decoders */
+#include "mcp/nbt.h"       /* heightmap compound */
+#include "csafe/assertd.h" /* debug assertions */
+#include <endian.h>        /* byte swap */
+#include <stdlib.h>        /* malloc */
+#include <string.h>        /* memcpy */
+
+    /* defines */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define MCP_CHUNK_X86
+  #include <immintrin.h> /* vector intrinsics */
+#endif /* __GNUC__ && x86 */
+
+/**
+ * @brief number of longs in the stream, with padding for vector loads
+ */
+#define MCP_CHUNK_STREAM_LONGS (MCP_CHUNK_SECTION_BLOCKS * MCP_CHUNK_MAX_BITS / 64 + 3)
+
+/**
+ * @brief number of slots of the palette hash table
+ */
+#define MCP_CHUNK_PALETTE_SLOTS 512
+
+/**
+ * @brief number of heightmap entries and their bits
+ */
+#define MCP_CHUNK_HEIGHTMAP_SIZE 256
+#define MCP_CHUNK_HEIGHTMAP_BITS 9
+
+    /* functions */
+/**
+ * @brief get the chunk data format of a protocol version
+ *
+ * @param protocol protocol version, 107 (1.9) or newer
+ */
+mcp_chunk_format_t mcp_chunk_format(int32_t protocol) {
+  mcp_chunk_format_t format;
+  format.block_count = protocol >= 477;
+  format.spanning = protocol < 735;
+  format.light = protocol < 477;
+  format.direct_palette = protocol < 393;
+  format.biomes = protocol < 393 ? 256 : protocol < 573 ? 256 * sizeof(int32_t) : 0;
+  format.global_bits = protocol < 393 ? 13 : protocol < 735 ? 14 : 15;
+  return format;
+}
+
+/**
+ * @brief turn longs into a little-endian bit stream
+ *
+ * @param stream   destination stream
+ * @param count    number of states
+ * @param longs    big-endian longs
+ * @param bits     bits per state
+ * @param spanning states are split across longs
+ */
+static void mcp_chunk_stream(uint64_t* stream, size_t count, const char* longs, uint8_t bits, bool spanning) {
+  size_t size = mcp_chunk_longs(count, bits, spanning);
+  uint64_t value;
+  if (spanning || 64 % bits == 0) {
+    for (size_t i = 0; i < size; i++) {
+      memcpy(&value, &longs[i * sizeof(uint64_t)], sizeof(uint64_t));
+      stream[i] = htole64(be64toh(value));
+    }
+    stream[size] = 0;
+    stream[size + 1] = 0;
+    return;
+  }
+  unsigned used = 64 / bits * bits;
+  uint64_t low = ((uint64_t) 1 << used) - 1;
+  uint64_t word = 0;
+  unsigned filled = 0;
+  size_t position = 0;
+  for (size_t i = 0; i < size; i++) {
+    memcpy(&value, &longs[i * sizeof(uint64_t)], sizeof(uint64_t));
+    value = be64toh(value) & low;
+    word |= value << filled;
+    filled += used;
+    if (filled >= 64) {
+      stream[position++] = htole64(word);
+      filled -= 64;
+      word = filled != 0 ? value >> (used - filled) : 0;
+    }
+  }
+  stream[position] = htole64(word);
+  stream[position + 1] = 0;
+  stream[position + 2] = 0;
+}
+
+/**
+ * scalar kernel
+ */
+static void mcp_chunk_extract_scalar(uint16_t* dest, size_t count, const uint8_t* stream, uint8_t bits, const int32_t* palette) {
+  uint32_t mask = ((uint32_t) 1 << bits) - 1;
+  uint32_t word;
+  for (size_t i = 0; i < count; i++) {
+    size_t bit = i * bits;
+    memcpy(&word, &stream[bit >> 3], sizeof(uint32_t));
+    uint32_t value = (le32toh(word) >> (bit & 7)) & mask;
+    dest[i] = palette != NULL ? palette[value] : value;
+  }
+}
+
+#ifdef MCP_CHUNK_X86
+/**
+ * layout of 8 states in their bytes of the stream,
+ * every state is moved into its own 32-bit lane
+ */
+typedef struct mcp_chunk_pattern_t {
+  uint8_t shuffle[32];
+  uint32_t shift[8];
+  uint32_t scale[8];
+} mcp_chunk_pattern_t;
+static mcp_chunk_pattern_t mcp_chunk_patterns[MCP_CHUNK_MAX_BITS + 1];
+
+/**
+ * fill the pattern table, scale shifts left so a constant
+ * right shift by 7 aligns the state when variable shifts are missing
+ */
+__attribute__((constructor))
+static void mcp_chunk_patterns_init() {
+  for (unsigned bits = 1; bits <= MCP_CHUNK_MAX_BITS; bits++) {
+    mcp_chunk_pattern_t* pattern = &mcp_chunk_patterns[bits];
+    memset(pattern->shuffle, 0x80, sizeof(pattern->shuffle));
+    for (unsigned i = 0; i < 8; i++) {
+      unsigned bit = i * bits;
+      unsigned first = bit >> 3;
+      unsigned last = (bit + bits - 1) >> 3;
+      for (unsigned byte = first; byte <= last; byte++) {
+        pattern->shuffle[i * 4 + byte - first] = byte;
+      }
+      pattern->shift[i] = bit & 7;
+      pattern->scale[i] = 1 << (7 - (bit & 7));
+    }
+  }
+}
+
+/**
+ * vector kernels, 8 states of a group take exactly bits bytes
+ */
+__attribute__((target("sse4.1")))
+static void mcp_chunk_extract_sse41(uint16_t* dest, size_t count, const uint8_t* stream, uint8_t bits, const int32_t* palette) {
+  mcp_chunk_pattern_t* pattern = &mcp_chunk_patterns[bits];
+  __m128i shuffle_low = _mm_loadu_si128((const __m128i*) &pattern->shuffle[0]);
+  __m128i shuffle_high = _mm_loadu_si128((const __m128i*) &pattern->shuffle[16]);
+  __m128i scale_low = _mm_loadu_si128((const __m128i*) &pattern->scale[0]);
+  __m128i scale_high = _mm_loadu_si128((const __m128i*) &pattern->scale[4]);
+  __m128i mask = _mm_set1_epi32((1 << bits) - 1);
+  uint32_t values[8];
+  for (size_t i = 0; i < count; i += 8, stream += bits) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*) stream);
+    __m128i low = _mm_mullo_epi32(_mm_shuffle_epi8(bytes, shuffle_low), scale_low);
+    __m128i high = _mm_mullo_epi32(_mm_shuffle_epi8(bytes, shuffle_high), scale_high);
+    low = _mm_and_si128(_mm_srli_epi32(low, 7), mask);
+    high = _mm_and_si128(_mm_srli_epi32(high, 7), mask);
+    if (palette != NULL) {
+      _mm_storeu_si128((__m128i*) &values[0], low);
+      _mm_storeu_si128((__m128i*) &values[4], high);
+      for (size_t j = 0; j < 8; j++) {
+        dest[i + j] = palette[values[j]];
+      }
+    } else {
+      _mm_storeu_si128((__m128i*) &dest[i], _mm_packus_epi32(low, high));
+    }
+  }
+}
+__attribute__((target("avx2")))
+static void mcp_chunk_extract_avx2(uint16_t* dest, size_t count, const uint8_t* stream, uint8_t bits, const int32_t* palette) {
+  mcp_chunk_pattern_t* pattern = &mcp_chunk_patterns[bits];
+  __m256i shuffle = _mm256_loadu_si256((const __m256i*) pattern->shuffle);
+  __m256i shift = _mm256_loadu_si256((const __m256i*) pattern->shift);
+  __m256i mask = _mm256_set1_epi32((1 << bits) - 1);
+  for (size_t i = 0; i < count; i += 8, stream += bits) {
+    __m256i bytes = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) stream));
+    __m256i values = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(bytes, shuffle), shift), mask);
+    if (palette != NULL) {
+      values = _mm256_i32gather_epi32(palette, values, sizeof(int32_t));
+    }
+    __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+    _mm_storeu_si128((__m128i*) &dest[i], words);
+  }
+}
+#endif /* MCP_CHUNK_X86 */
+
+/**
+ * @brief unpack bit-packed block states
+ *
+ * @param dest     destination states
+ * @param count    number of states, a multiple of 8 at most MCP_CHUNK_SECTION_BLOCKS
+ * @param longs    big-endian longs, mcp_chunk_longs() of them
+ * @param bits     bits per state, 1 to MCP_CHUNK_MAX_BITS
+ * @param spanning states are split across longs
+ * @param palette  palette of 1 << bits entries, NULL to keep the states
+ */
+void mcp_chunk_unpack(uint16_t* dest, size_t count, const char* longs, uint8_t bits, bool spanning, const int32_t* palette) {
+  assertd_false_custom("mcp_chunk_unpack", bits == 0 || bits > MCP_CHUNK_MAX_BITS, "invalid bits per block");
+  assertd_false_custom("mcp_chunk_unpack", count % 8 != 0 || count > MCP_CHUNK_SECTION_BLOCKS, "invalid block count");
+  uint64_t stream[MCP_CHUNK_STREAM_LONGS];
+  mcp_chunk_stream(stream, count, longs, bits, spanning);
+  #ifdef MCP_CHUNK_X86
+    if (__builtin_cpu_supports("avx2")) {
+      mcp_chunk_extract_avx2(dest, count, (const uint8_t*) stream, bits, palette);
+      return;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+      mcp_chunk_extract_sse41(dest, count, (const uint8_t*) stream, bits, palette);
+      return;
+    }
+  #endif /* MCP_CHUNK_X86 */
+  mcp_chunk_extract_scalar(dest, count, (const uint8_t*) stream, bits, palette);
+}
+
+/**
+ * @brief read a varint from a buffer checking its size
+ *
+ * @param src  source buffer
+ * @param dest destination value
+ *
+ * @return false if the varint is incomplete
+ */
+static inline bool mcp_chunk_varint(mcp_buffer_t* src, uint64_t* dest) {
+  size_t length = mcp_peek_varint(mcp_buffer_current(src), src->size - src->index, dest);
+  mcp_buffer_increment(src, length);
+  return length != 0;
+}
+
+/**
+ * @brief decode a chunk section
+ *
+ * @param section   destination section
+ * @param src       source buffer
+ * @param format    chunk data format
+ * @param sky_light section has sky light
+ *
+ * @return false if the section is malformed
+ */
+bool mcp_chunk_decode_section(mcp_chunk_section_t* section, mcp_buffer_t* src, mcp_chunk_format_t* format, bool sky_light) {
+  section->block_count = -1;
+  section->block_light = NULL;
+  section->sky_light = NULL;
+  if (format->block_count) {
+    if (src->size - src->index < sizeof(int16_t)) {
+      return false;
+    }
+    uint16_t count;
+    mcp_decode_be16(&count, src);
+    section->block_count = (int16_t) count;
+  }
+  if (src->size - src->index < sizeof(uint8_t)) {
+    return false;
+  }
+  uint8_t bits;
+  mcp_decode_byte(&bits, src);
+
+  int32_t palette[1 << MCP_CHUNK_PALETTE_BITS];
+  uint64_t length;
+  bool indirect = bits <= MCP_CHUNK_PALETTE_BITS;
+  if (indirect) {
+    bits = bits < 4 ? 4 : bits;
+    if (!mcp_chunk_varint(src, &length) || length > (1 << bits)) {
+      return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+      uint64_t state;
+      if (!mcp_chunk_varint(src, &state) || state > UINT16_MAX) {
+        return false;
+      }
+      palette[i] = state;
+    }
+    memset(&palette[length], 0, sizeof(palette) - length * sizeof(int32_t));
+  } else {
+    if (bits > MCP_CHUNK_MAX_BITS) {
+      return false;
+    }
+    if (format->direct_palette && !mcp_chunk_varint(src, &length)) {
+      return false;
+    }
+  }
+  section->bits = bits;
+
+  if (!mcp_chunk_varint(src, &length)
+      || length < mcp_chunk_longs(MCP_CHUNK_SECTION_BLOCKS, bits, format->spanning)
+      || length > (src->size - src->index) / sizeof(uint64_t)) {
+    return false;
+  }
+  mcp_chunk_unpack(section->blocks, MCP_CHUNK_SECTION_BLOCKS, mcp_buffer_current(src), bits, format->spanning, indirect ? palette : NULL);
+  mcp_buffer_increment(src, length * sizeof(uint64_t));
+
+  if (format->light) {
+    size_t light = sky_light ? 2 * MCP_CHUNK_LIGHT_SIZE : MCP_CHUNK_LIGHT_SIZE;
+    if (src->size - src->index < light) {
+      return false;
+    }
+    section->block_light = mcp_buffer_current(src);
+    section->sky_light = sky_light ? section->block_light + MCP_CHUNK_LIGHT_SIZE : NULL;
+    mcp_buffer_increment(src, light);
+  }
+  return true;
+}
+
+/**
+ * @brief decode the chunk data of a column
+ *
+ * @param column    destination column
+ * @param data      chunk data
+ * @param size      data size
+ * @param mask      primary bit mask of sent sections
+ * @param full      column is full
+ * @param sky_light sections have sky light
+ * @param format    chunk data format
+ *
+ * @return false if the data is malformed
+ */
+bool mcp_chunk_decode_column(mcp_chunk_column_t* column, char* data, size_t size, uint16_t mask, bool full, bool sky_light, mcp_chunk_format_t* format) {
+  mcp_buffer_t src = { 0 };
+  mcp_buffer_set(&src, data, size);
+  src.index = 0;
+  column->mask = 0;
+  column->biomes = NULL;
+  for (size_t i = 0; i < MCP_CHUNK_SECTIONS; i++) {
+    if (mask >> i & 1) {
+      if (!mcp_chunk_decode_section(&column->sections[i], &src, format, sky_light)) {
+        return false;
+      }
+      column->mask |= 1 << i;
+    }
+  }
+  if (full && format->biomes != 0) {
+    if (src.size - src.index < format->biomes) {
+      return false;
+    }
+    column->biomes = mcp_buffer_current(&src);
+  }
+  return true;
+}
+
+/**
+ * @brief write a group of 8 states into the stream
+ *
+ * @param stream destination of the group
+ * @param low    first 4 states joined into one chunk
+ * @param high   last 4 states joined into one chunk
+ * @param bits   bits per state
+ *
+ * @note 16 bytes are written, bytes after the group are zeroed
+ *         and overwritten by the next group
+ */
+static inline void mcp_chunk_group(uint8_t* stream, uint64_t low, uint64_t high, uint8_t bits) {
+  unsigned size = 4 * bits;
+  uint64_t words[2];
+  words[0] = htole64(size < 64 ? low | high << size : low);
+  words[1] = htole64(size < 64 ? high >> (64 - size) : high);
+  memcpy(stream, words, sizeof(words));
+}
+
+/**
+ * scalar packing kernel
+ */
+static void mcp_chunk_join_scalar(uint8_t* stream, const uint16_t* src, size_t count, uint8_t bits) {
+  uint64_t mask = ((uint64_t) 1 << bits) - 1;
+  uint64_t chunks[2];
+  for (size_t i = 0; i < count; i += 8, stream += bits) {
+    for (size_t j = 0; j < 2; j++) {
+      const uint16_t* states = &src[i + j * 4];
+      chunks[j] = (states[0] & mask)
+                | (states[1] & mask) << bits
+                | (states[2] & mask) << (2 * bits)
+                | (states[3] & mask) << (3 * bits);
+    }
+    mcp_chunk_group(stream, chunks[0], chunks[1], bits);
+  }
+}
+
+#ifdef MCP_CHUNK_X86
+/**
+ * vector packing kernels, pairs of 32-bit lanes are joined
+ * into 64-bit lanes and pairs of those into chunks of 4 states
+ */
+__attribute__((target("sse4.1")))
+static inline __m128i mcp_chunk_join4_sse41(__m128i values, __m128i mask, __m128i pair, __m128i quad) {
+  values = _mm_and_si128(values, mask);
+  values = _mm_or_si128(_mm_and_si128(values, _mm_set1_epi64x(0xFFFFFFFF)), _mm_srl_epi64(values, pair));
+  return _mm_or_si128(values, _mm_sll_epi64(_mm_srli_si128(values, 8), quad));
+}
+__attribute__((target("sse4.1")))
+static void mcp_chunk_join_sse41(uint8_t* stream, const uint16_t* src, size_t count, uint8_t bits) {
+  __m128i mask = _mm_set1_epi32((1 << bits) - 1);
+  __m128i pair = _mm_cvtsi32_si128(32 - bits);
+  __m128i quad = _mm_cvtsi32_si128(2 * bits);
+  uint64_t chunks[2];
+  for (size_t i = 0; i < count; i += 8, stream += bits) {
+    __m128i words = _mm_loadu_si128((const __m128i*) &src[i]);
+    __m128i low = mcp_chunk_join4_sse41(_mm_cvtepu16_epi32(words), mask, pair, quad);
+    __m128i high = mcp_chunk_join4_sse41(_mm_cvtepu16_epi32(_mm_srli_si128(words, 8)), mask, pair, quad);
+    _mm_storel_epi64((__m128i*) &chunks[0], low);
+    _mm_storel_epi64((__m128i*) &chunks[1], high);
+    mcp_chunk_group(stream, chunks[0], chunks[1], bits);
+  }
+}
+__attribute__((target("avx2")))
+static void mcp_chunk_join_avx2(uint8_t* stream, const uint16_t* src, size_t count, uint8_t bits) {
+  __m256i mask = _mm256_set1_epi32((1 << bits) - 1);
+  __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+  __m128i pair = _mm_cvtsi32_si128(32 - bits);
+  __m128i quad = _mm_cvtsi32_si128(2 * bits);
+  uint64_t chunks[4];
+  for (size_t i = 0; i < count; i += 8, stream += bits) {
+    __m256i values = _mm256_and_si256(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) &src[i])), mask);
+    values = _mm256_or_si256(_mm256_and_si256(values, low), _mm256_srl_epi64(values, pair));
+    values = _mm256_or_si256(values, _mm256_sll_epi64(_mm256_srli_si256(values, 8), quad));
+    _mm256_storeu_si256((__m256i*) chunks, values);
+    mcp_chunk_group(stream, chunks[0], chunks[2], bits);
+  }
+}
+#endif /* MCP_CHUNK_X86 */
+
+/**
+ * @brief turn a little-endian bit stream into longs
+ *
+ * @param longs    destination big-endian longs
+ * @param stream   source stream, zero-padded
+ * @param count    number of states
+ * @param bits     bits per state
+ * @param spanning states are split across longs
+ */
+static void mcp_chunk_unstream(char* longs, const uint64_t* stream, size_t count, uint8_t bits, bool spanning) {
+  size_t size = mcp_chunk_longs(count, bits, spanning);
+  uint64_t value;
+  if (spanning || 64 % bits == 0) {
+    for (size_t i = 0; i < size; i++) {
+      value = htobe64(le64toh(stream[i]));
+      memcpy(&longs[i * sizeof(uint64_t)], &value, sizeof(uint64_t));
+    }
+    return;
+  }
+  unsigned used = 64 / bits * bits;
+  uint64_t low = ((uint64_t) 1 << used) - 1;
+  const uint8_t* bytes = (const uint8_t*) stream;
+  uint64_t words[2];
+  for (size_t i = 0; i < size; i++) {
+    size_t bit = i * used;
+    unsigned shift = bit & 7;
+    memcpy(words, &bytes[bit >> 3], sizeof(words));
+    value = le64toh(words[0]) >> shift;
+    if (shift != 0) {
+      value |= le64toh(words[1]) << (64 - shift);
+    }
+    value = htobe64(value & low);
+    memcpy(&longs[i * sizeof(uint64_t)], &value, sizeof(uint64_t));
+  }
+}
+
+/**
+ * @brief pack block states into longs
+ *
+ * @param longs    destination big-endian longs, mcp_chunk_longs() of them
+ * @param src      source states
+ * @param count    number of states, a multiple of 8 at most MCP_CHUNK_SECTION_BLOCKS
+ * @param bits     bits per state, 1 to MCP_CHUNK_MAX_BITS
+ * @param spanning states are split across longs
+ */
+void mcp_chunk_pack(char* longs, const uint16_t* src, size_t count, uint8_t bits, bool spanning) {
+  assertd_false_custom("mcp_chunk_pack", bits == 0 || bits > MCP_CHUNK_MAX_BITS, "invalid bits per block");
+  assertd_false_custom("mcp_chunk_pack", count % 8 != 0 || count > MCP_CHUNK_SECTION_BLOCKS, "invalid block count");
+  uint64_t stream[MCP_CHUNK_STREAM_LONGS];
+  uint8_t* bytes = (uint8_t*) stream;
+  #ifdef MCP_CHUNK_X86
+    if (__builtin_cpu_supports("avx2")) {
+      mcp_chunk_join_avx2(bytes, src, count, bits);
+    } else if (__builtin_cpu_supports("sse4.1")) {
+      mcp_chunk_join_sse41(bytes, src, count, bits);
+    } else
+  #endif /* MCP_CHUNK_X86 */
+  mcp_chunk_join_scalar(bytes, src, count, bits);
+  memset(&bytes[count * bits / 8], 0, 2 * sizeof(uint64_t));
+  mcp_chunk_unstream(longs, stream, count, bits, spanning);
+}
+
+/**
+ * @brief build the palette of a section
+ *
+ * runs of 16 equal states are checked at once,
+ * other states are looked up in an open addressing table
+ *
+ * @param blocks  section states
+ * @param indices destination palette indices
+ * @param palette destination palette of 1 << MCP_CHUNK_PALETTE_BITS entries
+ * @param size    number of palette entries
+ *
+ * @return false if there are too many states for a palette
+ */
+bool mcp_chunk_palette(const uint16_t* blocks, uint16_t* indices, int32_t* palette, size_t* size) {
+  uint32_t slots[MCP_CHUNK_PALETTE_SLOTS];
+  memset(slots, 0, sizeof(slots));
+  size_t count = 0;
+  uint32_t previous = UINT32_MAX;
+  uint16_t index = 0;
+  for (size_t i = 0; i < MCP_CHUNK_SECTION_BLOCKS; i++) {
+    if (i % 16 == 0 && previous != UINT32_MAX) {
+      uint16_t difference = 0;
+      for (size_t j = 0; j < 16; j++) {
+        difference |= blocks[i + j] ^ previous;
+      }
+      if (difference == 0) {
+        for (size_t j = 0; j < 16; j++) {
+          indices[i + j] = index;
+        }
+        i += 15;
+        continue;
+      }
+    }
+    uint32_t state = blocks[i];
+    uint32_t key = (state + 1) << 8;
+    size_t slot = (state * 0x9E3779B1u) >> 23;
+    while (slots[slot] != 0 && (slots[slot] & ~0xFFu) != key) {
+      slot = (slot + 1) & (MCP_CHUNK_PALETTE_SLOTS - 1);
+    }
+    if (slots[slot] == 0) {
+      if (count == 1 << MCP_CHUNK_PALETTE_BITS) {
+        return false;
+      }
+      palette[count] = state;
+      slots[slot] = key | count;
+      count++;
+    }
+    previous = state;
+    index = slots[slot] & 0xFF;
+    indices[i] = index;
+  }
+  *size = count;
+  return true;
+}
+
+/**
+ * @brief encode a chunk section with the smallest palette
+ *
+ * @param section   source section, its bits are set to the chosen ones
+ * @param dest      destination buffer
+ * @param format    chunk data format
+ * @param sky_light section has sky light
+ */
+void mcp_chunk_encode_section(mcp_chunk_section_t* section, mcp_buffer_t* dest, mcp_chunk_format_t* format, bool sky_light) {
+  uint16_t indices[MCP_CHUNK_SECTION_BLOCKS];
+  int32_t palette[1 << MCP_CHUNK_PALETTE_BITS];
+  size_t size;
+  bool indirect = mcp_chunk_palette(section->blocks, indices, palette, &size);
+  uint8_t bits = format->global_bits;
+  if (indirect) {
+    for (bits = 4; ((size_t) 1 << bits) < size; bits++);
+  }
+  section->bits = bits;
+
+  if (format->block_count) {
+    int16_t count = section->block_count;
+    if (count < 0) {
+      count = 0;
+      for (size_t i = 0; i < MCP_CHUNK_SECTION_BLOCKS; i++) {
+        count += section->blocks[i] != 0;
+      }
+    }
+    mcp_encode_be16(count, dest);
+  }
+  mcp_encode_byte(bits, dest);
+  if (indirect) {
+    mcp_encode_varint(size, dest);
+    mcp_encode_varint_array(palette, size, dest);
+  } else if (format->direct_palette) {
+    mcp_encode_varint(0, dest);
+  }
+
+  size_t longs = mcp_chunk_longs(MCP_CHUNK_SECTION_BLOCKS, bits, format->spanning);
+  mcp_encode_varint(longs, dest);
+  mcp_buffer_reserve(dest, longs * sizeof(uint64_t));
+  if (indirect && size == 1) {
+    memset(mcp_buffer_current(dest), 0, longs * sizeof(uint64_t));
+  } else {
+    mcp_chunk_pack(mcp_buffer_current(dest), indirect ? indices : section->blocks, MCP_CHUNK_SECTION_BLOCKS, bits, format->spanning);
+  }
+  mcp_buffer_increment(dest, longs * sizeof(uint64_t));
+
+  if (format->light) {
+    mcp_buffer_reserve(dest, 2 * MCP_CHUNK_LIGHT_SIZE);
+    if (section->block_light != NULL) {
+      memcpy(mcp_buffer_current(dest), section->block_light, MCP_CHUNK_LIGHT_SIZE);
+    } else {
+      memset(mcp_buffer_current(dest), 0, MCP_CHUNK_LIGHT_SIZE);
+    }
+    mcp_buffer_increment(dest, MCP_CHUNK_LIGHT_SIZE);
+    if (sky_light) {
+      if (section->sky_light != NULL) {
+        memcpy(mcp_buffer_current(dest), section->sky_light, MCP_CHUNK_LIGHT_SIZE);
+      } else {
+        memset(mcp_buffer_current(dest), 0xFF, MCP_CHUNK_LIGHT_SIZE);
+      }
+      mcp_buffer_increment(dest, MCP_CHUNK_LIGHT_SIZE);
+    }
+  }
+}
+
+/**
+ * @brief encode the chunk data of a column
+ *
+ * @param column    source column, sections set in its mask are encoded
+ * @param dest      destination buffer
+ * @param full      column is full
+ * @param sky_light sections have sky light
+ * @param format    chunk data format
+ */
+void mcp_chunk_encode_column(mcp_chunk_column_t* column, mcp_buffer_t* dest, bool full, bool sky_light, mcp_chunk_format_t* format) {
+  for (size_t i = 0; i < MCP_CHUNK_SECTIONS; i++) {
+    if (column->mask >> i & 1) {
+      mcp_chunk_encode_section(&column->sections[i], dest, format, sky_light);
+    }
+  }
+  if (full && format->biomes != 0) {
+    mcp_buffer_reserve(dest, format->biomes);
+    if (column->biomes != NULL) {
+      memcpy(mcp_buffer_current(dest), column->biomes, format->biomes);
+    } else {
+      memset(mcp_buffer_current(dest), 0, format->biomes);
+    }
+    mcp_buffer_increment(dest, format->biomes);
+  }
+}
+
+/**
+ * @brief build the heightmaps of a column
+ *
+ * @param column     source column
+ * @param heightmaps destination compound with the motion blocking heightmap
+ * @param format     chunk data format
+ */
+void mcp_chunk_heightmaps(mcp_chunk_column_t* column, mcp_type_NbtTagCompound* heightmaps, mcp_chunk_format_t* format) {
+  uint16_t heights[MCP_CHUNK_HEIGHTMAP_SIZE];
+  memset(heights, 0, sizeof(heights));
+  size_t remaining = MCP_CHUNK_HEIGHTMAP_SIZE;
+  for (size_t section = MCP_CHUNK_SECTIONS; section-- > 0 && remaining != 0;) {
+    if (!(column->mask >> section & 1) || column->sections[section].block_count == 0) {
+      continue;
+    }
+    uint16_t* blocks = column->sections[section].blocks;
+    for (size_t y = 16; y-- > 0;) {
+      uint16_t height = section * 16 + y + 1;
+      uint16_t* layer = &blocks[y * MCP_CHUNK_HEIGHTMAP_SIZE];
+      for (size_t i = 0; i < MCP_CHUNK_HEIGHTMAP_SIZE; i++) {
+        heights[i] |= -(uint16_t) (heights[i] == 0) & -(uint16_t) (layer[i] != 0) & height;
+      }
+    }
+    remaining = 0;
+    for (size_t i = 0; i < MCP_CHUNK_HEIGHTMAP_SIZE; i++) {
+      remaining += heights[i] == 0;
+    }
+  }
+
+  size_t longs = mcp_chunk_longs(MCP_CHUNK_HEIGHTMAP_SIZE, MCP_CHUNK_HEIGHTMAP_BITS, format->spanning);
+  mcp_buffer_t buffer = { 0 };
+  mcp_buffer_allocate(&buffer, 64 + longs * sizeof(uint64_t));
+  mcp_nbt_write_tag(&buffer, MCP_NBT_TAG_COMPOUND, "");
+  mcp_nbt_write_tag(&buffer, MCP_NBT_TAG_LONG_ARRAY, "MOTION_BLOCKING");
+  mcp_encode_be32(longs, &buffer);
+  mcp_buffer_reserve(&buffer, longs * sizeof(uint64_t));
+  mcp_chunk_pack(mcp_buffer_current(&buffer), heights, MCP_CHUNK_HEIGHTMAP_SIZE, MCP_CHUNK_HEIGHTMAP_BITS, format->spanning);
+  mcp_buffer_increment(&buffer, longs * sizeof(uint64_t));
+  mcp_nbt_write_end(&buffer);
+  mcp_nbt_parse(heightmaps, buffer.data, buffer.index);
+  mcp_buffer_free(&buffer);
+}
+
+#if MCP_PROTOCOL_VERSION >= 751
+/**
+ * @brief create a map chunk packet from a column
+ *
+ * @param packet destination packet
+ * @param column source column
+ * @param x      column x coordinate
+ * @param z      column z coordinate
+ * @param biomes 1024 biome ids of a full column, NULL for a partial one
+ * @param data   buffer holding the chunk data, could be reused between packets
+ */
+void mcp_chunk_create_packet(mcp_packet_server_MapChunk* packet, mcp_chunk_column_t* column, int32_t x, int32_t z, int32_t* biomes, mcp_buffer_t* data) {
+  mcp_chunk_format_t format = mcp_chunk_format(MCP_PROTOCOL_VERSION);
+  data->index = 0;
+  mcp_chunk_encode_column(column, data, biomes != NULL, true, &format);
+
+  mcp_type_NbtTagCompound heightmaps;
+  mcp_chunk_heightmaps(column, &heightmaps, &format);
+  int64_t_vector_t biome_vector = { NULL, 0 };
+  if (biomes != NULL) {
+    biome_vector.size = 1024;
+    biome_vector.data = malloc(biome_vector.size * sizeof(int64_t));
+    assertd_not_null("mcp_chunk_create_packet", biome_vector.data);
+    for (size_t i = 0; i < biome_vector.size; i++) {
+      biome_vector.data[i] = biomes[i];
+    }
+  }
+  char_vector_t chunk_data = { data->data, data->index };
+  mcp_type_NbtTagCompound_vector_t block_entities = { NULL, 0 };
+  mcp_create_packet_server_MapChunk(packet, x, z, biomes != NULL, column->mask, heightmaps, biome_vector, chunk_data, block_entities);
+}
+#endif /* MCP_PROTOCOL_VERSION */
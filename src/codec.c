@@ -34,32 +34,54 @@ void mcp_encode_type_Slot(mcp_type_Slot* this, mcp_buffer_t* dest) {
     mcp_encode_varint(this->item_id, dest);
     mcp_encode_byte(this->item_count, dest);
     if(this->nbt_data.has_value) {
-      mcp_encode_type_NbtTagCompound(this->nbt_data.value, dest);
+      mcp_encode_type_NbtTagCompound(&this->nbt_data.value, dest);
     } else {
       mcp_encode_byte(MCP_NBT_TAG_END, dest);
     }
   }
 }
 void mcp_decode_type_Slot(mcp_type_Slot* this, mcp_buffer_t* src) {
+  this->nbt_data.has_value = false;
+  if (!mcp_buffer_check(src, sizeof(uint8_t))) {
+    this->present = false;
+    return;
+  }
   mcp_decode_byte(&this->present, src);
   if (this->present) {
     this->item_id = mcp_decode_varint(src);
+    if (!mcp_buffer_check(src, 2 * sizeof(uint8_t))) {
+      return;
+    }
     mcp_decode_byte((uint8_t*) &this->item_count, src);
     uint8_t tag;
     mcp_decode_byte(&tag, src);
-    if (tag == MCP_NBT_TAG_COMPOUND) {
-      this->nbt_data.has_value = true;
+    this->nbt_data.has_value = tag == MCP_NBT_TAG_COMPOUND;
+    if (this->nbt_data.has_value) {
       mcp_read_type_NbtTagCompound(&this->nbt_data.value, src);
+    } else if (tag != MCP_NBT_TAG_END) {
+      mcp_buffer_fail(src);
     }
   }
 }
+void mcp_skip_type_Slot(mcp_buffer_t* src) {
+  uint8_t present;
+  if (!mcp_buffer_check(src, sizeof(uint8_t))) {
+    return;
+  }
+  mcp_decode_byte(&present, src);
+  if (present) {
+    mcp_skip_varint(src);
+    mcp_buffer_skip(src, sizeof(int8_t));
+    mcp_skip_type_NbtTagCompound(src);
+  }
+}
 void mcp_length_type_Slot(mcp_type_Slot* this, size_t* length) {
   *length += sizeof(this->present);
   if (this->present) {
     *length += mcp_length_varint(this->item_id);
     *length += sizeof(this->item_count);
     if(this->nbt_data.has_value) {
-      *length += sizeof(this->nbt_data.value); /* todo nbt length */
+      mcp_length_type_NbtTagCompound(&this->nbt_data.value, length);
     } else {
       *length += sizeof(char);
     }
@@ -100,6 +122,9 @@ void mcp_decode_type_Particle(mcp_type_Particle* this, mcp_type_ParticleType p_t
       break;
 
     case MCP_DEFINED_PARTICLE_DUST:
+      if (!mcp_buffer_check(src, 4 * sizeof(float))) {
+        break;
+      }
       mcp_decode_be32((uint32_t*) &this->red, src);
       mcp_decode_be32((uint32_t*) &this->green, src);
       mcp_decode_be32((uint32_t*) &this->blue, src);
@@ -153,12 +178,21 @@ void mcp_encode_type_Smelting(mcp_type_Smelting* this, mcp_buffer_t* dest) {
 void mcp_decode_type_Smelting(mcp_type_Smelting* this, mcp_buffer_t* src) {
   mcp_decode_string(&this->group, src);
   this->ingredient.size = mcp_decode_varint(src);
-  this->ingredient.data = malloc(this->ingredient.size * sizeof(mcp_type_Slot));
+  this->result.present = false;
+  if (!mcp_buffer_check_count(src, this->ingredient.size, sizeof(uint8_t))) {
+    this->ingredient.size = 0;
+    this->ingredient.data = NULL;
+    return;
+  }
+  this->ingredient.data = mcp_buffer_decode_allocate(src, this->ingredient.size * sizeof(mcp_type_Slot));
   assertd_not_null("mcp_decode_type_Smelting", this->ingredient.data);
   for (size_t i = 0; i < this->ingredient.size; i++) {
     mcp_decode_type_Slot(&this->ingredient.data[i], src);
   }
   mcp_decode_type_Slot(&this->result, src);
+  if (!mcp_buffer_check(src, sizeof(float))) {
+    return;
+  }
   mcp_decode_bef32(&this->experience, src);
   this->cook_time = mcp_decode_varint(src);
 }
@@ -179,18 +213,19 @@ void mcp_length_type_Smelting(mcp_type_Smelting* this, size_t* length) {
 void mcp_encode_type_Tag(mcp_type_Tag* this, mcp_buffer_t* dest) {
   mcp_encode_string(this->tag_name, dest);
   mcp_encode_varint(this->entries.size, dest);
-  for (size_t i = 0; i < this->entries.size; i++) {
-    mcp_encode_varint(this->entries.data[i], dest);
-  }
+  mcp_encode_varint_array(this->entries.data, this->entries.size, dest);
 }
 void mcp_decode_type_Tag(mcp_type_Tag* this, mcp_buffer_t* src) { 
   mcp_decode_string(&this->tag_name, src);
   this->entries.size = mcp_decode_varint(src);
-  this->entries.data = malloc(this->entries.size * sizeof(int32_t));
-  assertd_not_null("mcp_decode_type_Smelting", this->entries.data);
-  for (size_t i = 0; i < this->entries.size; i++) {
-    this->entries.data[i] = mcp_decode_varint(src);
+  if (!mcp_buffer_check_count(src, this->entries.size, sizeof(uint8_t))) {
+    this->entries.size = 0;
+    this->entries.data = NULL;
+    return;
   }
+  this->entries.data = mcp_buffer_decode_allocate(src, this->entries.size * sizeof(int32_t));
+  assertd_not_null("mcp_decode_type_Tag", this->entries.data);
+  mcp_decode_varint_array(this->entries.data, this->entries.size, src);
 }
 void mcp_length_type_Tag(mcp_type_Tag* this, size_t* length) {
   mcp_length_string(this->tag_name, length);
@@ -223,15 +258,6 @@ void mcp_length_type_EntityEquipment(mcp_type_EntityEquipment* this, size_t* len
   mcp_length_type_Slot(&this->equipments.data[this->equipments.size - 1].item, length);
 }
 
-/**
- * minecraft entity metadata
- * 
- * @todo stub
- */
-void mcp_encode_type_EntityMetadata(mcp_type_EntityMetadata* this, mcp_buffer_t* dest) { }
-void mcp_decode_type_EntityMetadata(mcp_type_EntityMetadata* this, mcp_buffer_t* src) { }
-void mcp_length_type_EntityMetadata(mcp_type_EntityMetadata* this, size_t* length) { }
-
 /**
  * string
  * 
@@ -241,12 +267,17 @@ void mcp_length_type_EntityMetadata(mcp_type_EntityMetadata* this, size_t* lengt
 void mcp_encode_string(char* this, mcp_buffer_t* dest) {
   size_t length = strlen(this);
   mcp_encode_varint(length, dest);
+  mcp_buffer_reserve(dest, length);
   memcpy(mcp_buffer_current(dest), this, length);
   mcp_buffer_increment(dest, length);
 }
 void mcp_decode_string(char** this, mcp_buffer_t* src) {
   size_t length = mcp_decode_varint(src);
-  *this = malloc(length + 1);
+  if (!mcp_buffer_check(src, length)) {
+    *this = NULL;
+    return;
+  }
+  *this = mcp_buffer_decode_allocate(src, length + 1);
   (*this)[length] = 0;
   memcpy(*this, mcp_buffer_current(src), length);
   mcp_buffer_increment(src, length);
@@ -256,23 +287,41 @@ void mcp_decode_string(char** this, mcp_buffer_t* src) {
  * variable sized number
  */
 void mcp_encode_varint(uint64_t src, mcp_buffer_t* dest) {
-  for(; src >= 0x80; src >>= 7) {
-    *mcp_buffer_current(dest) = (char) 0x80 | (src & 0x7F);
-    mcp_buffer_increment(dest, 1);
-  }
-  *mcp_buffer_current(dest) = (char) src & 0x7F;
-  mcp_buffer_increment(dest, 1);
+  mcp_buffer_reserve(dest, 5);
+  mcp_buffer_increment(dest, mcp_put_varint(mcp_buffer_current(dest), (uint32_t) src));
 }
 uint64_t mcp_decode_varint(mcp_buffer_t* src) {
-  int i = 0;
-  char j;
-  uint64_t dest = 0;
-  do {
-    j = *mcp_buffer_current(src);
-    mcp_buffer_increment(src, 1);
-    dest |= ((j & 0b01111111) << i);
-    i += 7;
-  } while (j & 0b10000000);
+  if (src->index < src->size && !(src->data[src->index] & 0x80)) {
+    return (uint8_t) src->data[src->index++];
+  }
+  uint64_t dest;
+  size_t length = mcp_peek_varint(mcp_buffer_current(src), src->size - src->index, &dest);
+  if (length == 0 || length > 5) {
+    mcp_buffer_fail(src);
+    return 0;
+  }
+  mcp_buffer_increment(src, length);
+  return (uint64_t) (int64_t) (int32_t) dest;
+}
+
+/**
+ * variable sized long number
+ */
+void mcp_encode_varlong(uint64_t src, mcp_buffer_t* dest) {
+  mcp_buffer_reserve(dest, 10);
+  mcp_buffer_increment(dest, mcp_put_varlong(mcp_buffer_current(dest), src));
+}
+uint64_t mcp_decode_varlong(mcp_buffer_t* src) {
+  if (src->index < src->size && !(src->data[src->index] & 0x80)) {
+    return (uint8_t) src->data[src->index++];
+  }
+  uint64_t dest;
+  size_t length = mcp_peek_varint(mcp_buffer_current(src), src->size - src->index, &dest);
+  if (length == 0) {
+    mcp_buffer_fail(src);
+    return 0;
+  }
+  mcp_buffer_increment(src, length);
   return dest;
 }
 
@@ -301,8 +350,18 @@ uint64_t mcp_decode_stream_varint(mcp_stream_t src) {
 }
 
 /**
- * nbt stub
+ * variable sized number (from memory of limited size)
+ * 
+ * @return number of bytes read, or 0 if the number is incomplete
  */
-void mcp_encode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* dest) { }
-void mcp_decode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src) { }
-void mcp_read_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src) { }
\ No newline at end of file
+size_t mcp_peek_varint(char* src, size_t size, uint64_t* dest) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < size && i < 10; i++) {
+    value |= (uint64_t) (src[i] & 0x7F) << (7 * i);
+    if (!(src[i] & 0x80)) {
+      *dest = value;
+      return i + 1;
+    }
+  }
+  return 0;
+}
@@ -9,90 +9,565 @@
 #include "mcp/connection.h" /* this */
 #include "mcp/handler.h"    /* packet handlers */
 #include "mcp/codec.h"      /* encoders */
+#include "mcp/capture.h"    /* packet capture */
+#include "mcp/metrics.h"    /* packet metrics */
+#include "mcp/version.h"    /* version translation */
 #include "csafe/logf.h"     /* formatted logging */
-#include <stdlib.h>         /* realloc */
-#ifdef MCP_USE_ZLIB
-    #include <zlib.h>
-#else
-    #include <libdeflate.h>
-#endif /* MCP_USE_ZLIB */
+#include <string.h>         /* memset */
+#include <sys/socket.h>     /* send */
+#include <errno.h>          /* error codes */
 
     /* functions */
 /**
- * @brief interface for receiving packet
+ * @brief get compression state of a connection
+ * 
+ * @param context connection context
+ */
+static inline mcp_compression_t* mcp_context_compression(mcp_context_t* context) {
+    return context->compression != NULL ? context->compression : mcp_compression_thread();
+}
+
+/**
+ * @brief initialize a connection context
+ * 
+ * @param context connection context
+ * @param stream  connection stream
+ */
+void mcp_context_init(mcp_context_t* context, mcp_stream_t stream) {
+    memset(context, 0, sizeof(mcp_context_t));
+    mcp_buffer_bind(&context->buffer, stream);
+    mcp_input_init(&context->input, MCP_REGION_DEFAULT_LIMIT);
+    mcp_region_init(&context->frame, MCP_REGION_DEFAULT_LIMIT);
+    mcp_region_init(&context->packet, MCP_REGION_DEFAULT_LIMIT);
+    context->buffer.region = &context->packet;
+    mcp_output_init(&context->output, MCP_REGION_DEFAULT_LIMIT);
+    mcp_region_init(&context->inbound, MCP_REGION_DEFAULT_LIMIT);
+    mcp_region_init(&context->outbound, MCP_REGION_DEFAULT_LIMIT);
+}
+
+/**
+ * @brief free memory owned by a connection context
+ * 
+ * @param context connection context
+ */
+void mcp_context_free(mcp_context_t* context) {
+    mcp_input_free(&context->input);
+    mcp_region_free(&context->frame);
+    mcp_region_free(&context->packet);
+    mcp_output_free(&context->output);
+    mcp_region_free(&context->inbound);
+    mcp_region_free(&context->outbound);
+}
+
+/**
+ * @brief write a frame to a stream, or queue it if the context is corked
+ * 
+ * @param context connection context
+ * @param frame   the frame
+ * @param length  frame length
+ * 
+ * @return false if the stream failed
+ */
+static bool mcp_send_frame(mcp_context_t* context, char* frame, size_t length) {
+    size_t written = 0;
+    if (!context->corked && !mcp_output_pending(&context->output)) {
+        ssize_t result = send(context->buffer.stream, frame, length, MSG_NOSIGNAL);
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+        written = result < 0 ? 0 : result;
+    }
+    if (written < length) {
+        mcp_output_write(&context->output, frame + written, length - written);
+        if (!context->corked) {
+            return mcp_output_flush(&context->output, context->buffer.stream);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief check if raw frames could be passed to the peer of a connection
+ * 
+ * @param context connection context
+ * 
+ * @note frames are not passed raw when either context is captured,
+ *         so forwarded packets are recorded as decoded ones
+ */
+static inline bool mcp_receive_forwards(mcp_context_t* context) {
+    return context->peer != NULL && context->peer->compression_threshold == context->compression_threshold
+        && mcp_version_get(context->peer) == mcp_version_get(context)
+        && context->capture == NULL && context->peer->capture == NULL;
+}
+
+/**
+ * @brief find the translation of a received packet to the library version
+ * 
+ * @param context connection context
+ * @param id      packet id, replaced with the library packet id
+ * 
+ * @return NULL if packets of the connection are not translated
+ */
+static inline const mcp_translation_t* mcp_receive_translation(mcp_context_t* context, mcp_packet_id_t* id) {
+    if (!mcp_version_translated(context)) {
+        return NULL;
+    }
+    const mcp_translation_t* translation = &context->protocol->inbound[context->state][context->source][*id];
+    *id = translation->id;
+    return translation;
+}
+
+/**
+ * @brief translate an unpacked packet to the library version
+ * 
+ * @param context     connection context
+ * @param translation translation of the packet
+ * 
+ * @return false if the packet is dropped or malformed
+ */
+static inline bool mcp_receive_translate(mcp_context_t* context, const mcp_translation_t* translation) {
+    return translation->mode != MCP_TRANSLATION_DROP && mcp_version_translate(translation, &context->buffer, &context->inbound);
+}
+
+/**
+ * @brief check if the next frame should be forwarded, reading only its beginning
  * 
  * @param context connection context
+ * @param header  frame header length
+ * @param length  frame length
+ * @param id      pointer to the packet id
+ * @param size    pointer to the uncompressed packet length
+ * 
+ * @return false if the packet is not forwarded or its id could not be peeked
  */
-void mcp_receive(mcp_context_t* context) {
-    size_t length = mcp_decode_stream_varint(context->buffer.stream);
+static bool mcp_receive_forwarded(mcp_context_t* context, size_t header, uint64_t length, mcp_packet_id_t* id, size_t* size) {
+    size_t peek = length < MCP_BUFFER_HEADROOM ? length : MCP_BUFFER_HEADROOM;
+    if (!mcp_input_fill(&context->input, context->buffer.stream, header + peek)) {
+        return false;
+    }
+    char* frame = mcp_input_current(&context->input) + header;
+    size_t available = mcp_input_available(&context->input) - header;
+    if (available > length) {
+        available = length;
+    }
+    char id_data[MCP_BUFFER_HEADROOM];
+    char* id_start = frame;
+    size_t id_size = available;
+    *size = length;
     if (context->compression_threshold > 0) {
-        size_t uncompressed_size = mcp_decode_stream_varint(context->buffer.stream);
-        size_t compressed_size = length - mcp_length_varlong(uncompressed_size);
+        uint64_t uncompressed_size;
+        size_t data_header = mcp_peek_varint(frame, available, &uncompressed_size);
+        if (data_header == 0) {
+            return false;
+        }
+        id_start = frame + data_header;
+        id_size = available - data_header;
+        *size = length - data_header;
+        if (uncompressed_size != 0) {
+            id_start = id_data;
+            id_size = mcp_decompress_prefix(mcp_context_compression(context), frame + data_header, available - data_header, id_data, sizeof(id_data));
+            *size = uncompressed_size;
+        }
+    }
+    uint64_t wire_id;
+    if (mcp_peek_varint(id_start, id_size, &wire_id) == 0 || wire_id >= mcp_version_get(context)->max_ids[context->state][context->source]) {
+        return false;
+    }
+    *id = wire_id;
+    const mcp_translation_t* translation = mcp_receive_translation(context, id);
+    return (translation == NULL || translation->mode != MCP_TRANSLATION_DROP) && mcp_handler_find(context, *id) == mcp_handler_Forward;
+}
+
+/**
+ * @brief pass a raw frame to the peer of a connection
+ * 
+ * @param context connection context
+ * @param id      packet id
+ * @param size    frame size including its header
+ * @param length  uncompressed packet length
+ * 
+ * @return false if the stream or the peer stream was closed
+ * @note the part of the frame which is not read ahead is spliced
+ *         from stream to stream when the peer has no queued output
+ * @note the frame is counted as received by the context and as sent
+ *         by the peer, without a handler time
+ */
+static bool mcp_receive_forward(mcp_context_t* context, mcp_packet_id_t id, size_t size, size_t length) {
+    mcp_context_t* peer = context->peer;
+    if (context->metrics != NULL) {
+        mcp_metrics_sent(mcp_metrics_get(context->metrics, context->state, context->source, id), size, length);
+    }
+    if (peer->metrics != NULL) {
+        mcp_metrics_sent(mcp_metrics_get(peer->metrics, peer->state, context->source, id), size, length);
+    }
+    size_t buffered = mcp_input_available(&context->input) < size ? mcp_input_available(&context->input) : size;
+    if (!mcp_send_frame(peer, mcp_input_current(&context->input), buffered)) {
+        return false;
+    }
+    mcp_input_consume(&context->input, buffered);
+    size -= buffered;
+    if (size > 0 && !peer->corked && !mcp_output_pending(&peer->output)) {
+        size -= mcp_output_splice(&peer->output, context->buffer.stream, peer->buffer.stream, size);
+    }
+    if (size > 0) {
+        if (!mcp_input_fill(&context->input, context->buffer.stream, size)) {
+            return false;
+        }
+        if (!mcp_send_frame(peer, mcp_input_current(&context->input), size)) {
+            return false;
+        }
+        mcp_input_consume(&context->input, size);
+    }
+    mcp_input_release(&context->input);
+    return true;
+}
+
+/**
+ * @brief set the buffer of a connection to the packet of a frame
+ * 
+ * @param context connection context
+ * @param frame   frame without its length header
+ * @param length  frame length
+ * 
+ * @return false if the frame is malformed
+ */
+static bool mcp_receive_unpack(mcp_context_t* context, char* frame, size_t length) {
+    if (context->compression_threshold > 0) {
+        uint64_t uncompressed_size;
+        size_t data_header = mcp_peek_varint(frame, length, &uncompressed_size);
+        if (data_header == 0 || uncompressed_size > MCP_PACKET_MAX_LENGTH) {
+            return false;
+        }
         if (uncompressed_size == 0) {
-            mcp_buffer_allocate(&context->buffer, compressed_size);
-            mcp_buffer_init(&context->buffer);
+            mcp_buffer_set(&context->buffer, frame + data_header, length - data_header);
         } else {
-            char* compressed = malloc(compressed_size);
-            assertd_not_null("mcp_receive", compressed);
-            mcp_stream_read(context->buffer.stream, compressed, compressed_size);
-            mcp_buffer_allocate(&context->buffer, uncompressed_size);
-            #ifdef MCP_USE_ZLIB
-                uncompress((Bytef*) context->buffer.data, (uLongf*) &uncompressed_size, (Bytef*) compressed, (uLong) compressed_size);
-            #else
-                struct libdeflate_decompressor* decompressor = libdeflate_alloc_decompressor();
-                libdeflate_zlib_decompress(decompressor, compressed, compressed_size, context->buffer.data, context->buffer.size, NULL);
-                libdeflate_free_decompressor(decompressor);
-            #endif /* MCP_USE_ZLIB */
-            free(compressed);
+            mcp_buffer_set(&context->buffer, mcp_region_reserve(&context->frame, uncompressed_size), uncompressed_size);
+            if (!mcp_decompress(mcp_context_compression(context), frame + data_header, length - data_header, context->buffer.data, uncompressed_size)) {
+                mcp_region_release(&context->frame);
+                return false;
+            }
         }
     } else {
-        mcp_buffer_allocate(&context->buffer, length);
-        mcp_buffer_init(&context->buffer);
+        mcp_buffer_set(&context->buffer, frame, length);
     }
-    #ifdef NDEBUG
-        mcp_handler_t* handler = mcp_handler_get(context->state, context->source, mcp_decode_varint(&context->buffer));
-    #else
-        mcp_packet_id_t id = mcp_decode_varint(&context->buffer);
-        logd_f("mcp_receive", "packet %u::%s with length %zu", id, mcp_protocol_cstrings[context->state][context->source][id], length);
-        mcp_handler_t* handler = mcp_handler_get(context->state, context->source, id);
-    #endif /* NDEBUG */
-    handler(context);
-    mcp_buffer_free(&context->buffer);
+    context->buffer.index = 0;
+    return true;
 }
 
 /**
- * @brief interface for sending packets
+ * @brief pass an unpacked packet to its handler
+ * 
+ * @param context connection context
+ * @param id      packet id
+ * @param handler packet handler
+ * @param length  frame length including its header
  * 
- * @param context connection context with filled buffer
+ * @return false if the handler decoded the packet past its end
  */
-void mcp_send(mcp_context_t* context) {
-    if (context->compression_threshold > 0) {
-        if (context->buffer.size > context->compression_threshold) {
-            #ifdef MCP_USE_ZLIB
-                size_t compressed_size = compressBound(context->buffer.size);
-            #else
-                struct libdeflate_compressor* compressor = libdeflate_alloc_compressor(6);
-                size_t compressed_size = libdeflate_zlib_compress_bound(compressor, context->buffer.size);
-            #endif /* MCP_USE_ZLIB */
-            char* compressed = malloc(compressed_size);
-            assertd_not_null("mcp_receive", compressed);
-            #ifdef MCP_USE_ZLIB
-                compress((Bytef*) compressed, (uLongf*) &compressed_size, (Bytef*) context->buffer.data, (uLong) context->buffer.size);
-            #else
-                libdeflate_zlib_compress(compressor, context->buffer.data, context->buffer.size, compressed, compressed_size);
-                libdeflate_free_compressor(compressor);
-            #endif /* MCP_USE_ZLIB */
-            mcp_encode_stream_varint(compressed_size + mcp_length_varlong(context->buffer.size), context->buffer.stream);
-            mcp_encode_stream_varint(context->buffer.size, context->buffer.stream);
-            mcp_buffer_free(&context->buffer);
-            mcp_buffer_set(&context->buffer, realloc(compressed, compressed_size), compressed_size);
-        } else {
-            mcp_encode_stream_varint(context->buffer.size + mcp_length_varlong(0), context->buffer.stream);
-            mcp_encode_stream_varint(0, context->buffer.stream);
+static inline bool mcp_receive_handle(mcp_context_t* context, mcp_packet_id_t id, mcp_handler_t* handler, size_t length) {
+    if (context->metrics != NULL) {
+        mcp_metrics_packet_t* metrics = mcp_metrics_get(context->metrics, context->state, context->source, id);
+        size_t size = context->buffer.size;
+        uint64_t start = mcp_metrics_now();
+        handler(context);
+        mcp_metrics_received(metrics, length, size, mcp_metrics_now() - start);
+    } else {
+        handler(context);
+    }
+    if (context->buffer.arena != NULL) {
+        mcp_arena_reset(context->buffer.arena);
+    }
+    return !context->buffer.failed;
+}
+
+/**
+ * @brief interface for receiving packet
+ * 
+ * @param context connection context
+ * 
+ * @return false if the stream was closed or the frame is malformed
+ */
+bool mcp_receive(mcp_context_t* context) {
+    uint64_t length;
+    size_t header;
+    while ((header = mcp_peek_varint(mcp_input_current(&context->input), mcp_input_available(&context->input), &length)) == 0) {
+        if (mcp_input_available(&context->input) >= 5 || !mcp_input_fill(&context->input, context->buffer.stream, mcp_input_available(&context->input) + 1)) {
+            return false;
         }
+    }
+    if (length > MCP_PACKET_MAX_LENGTH) {
+        return false;
+    }
+    mcp_packet_id_t id;
+    size_t size;
+    if (mcp_receive_forwards(context) && mcp_receive_forwarded(context, header, length, &id, &size)) {
+        return mcp_receive_forward(context, id, header + length, size);
+    }
+    if (!mcp_input_fill(&context->input, context->buffer.stream, header + length)) {
+        return false;
+    }
+    if (!mcp_receive_unpack(context, mcp_input_current(&context->input) + header, length)) {
+        return false;
+    }
+    uint64_t wire_id = mcp_decode_varint(&context->buffer);
+    if (context->buffer.failed || wire_id >= mcp_version_get(context)->max_ids[context->state][context->source]) {
+        mcp_region_release(&context->frame);
+        return false;
+    }
+    id = wire_id;
+    if (context->state == MCP_STATE_HANDSHAKING && context->protocol == NULL) {
+        mcp_version_handshake(context);
+    }
+    const mcp_translation_t* translation = mcp_receive_translation(context, &id);
+    mcp_handler_t* handler = translation == NULL || translation->mode != MCP_TRANSLATION_DROP ? mcp_handler_find(context, id) : NULL;
+    if (handler == mcp_handler_Forward && mcp_receive_forwards(context)) {
+        size = context->buffer.size;
+        mcp_region_release(&context->frame);
+        return mcp_receive_forward(context, id, header + length, size);
+    }
+    if (context->capture != NULL) {
+        mcp_capture_packet(context->capture, context, context->source, mcp_input_current(&context->input), header + length, context->buffer.data, context->buffer.size);
+    }
+    bool handled;
+    if (translation != NULL && !mcp_receive_translate(context, translation)) {
+        handled = !context->buffer.failed;
     } else {
-        mcp_encode_stream_varint(context->buffer.size, context->buffer.stream);
+        logd_f("mcp_receive", "packet %u::%s with length %zu", id, mcp_protocol_packets[context->state][context->source][id].name, length);
+        handled = mcp_receive_handle(context, id, handler, header + length);
     }
-    mcp_buffer_flush(&context->buffer);
-    mcp_buffer_free(&context->buffer);
-}
\ No newline at end of file
+    mcp_input_consume(&context->input, header + length);
+    mcp_input_release(&context->input);
+    mcp_region_release(&context->frame);
+    mcp_region_release(&context->inbound);
+    return handled;
+}
+
+/**
+ * @brief receive a frame which is already in memory
+ * 
+ * @param context connection context
+ * @param frame   frame without its length header
+ * @param length  frame length
+ * 
+ * @return false if the frame is malformed
+ */
+bool mcp_receive_frame(mcp_context_t* context, char* frame, size_t length) {
+    if (!mcp_receive_unpack(context, frame, length)) {
+        return false;
+    }
+    uint64_t wire_id;
+    size_t id_size = mcp_peek_varint(context->buffer.data, context->buffer.size, &wire_id);
+    if (id_size == 0 || wire_id >= mcp_version_get(context)->max_ids[context->state][context->source]) {
+        mcp_region_release(&context->frame);
+        return false;
+    }
+    context->buffer.index = id_size;
+    if (context->state == MCP_STATE_HANDSHAKING && context->protocol == NULL) {
+        mcp_version_handshake(context);
+    }
+    mcp_packet_id_t id = wire_id;
+    const mcp_translation_t* translation = mcp_receive_translation(context, &id);
+    bool handled;
+    if (translation != NULL && !mcp_receive_translate(context, translation)) {
+        handled = !context->buffer.failed;
+    } else {
+        handled = mcp_receive_handle(context, id, mcp_handler_find(context, id), mcp_length_varlong(length) + length);
+    }
+    mcp_region_release(&context->frame);
+    mcp_region_release(&context->inbound);
+    return handled;
+}
+
+/**
+ * @brief check if a whole packet is already buffered
+ * 
+ * @param context connection context
+ */
+bool mcp_receive_pending(mcp_context_t* context) {
+    uint64_t length;
+    size_t header = mcp_peek_varint(mcp_input_current(&context->input), mcp_input_available(&context->input), &length);
+    return header != 0 && mcp_input_available(&context->input) >= header + length;
+}
+
+/**
+ * @brief receive every packet that is already buffered, without reading from the stream
+ * 
+ * @param context connection context
+ * 
+ * @return number of received packets, or -1 if the stream is malformed
+ */
+int mcp_receive_buffered(mcp_context_t* context) {
+    int count = 0;
+    while (mcp_receive_pending(context)) {
+        if (!mcp_receive(context)) {
+            return -1;
+        }
+        count++;
+    }
+    uint64_t length;
+    size_t header = mcp_peek_varint(mcp_input_current(&context->input), mcp_input_available(&context->input), &length);
+    if (header == 0 ? mcp_input_available(&context->input) >= 5 : length > MCP_PACKET_MAX_LENGTH) {
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * @brief write a frame header into the space reserved before a payload
+ * 
+ * @param context connection context
+ * @param payload payload preceded by MCP_BUFFER_HEADROOM bytes
+ * @param length  payload length
+ * @param size    uncompressed data size, zero if the payload is not compressed
+ * 
+ * @return pointer to the frame
+ */
+static char* mcp_send_header(mcp_context_t* context, char* payload, size_t length, size_t size) {
+    char header_data[MCP_BUFFER_HEADROOM * 2]; /* varint encoder reserves the longest varint */
+    mcp_buffer_t header = { 0 };
+    mcp_buffer_set(&header, header_data, sizeof(header_data));
+    if (context->compression_threshold > 0) {
+        mcp_encode_varint(length + mcp_length_varlong(size), &header);
+        mcp_encode_varint(size, &header);
+    } else {
+        mcp_encode_varint(length, &header);
+    }
+    memcpy(payload - header.index, header_data, header.index);
+    return payload - header.index;
+}
+
+/**
+ * @brief send a packet without compressing it
+ * 
+ * @param context      connection context
+ * @param packet       packet preceded by MCP_BUFFER_HEADROOM bytes
+ * @param length       packet length
+ * @param frame_length pointer to the frame length
+ * 
+ * @return false if the stream failed
+ */
+static bool mcp_send_uncompressed(mcp_context_t* context, char* packet, size_t length, size_t* frame_length) {
+    char* frame = mcp_send_header(context, packet, length, 0);
+    *frame_length = length + (packet - frame);
+    if (context->capture != NULL) {
+        mcp_capture_packet(context->capture, context, MCP_SOURCE__MAX - 1 - context->source, frame, *frame_length, packet, length);
+    }
+    return mcp_send_frame(context, frame, *frame_length);
+}
+
+/**
+ * @brief compress a packet straight into the output queue
+ * 
+ * @param context      connection context
+ * @param packet       uncompressed packet preceded by MCP_BUFFER_HEADROOM bytes
+ * @param length       packet length
+ * @param frame_length pointer to the frame length
+ * 
+ * @return false if the stream failed
+ * @note frame header is written before the compressed data in the same
+ *         reserved space, so the frame is queued without copies
+ * @note a packet which could not be compressed is sent uncompressed
+ */
+static bool mcp_send_compressed(mcp_context_t* context, char* packet, size_t length, size_t* frame_length) {
+    mcp_compression_t* compression = mcp_context_compression(context);
+    size_t bound = mcp_compression_bound(compression, length);
+    char* space = mcp_output_reserve(&context->output, MCP_BUFFER_HEADROOM + bound);
+    char* payload = space + MCP_BUFFER_HEADROOM;
+    size_t compressed_size = mcp_compress(compression, packet, length, payload, bound);
+    if (compressed_size == 0) {
+        return mcp_send_uncompressed(context, packet, length, frame_length);
+    }
+    char* frame = mcp_send_header(context, payload, compressed_size, length);
+    *frame_length = payload + compressed_size - frame;
+    if (context->capture != NULL) {
+        mcp_capture_packet(context->capture, context, MCP_SOURCE__MAX - 1 - context->source, frame, *frame_length, packet, length);
+    }
+    mcp_output_commit(&context->output, frame - space, *frame_length);
+    if (!context->corked) {
+        return mcp_output_flush(&context->output, context->buffer.stream);
+    }
+    return true;
+}
+
+/**
+ * @brief release the memory of a sent packet
+ * 
+ * @param context connection context
+ */
+static inline void mcp_send_release(mcp_context_t* context) {
+    if (context->buffer.region != NULL) {
+        mcp_region_release(context->buffer.region);
+    } else {
+        mcp_buffer_free(&context->buffer);
+    }
+    mcp_region_release(&context->outbound);
+}
+
+/**
+ * @brief translate an encoded packet to the version of a connection
+ * 
+ * @param context connection context
+ * @param id      library packet id
+ * @param id_size packet id length
+ * @param packet  pointer to the packet, replaced with the translated one
+ * @param length  pointer to the packet length, replaced too
+ * 
+ * @return false if the packet is dropped
+ * @note the translated packet is preceded by MCP_BUFFER_HEADROOM bytes too
+ */
+static bool mcp_send_translate(mcp_context_t* context, mcp_packet_id_t id, size_t id_size, char** packet, size_t* length) {
+    const mcp_translation_t* translation = &context->protocol->outbound[context->state][MCP_SOURCE__MAX - 1 - context->source][id];
+    if (translation->mode == MCP_TRANSLATION_DROP) {
+        return false;
+    }
+    mcp_buffer_t buffer = { 0 };
+    mcp_buffer_set(&buffer, *packet, *length);
+    buffer.index = id_size;
+    if (!mcp_version_translate(translation, &buffer, &context->outbound)) {
+        return false;
+    }
+    *packet = buffer.data;
+    *length = buffer.size;
+    return true;
+}
+
+/**
+ * @brief interface for sending packets
+ * 
+ * @param context connection context with a packet encoded into the buffer
+ */
+bool mcp_send(mcp_context_t* context) {
+    char* packet = mcp_buffer_packet(&context->buffer);
+    size_t length = mcp_buffer_packet_length(&context->buffer);
+    mcp_source_t source = MCP_SOURCE__MAX - 1 - context->source;
+    uint64_t id;
+    size_t id_size = mcp_peek_varint(packet, length, &id);
+    bool known = id_size != 0 && id < mcp_protocol_max_ids[context->state][source];
+    if (known && mcp_version_translated(context) && !mcp_send_translate(context, id, id_size, &packet, &length)) {
+        mcp_send_release(context);
+        return true;
+    }
+    size_t frame_length;
+    bool sent;
+    if (context->compression_threshold > 0 && length > context->compression_threshold) {
+        sent = mcp_send_compressed(context, packet, length, &frame_length);
+    } else {
+        sent = mcp_send_uncompressed(context, packet, length, &frame_length);
+    }
+    if (context->metrics != NULL && known) {
+        mcp_metrics_sent(mcp_metrics_get(context->metrics, context->state, source, id), frame_length, length);
+    }
+    mcp_send_release(context);
+    return sent;
+}
+
+/**
+ * @brief write all queued packets with a single call
+ * 
+ * @param context connection context
+ * 
+ * @return false if the stream failed
+ */
+bool mcp_flush(mcp_context_t* context) {
+    return mcp_output_flush(&context->output, context->buffer.stream);
+}
@@ -7,6 +7,8 @@
  */
     /* includes */
 #include "mcp/handler.h" /* this */
+#include <stdlib.h>      /* malloc */
+#include <string.h>      /* memcpy */
 
     /* functions */
 /**
@@ -14,4 +16,52 @@
  * 
  * @param context connection context
  */
-void mcp_handler_Blank(mcp_context_t* context) { }
\ No newline at end of file
+void mcp_handler_Blank(mcp_context_t* context) { }
+
+/**
+ * @brief forwarding packet handler
+ * 
+ * @param context connection context
+ */
+void mcp_handler_Forward(mcp_context_t* context) {
+    mcp_context_t* peer = context->peer;
+    if (peer != NULL) {
+        mcp_buffer_begin(&peer->buffer, context->buffer.size);
+        memcpy(mcp_buffer_current(&peer->buffer), context->buffer.data, context->buffer.size);
+        mcp_buffer_increment(&peer->buffer, context->buffer.size);
+        mcp_send(peer);
+    }
+}
+
+/**
+ * @brief initialize a handler table with a copy of the global handlers
+ * 
+ * @param table pointer to the handler table
+ */
+void mcp_handler_table_init(mcp_handler_table_t* table) {
+    size_t count = 0;
+    for (int state = 0; state < MCP_STATE__MAX; state++) {
+        for (int source = 0; source < MCP_SOURCE__MAX; source++) {
+            count += mcp_protocol_max_ids[state][source];
+        }
+    }
+    mcp_handler_t** handlers = malloc(count * sizeof(mcp_handler_t*));
+    assertd_not_null("mcp_handler_table_init", handlers);
+    for (int state = 0; state < MCP_STATE__MAX; state++) {
+        for (int source = 0; source < MCP_SOURCE__MAX; source++) {
+            size_t size = mcp_protocol_max_ids[state][source];
+            memcpy(handlers, mcp_protocol_handlers[state][source], size * sizeof(mcp_handler_t*));
+            table->handlers[state][source] = handlers;
+            handlers += size;
+        }
+    }
+}
+
+/**
+ * @brief free a handler table
+ * 
+ * @param table pointer to the handler table
+ */
+void mcp_handler_table_free(mcp_handler_table_t* table) {
+    free(table->handlers[0][0]);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file arena.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief bump allocated memory for decoded packets
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/io/arena.h"  /* this */
+#include "csafe/assertd.h" /* debug assertions */
+
+    /* functions */
+/**
+ * @brief add a block large enough for an allocation
+ *
+ * @param arena pointer to the arena
+ * @param size  aligned allocation size
+ *
+ * @return pointer to the allocated memory
+ */
+void* mcp_arena_grow(mcp_arena_t* arena, size_t size) {
+    size_t block_size = arena->block != NULL ? arena->block->size * 2 : MCP_ARENA_BLOCK_SIZE;
+    while (block_size < size) {
+        block_size *= 2;
+    }
+    mcp_arena_block_t* block = malloc(sizeof(mcp_arena_block_t) + block_size);
+    assertd_not_null("mcp_arena_grow", block);
+    block->next = arena->block;
+    block->size = block_size;
+    arena->block = block;
+    arena->used = size;
+    return block->data;
+}
+
+/**
+ * @brief release every allocation of an arena
+ *
+ * @param arena pointer to the arena
+ */
+void mcp_arena_reset(mcp_arena_t* arena) {
+    mcp_arena_block_t* block = arena->block;
+    if (block == NULL) {
+        return;
+    }
+    if (block->next != NULL) {
+        mcp_arena_block_t* next = block->next;
+        block->next = NULL;
+        while (next != NULL) {
+            mcp_arena_block_t* previous = next;
+            next = next->next;
+            free(previous);
+        }
+    }
+    if (arena->limit != 0 && block->size > arena->limit) {
+        free(block);
+        arena->block = NULL;
+    }
+    arena->used = 0;
+}
+
+/**
+ * @brief free an arena
+ *
+ * @param arena pointer to the arena
+ */
+void mcp_arena_free(mcp_arena_t* arena) {
+    mcp_arena_reset(arena);
+    free(arena->block);
+    arena->block = NULL;
+}
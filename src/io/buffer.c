@@ -0,0 +1,32 @@
+/**
+ * @file buffer.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief buffered io
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/io/buffer.h" /* this */
+#include "csafe/assertd.h" /* debug assertions */
+
+    /* functions */
+/**
+ * @brief grow a buffer to at least size bytes, preserving its contents
+ *
+ * @param buffer pointer to the buffer
+ * @param size   required size
+ */
+void mcp_buffer_grow(mcp_buffer_t* buffer, size_t size) {
+    if (buffer->region != NULL) {
+        buffer->data = mcp_region_reserve(buffer->region, size);
+        buffer->size = buffer->region->capacity;
+        return;
+    }
+    size_t capacity = buffer->size * 2;
+    if (capacity < size) {
+        capacity = size;
+    }
+    buffer->data = realloc(buffer->data, capacity);
+    assertd_not_null("mcp_buffer_grow", buffer->data);
+    buffer->size = capacity;
+}
@@ -0,0 +1,271 @@
+/**
+ * @file compression.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief cached zlib/libdeflate compression state
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/io/compression.h" /* this */
+#include "csafe/assertd.h"      /* debug assertions */
+#include <stdlib.h>             /* memory allocation */
+#ifdef MCP_USE_ZLIB
+    #include <zlib.h>
+#else
+    #include <libdeflate.h>
+#endif /* MCP_USE_ZLIB */
+
+    /* variables */
+/**
+ * @brief compression state shared by connections of the current thread
+ */
+static __thread mcp_compression_t mcp_compression_thread_state;
+
+    /* functions */
+/**
+ * @brief get effective compression level
+ *
+ * @param compression pointer to the compression state
+ */
+static inline int mcp_compression_get_level(mcp_compression_t* compression) {
+    return compression->level == 0 ? MCP_COMPRESSION_DEFAULT_LEVEL : compression->level;
+}
+
+#ifdef MCP_USE_ZLIB
+/**
+ * @brief get cached deflate stream, allocating it on first use
+ *
+ * @param compression pointer to the compression state
+ */
+static z_stream* mcp_compression_get_compressor(mcp_compression_t* compression) {
+    if (compression->compressor == NULL) {
+        z_stream* stream = calloc(1, sizeof(z_stream));
+        assertd_not_null("mcp_compression_get_compressor", stream);
+        #ifdef NDEBUG
+            deflateInit(stream, mcp_compression_get_level(compression));
+        #else
+            int result = deflateInit(stream, mcp_compression_get_level(compression));
+            assertd_true_custom("mcp_compression_get_compressor", result == Z_OK, "unable to initialize deflate stream");
+        #endif /* NDEBUG */
+        compression->compressor = stream;
+    }
+    return compression->compressor;
+}
+
+/**
+ * @brief get cached inflate stream, allocating it on first use
+ *
+ * @param compression pointer to the compression state
+ */
+static z_stream* mcp_compression_get_decompressor(mcp_compression_t* compression) {
+    if (compression->decompressor == NULL) {
+        z_stream* stream = calloc(1, sizeof(z_stream));
+        assertd_not_null("mcp_compression_get_decompressor", stream);
+        #ifdef NDEBUG
+            inflateInit(stream);
+        #else
+            int result = inflateInit(stream);
+            assertd_true_custom("mcp_compression_get_decompressor", result == Z_OK, "unable to initialize inflate stream");
+        #endif /* NDEBUG */
+        compression->decompressor = stream;
+    }
+    return compression->decompressor;
+}
+#else
+/**
+ * @brief get cached libdeflate compressor, allocating it on first use
+ *
+ * @param compression pointer to the compression state
+ */
+static struct libdeflate_compressor* mcp_compression_get_compressor(mcp_compression_t* compression) {
+    if (compression->compressor == NULL) {
+        compression->compressor = libdeflate_alloc_compressor(mcp_compression_get_level(compression));
+        assertd_not_null("mcp_compression_get_compressor", compression->compressor);
+    }
+    return compression->compressor;
+}
+
+/**
+ * @brief get cached libdeflate decompressor, allocating it on first use
+ *
+ * @param compression pointer to the compression state
+ */
+static struct libdeflate_decompressor* mcp_compression_get_decompressor(mcp_compression_t* compression) {
+    if (compression->decompressor == NULL) {
+        compression->decompressor = libdeflate_alloc_decompressor();
+        assertd_not_null("mcp_compression_get_decompressor", compression->decompressor);
+    }
+    return compression->decompressor;
+}
+#endif /* MCP_USE_ZLIB */
+
+/**
+ * @brief free cached compressor
+ *
+ * @param compression pointer to the compression state
+ */
+static void mcp_compression_free_compressor(mcp_compression_t* compression) {
+    if (compression->compressor != NULL) {
+        #ifdef MCP_USE_ZLIB
+            deflateEnd(compression->compressor);
+            free(compression->compressor);
+        #else
+            libdeflate_free_compressor(compression->compressor);
+        #endif /* MCP_USE_ZLIB */
+        compression->compressor = NULL;
+    }
+}
+
+/**
+ * @brief initialize compression state
+ *
+ * @param compression pointer to the compression state
+ * @param level       compression level
+ */
+void mcp_compression_init(mcp_compression_t* compression, int level) {
+    compression->level = level;
+    compression->compressor = NULL;
+    compression->decompressor = NULL;
+}
+
+/**
+ * @brief change compression level
+ *
+ * @param compression pointer to the compression state
+ * @param level       compression level
+ */
+void mcp_compression_level(mcp_compression_t* compression, int level) {
+    if (compression->level != level) {
+        mcp_compression_free_compressor(compression);
+        compression->level = level;
+    }
+}
+
+/**
+ * @brief get the compression state shared by the current thread
+ */
+mcp_compression_t* mcp_compression_thread() {
+    return &mcp_compression_thread_state;
+}
+
+/**
+ * @brief free the compression state of the current thread
+ */
+void mcp_compression_thread_free() {
+    mcp_compression_free(&mcp_compression_thread_state);
+}
+
+/**
+ * @brief get maximum compressed size
+ *
+ * @param compression pointer to the compression state
+ * @param size        uncompressed size
+ */
+size_t mcp_compression_bound(mcp_compression_t* compression, size_t size) {
+    #ifdef MCP_USE_ZLIB
+        return deflateBound(mcp_compression_get_compressor(compression), size);
+    #else
+        return libdeflate_zlib_compress_bound(mcp_compression_get_compressor(compression), size);
+    #endif /* MCP_USE_ZLIB */
+}
+
+/**
+ * @brief compress data in zlib format
+ *
+ * @param compression pointer to the compression state
+ * @param src         uncompressed data
+ * @param src_size    uncompressed size
+ * @param dest        compressed data destination
+ * @param dest_size   destination size
+ *
+ * @return compressed size, or 0 on failure
+ */
+size_t mcp_compress(mcp_compression_t* compression, char* src, size_t src_size, char* dest, size_t dest_size) {
+    #ifdef MCP_USE_ZLIB
+        z_stream* stream = mcp_compression_get_compressor(compression);
+        deflateReset(stream);
+        stream->next_in = (Bytef*) src;
+        stream->avail_in = (uInt) src_size;
+        stream->next_out = (Bytef*) dest;
+        stream->avail_out = (uInt) dest_size;
+        if (deflate(stream, Z_FINISH) != Z_STREAM_END) {
+            return 0;
+        }
+        return stream->total_out;
+    #else
+        return libdeflate_zlib_compress(mcp_compression_get_compressor(compression), src, src_size, dest, dest_size);
+    #endif /* MCP_USE_ZLIB */
+}
+
+/**
+ * @brief decompress data in zlib format
+ *
+ * @param compression pointer to the compression state
+ * @param src         compressed data
+ * @param src_size    compressed size
+ * @param dest        uncompressed data destination
+ * @param dest_size   exact uncompressed size
+ *
+ * @return true on success
+ */
+bool mcp_decompress(mcp_compression_t* compression, char* src, size_t src_size, char* dest, size_t dest_size) {
+    #ifdef MCP_USE_ZLIB
+        z_stream* stream = mcp_compression_get_decompressor(compression);
+        inflateReset(stream);
+        stream->next_in = (Bytef*) src;
+        stream->avail_in = (uInt) src_size;
+        stream->next_out = (Bytef*) dest;
+        stream->avail_out = (uInt) dest_size;
+        return inflate(stream, Z_FINISH) == Z_STREAM_END && stream->total_out == dest_size;
+    #else
+        return libdeflate_zlib_decompress(mcp_compression_get_decompressor(compression),
+            src, src_size, dest, dest_size, NULL) == LIBDEFLATE_SUCCESS;
+    #endif /* MCP_USE_ZLIB */
+}
+
+/**
+ * @brief decompress leading bytes of data in zlib format
+ *
+ * @param compression pointer to the compression state
+ * @param src         compressed data, could be incomplete
+ * @param src_size    compressed size
+ * @param dest        uncompressed data destination
+ * @param dest_size   number of leading bytes to decompress
+ *
+ * @return number of decompressed bytes, 0 on failure
+ */
+size_t mcp_decompress_prefix(mcp_compression_t* compression, char* src, size_t src_size, char* dest, size_t dest_size) {
+    #ifdef MCP_USE_ZLIB
+        z_stream* stream = mcp_compression_get_decompressor(compression);
+        inflateReset(stream);
+        stream->next_in = (Bytef*) src;
+        stream->avail_in = (uInt) src_size;
+        stream->next_out = (Bytef*) dest;
+        stream->avail_out = (uInt) dest_size;
+        int result = inflate(stream, Z_SYNC_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+            return 0;
+        }
+        return dest_size - stream->avail_out;
+    #else
+        return 0;
+    #endif /* MCP_USE_ZLIB */
+}
+
+/**
+ * @brief free compression state
+ *
+ * @param compression pointer to the compression state
+ */
+void mcp_compression_free(mcp_compression_t* compression) {
+    mcp_compression_free_compressor(compression);
+    if (compression->decompressor != NULL) {
+        #ifdef MCP_USE_ZLIB
+            inflateEnd(compression->decompressor);
+            free(compression->decompressor);
+        #else
+            libdeflate_free_decompressor(compression->decompressor);
+        #endif /* MCP_USE_ZLIB */
+        compression->decompressor = NULL;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+/**
+ * @file input.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief read-ahead stream input
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/io/input.h" /* this */
+#include <string.h>       /* memmove, memcpy */
+#include <errno.h>        /* error codes */
+
+    /* functions */
+/**
+ * @brief move buffered bytes to the beginning of the region
+ *
+ * @param input pointer to the input buffer
+ */
+static inline void mcp_input_compact(mcp_input_t* input) {
+    if (input->begin != 0) {
+        memmove(input->region.data, &input->region.data[input->begin], input->end - input->begin);
+        input->end -= input->begin;
+        input->begin = 0;
+    }
+}
+
+/**
+ * @brief append bytes to the input buffer
+ *
+ * @param input pointer to the input buffer
+ * @param src   data source
+ * @param count number of bytes
+ */
+void mcp_input_write(mcp_input_t* input, char* src, size_t count) {
+    if (input->end + count > input->region.capacity) {
+        mcp_input_compact(input);
+    }
+    memcpy(&mcp_region_reserve(&input->region, input->end + count)[input->end], src, count);
+    input->end += count;
+}
+
+/**
+ * @brief read from a stream until at least count bytes are buffered
+ *
+ * @param input  pointer to the input buffer
+ * @param stream the stream
+ * @param count  required number of buffered bytes
+ *
+ * @return false if the stream was closed or failed
+ */
+bool mcp_input_fill(mcp_input_t* input, mcp_stream_t stream, size_t count) {
+    if (mcp_input_available(input) >= count) {
+        return true;
+    }
+    if (input->begin + count > input->region.capacity) {
+        mcp_input_compact(input);
+        size_t capacity = count < MCP_INPUT_DEFAULT_SIZE ? MCP_INPUT_DEFAULT_SIZE : count;
+        mcp_region_reserve(&input->region, capacity);
+    }
+    while (mcp_input_available(input) < count) {
+        ssize_t received = read(stream, &input->region.data[input->end], input->region.capacity - input->end);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        input->end += received;
+    }
+    return true;
+}
+
+/**
+ * @brief read once from a stream into the free space of the input buffer
+ *
+ * @param input  pointer to the input buffer
+ * @param stream the stream
+ *
+ * @return number of bytes read, 0 if the stream was closed, -1 on error
+ */
+ssize_t mcp_input_receive(mcp_input_t* input, mcp_stream_t stream) {
+    if (input->end == input->region.capacity) {
+        mcp_input_compact(input);
+        if (input->end == input->region.capacity) {
+            mcp_region_reserve(&input->region, input->region.capacity == 0 ? MCP_INPUT_DEFAULT_SIZE : input->region.capacity + 1);
+        }
+    }
+    ssize_t received = read(stream, &input->region.data[input->end], input->region.capacity - input->end);
+    if (received > 0) {
+        input->end += received;
+    }
+    return received;
+}
+
+/**
+ * @brief compact the input buffer and shrink it back to its limit
+ *
+ * @param input pointer to the input buffer
+ */
+void mcp_input_release(mcp_input_t* input) {
+    if (input->region.limit != 0 && input->region.capacity > input->region.limit) {
+        mcp_input_compact(input);
+        if (input->end <= input->region.limit) {
+            mcp_region_release(&input->region);
+        }
+    }
+}
\ No newline at end of file
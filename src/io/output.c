@@ -0,0 +1,155 @@
+/**
+ * @file output.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief queued stream output
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* feature test */
+#define _GNU_SOURCE /* splice, pipe2 */
+
+    /* includes */
+#include "mcp/io/output.h" /* this */
+#include "csafe/assertd.h" /* debug assertions */
+#include <fcntl.h>         /* splice */
+#include <sys/uio.h>       /* gathered write */
+#include <sys/socket.h>    /* sendmsg */
+#include <limits.h>        /* IOV_MAX */
+#include <errno.h>         /* error codes */
+
+    /* defines */
+/**
+ * @brief number of segments written with a single call
+ */
+#ifdef IOV_MAX
+    #define MCP_OUTPUT_VECTOR_SIZE IOV_MAX
+#else
+    #define MCP_OUTPUT_VECTOR_SIZE 1024
+#endif /* IOV_MAX */
+
+    /* functions */
+/**
+ * @brief queue bytes from previously reserved space
+ *
+ * @param output pointer to the output queue
+ * @param skip   number of reserved bytes to leave unused
+ * @param length number of bytes to queue after the skipped ones
+ */
+void mcp_output_commit(mcp_output_t* output, size_t skip, size_t length) {
+    size_t offset = output->size + skip;
+    output->size = offset + length;
+    if (output->count != output->first) {
+        mcp_output_segment_t* last = &output->segments[output->count - 1];
+        if (last->offset + last->length == offset) {
+            last->length += length;
+            return;
+        }
+    }
+    if (output->count == output->capacity) {
+        output->capacity = output->capacity == 0 ? 16 : output->capacity * 2;
+        output->segments = realloc(output->segments, output->capacity * sizeof(mcp_output_segment_t));
+        assertd_not_null("mcp_output_commit", output->segments);
+    }
+    output->segments[output->count].offset = offset;
+    output->segments[output->count].length = length;
+    output->count++;
+}
+
+/**
+ * @brief drop written bytes from the beginning of the output queue
+ *
+ * @param output pointer to the output queue
+ * @param count  number of written bytes
+ */
+void mcp_output_advance(mcp_output_t* output, size_t count) {
+    while (count > 0 && output->first < output->count) {
+        mcp_output_segment_t* segment = &output->segments[output->first];
+        if (count < segment->length) {
+            segment->offset += count;
+            segment->length -= count;
+            return;
+        }
+        count -= segment->length;
+        output->first++;
+    }
+    if (output->first == output->count) {
+        output->size = 0;
+        output->first = 0;
+        output->count = 0;
+        mcp_region_release(&output->region);
+    }
+}
+
+/**
+ * @brief write queued bytes to a stream
+ *
+ * @param output pointer to the output queue
+ * @param stream the stream
+ *
+ * @return false if the stream failed
+ */
+bool mcp_output_flush(mcp_output_t* output, mcp_stream_t stream) {
+    struct iovec vector[MCP_OUTPUT_VECTOR_SIZE];
+    while (output->first < output->count) {
+        int count = 0;
+        for (size_t i = output->first; i < output->count && count < MCP_OUTPUT_VECTOR_SIZE; i++, count++) {
+            vector[count].iov_base = &output->region.data[output->segments[i].offset];
+            vector[count].iov_len = output->segments[i].length;
+        }
+        struct msghdr message = { .msg_iov = vector, .msg_iovlen = count };
+        ssize_t written = sendmsg(stream, &message, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        mcp_output_advance(output, written);
+    }
+    return true;
+}
+
+/**
+ * @brief move bytes from one stream to another through a pipe, without copying them
+ *
+ * @param output pointer to the output queue of the destination stream
+ * @param in     source stream
+ * @param out    destination stream
+ * @param count  number of bytes
+ *
+ * @return number of bytes taken from the source stream
+ */
+size_t mcp_output_splice(mcp_output_t* output, mcp_stream_t in, mcp_stream_t out, size_t count) {
+    if (output->pipe[0] < 0 && pipe2(output->pipe, O_CLOEXEC) != 0) {
+        return 0;
+    }
+    size_t moved = 0;
+    while (moved < count) {
+        ssize_t spliced = splice(in, NULL, output->pipe[1], NULL, count - moved, SPLICE_F_MOVE);
+        if (spliced < 0 && errno == EINTR) {
+            continue;
+        }
+        if (spliced <= 0) {
+            break;
+        }
+        moved += spliced;
+        size_t piped = spliced;
+        while (piped > 0) {
+            ssize_t written = splice(output->pipe[0], NULL, out, NULL, piped, SPLICE_F_MOVE);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                break;
+            }
+            piped -= written;
+        }
+        if (piped > 0) {
+            char* space = mcp_output_reserve(output, piped);
+            mcp_stream_read(output->pipe[0], space, piped);
+            mcp_output_commit(output, 0, piped);
+            break;
+        }
+    }
+    return moved;
+}
@@ -8,6 +8,10 @@
     /* includes */
 #include "mcp/io/stream.h" /* this */
 #include "csafe/assertd.h" /* debug assertions */
+#include <fcntl.h>         /* file control */
+#include <sys/socket.h>    /* sockets */
+#include <netdb.h>         /* address resolution */
+#include <string.h>        /* memset */
 
     /* functions */
 /**
@@ -58,4 +62,59 @@ void mcp_stream_read(mcp_stream_t stream, char* dest, size_t count) {
             #endif /* NDEBUG */
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief switch a stream between blocking and non-blocking mode
+ * 
+ * @param stream   the stream
+ * @param blocking true for blocking mode
+ * 
+ * @return false on failure
+ */
+bool mcp_stream_blocking(mcp_stream_t stream, bool blocking) {
+    int flags = fcntl(stream, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+    return fcntl(stream, F_SETFL, flags) == 0;
+}
+
+/**
+ * @brief open a non-blocking listening stream
+ * 
+ * @param host  local address, NULL for any
+ * @param port  local port
+ * @param share allow several streams to listen on the same port
+ * 
+ * @return the stream, or -1 on failure
+ */
+mcp_stream_t mcp_stream_listen(const char* host, const char* port, bool share) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    struct addrinfo* addresses;
+    if (getaddrinfo(host, port, &hints, &addresses) != 0) {
+        return -1;
+    }
+    mcp_stream_t stream = -1;
+    for (struct addrinfo* address = addresses; address != NULL; address = address->ai_next) {
+        stream = socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+        if (stream < 0) {
+            continue;
+        }
+        int enable = 1;
+        setsockopt(stream, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+        if ((!share || setsockopt(stream, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) == 0)
+            && bind(stream, address->ai_addr, address->ai_addrlen) == 0 && listen(stream, SOMAXCONN) == 0) {
+            break;
+        }
+        close(stream);
+        stream = -1;
+    }
+    freeaddrinfo(addresses);
+    return stream;
+}
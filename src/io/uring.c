@@ -0,0 +1,460 @@
+/**
+ * @file uring.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief io_uring reactor backend
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/io/uring.h" /* this */
+
+#ifdef MCP_USE_IO_URING
+
+#include "csafe/assertd.h" /* debug assertions */
+#include <liburing.h>      /* io_uring */
+#include <sys/socket.h>    /* sendmsg */
+#include <stdint.h>        /* uintptr_t */
+#include <stdlib.h>        /* malloc */
+#include <string.h>        /* memset */
+#include <errno.h>         /* error codes */
+
+    /* defines */
+/**
+ * @brief provided buffer group id
+ */
+#define MCP_URING_GROUP 0
+
+/**
+ * @brief maximum number of segments sent with a single operation
+ */
+#define MCP_URING_VECTOR_SIZE 256
+
+/**
+ * @brief operation types stored in the low bits of user data
+ */
+#define MCP_URING_RECEIVE 0
+#define MCP_URING_SEND 1
+#define MCP_URING_CANCEL 2
+#define MCP_URING_ACCEPT 3
+#define MCP_URING_OPERATION 7
+
+    /* typedefs */
+/**
+ * @brief io_uring connection state
+ *
+ * output of the context is moved to sending while a send operation
+ * is in flight, so handlers could queue packets without moving its memory
+ *
+ * @note removed connections are freed when all their operations complete
+ */
+typedef struct mcp_uring_connection_t {
+    mcp_context_t* context;
+    mcp_output_t sending;
+    struct msghdr message;
+    struct iovec vector[MCP_URING_VECTOR_SIZE];
+    int stream;
+    unsigned int operations;
+    bool receiving;
+    bool writing;
+    bool scheduled;
+    bool removed;
+    bool notify;
+} mcp_uring_connection_t;
+
+/**
+ * @brief io_uring backend state
+ *
+ * received data is placed by the kernel into a ring of provided buffers,
+ * connections with queued output are scheduled and their sends
+ * are submitted together with the next wait for completions
+ */
+typedef struct mcp_uring_t {
+    struct io_uring ring;
+    struct io_uring_buf_ring* buffers;
+    char* memory;
+    bool multishot;
+    mcp_uring_connection_t** scheduled;
+    size_t scheduled_count;
+    size_t scheduled_capacity;
+} mcp_uring_t;
+
+    /* functions */
+/**
+ * @brief create io_uring backend state for a reactor
+ *
+ * @param reactor pointer to the reactor
+ *
+ * @return backend state, NULL if io_uring is not supported
+ */
+void* mcp_uring_create(mcp_reactor_t* reactor) {
+    mcp_uring_t* uring = malloc(sizeof(mcp_uring_t));
+    assertd_not_null("mcp_uring_create", uring);
+    memset(uring, 0, sizeof(mcp_uring_t));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    if (io_uring_queue_init_params(MCP_URING_ENTRIES, &uring->ring, &params) < 0) {
+        memset(&params, 0, sizeof(params));
+        if (io_uring_queue_init_params(MCP_URING_ENTRIES, &uring->ring, &params) < 0) {
+            free(uring);
+            return NULL;
+        }
+    }
+    int error;
+    uring->buffers = io_uring_setup_buf_ring(&uring->ring, MCP_URING_BUFFERS, MCP_URING_GROUP, 0, &error);
+    if (uring->buffers == NULL) {
+        io_uring_queue_exit(&uring->ring);
+        free(uring);
+        return NULL;
+    }
+    uring->memory = malloc((size_t) MCP_URING_BUFFERS * MCP_URING_BUFFER_SIZE);
+    assertd_not_null("mcp_uring_create", uring->memory);
+    for (int i = 0; i < MCP_URING_BUFFERS; i++) {
+        io_uring_buf_ring_add(uring->buffers, &uring->memory[(size_t) i * MCP_URING_BUFFER_SIZE], MCP_URING_BUFFER_SIZE,
+                              i, io_uring_buf_ring_mask(MCP_URING_BUFFERS), i);
+    }
+    io_uring_buf_ring_advance(uring->buffers, MCP_URING_BUFFERS);
+    uring->multishot = true;
+    return uring;
+}
+
+/**
+ * @brief get a submission queue entry, submitting queued ones if the queue is full
+ *
+ * @param uring backend state
+ * @param data  operation target
+ * @param type  operation type
+ */
+static struct io_uring_sqe* mcp_uring_sqe(mcp_uring_t* uring, void* data, int type) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&uring->ring);
+    while (sqe == NULL) {
+        io_uring_submit(&uring->ring);
+        sqe = io_uring_get_sqe(&uring->ring);
+    }
+    io_uring_sqe_set_data64(sqe, (uintptr_t) data | type);
+    return sqe;
+}
+
+/**
+ * @brief queue a receive operation for a connection
+ *
+ * @param uring      backend state
+ * @param connection connection state
+ */
+static void mcp_uring_receive(mcp_uring_t* uring, mcp_uring_connection_t* connection) {
+    struct io_uring_sqe* sqe = mcp_uring_sqe(uring, connection, MCP_URING_RECEIVE);
+    if (uring->multishot) {
+        io_uring_prep_recv_multishot(sqe, connection->stream, NULL, 0, 0);
+    } else {
+        io_uring_prep_recv(sqe, connection->stream, NULL, 0, 0);
+    }
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = MCP_URING_GROUP;
+    connection->receiving = true;
+    connection->operations++;
+}
+
+/**
+ * @brief queue a send operation for a connection if it has queued output
+ *
+ * @param uring      backend state
+ * @param connection connection state
+ */
+static void mcp_uring_send(mcp_uring_t* uring, mcp_uring_connection_t* connection) {
+    if (connection->writing) {
+        return;
+    }
+    mcp_output_t* sending = &connection->sending;
+    if (!mcp_output_pending(sending)) {
+        mcp_output_t* output = &connection->context->output;
+        if (!mcp_output_pending(output)) {
+            return;
+        }
+        mcp_output_t spare = *sending;
+        *sending = *output;
+        *output = spare;
+    }
+    size_t count = 0;
+    for (size_t i = sending->first; i < sending->count && count < MCP_URING_VECTOR_SIZE; i++, count++) {
+        connection->vector[count].iov_base = &sending->region.data[sending->segments[i].offset];
+        connection->vector[count].iov_len = sending->segments[i].length;
+    }
+    memset(&connection->message, 0, sizeof(struct msghdr));
+    connection->message.msg_iov = connection->vector;
+    connection->message.msg_iovlen = count;
+    struct io_uring_sqe* sqe = mcp_uring_sqe(uring, connection, MCP_URING_SEND);
+    io_uring_prep_sendmsg(sqe, connection->stream, &connection->message, MSG_NOSIGNAL);
+    connection->writing = true;
+    connection->operations++;
+}
+
+/**
+ * @brief schedule a connection for processing after the completions are handled
+ *
+ * @param uring      backend state
+ * @param connection connection state
+ */
+static void mcp_uring_schedule(mcp_uring_t* uring, mcp_uring_connection_t* connection) {
+    if (connection->scheduled) {
+        return;
+    }
+    if (uring->scheduled_count == uring->scheduled_capacity) {
+        uring->scheduled_capacity = uring->scheduled_capacity == 0 ? 64 : uring->scheduled_capacity * 2;
+        uring->scheduled = realloc(uring->scheduled, uring->scheduled_capacity * sizeof(mcp_uring_connection_t*));
+        assertd_not_null("mcp_uring_schedule", uring->scheduled);
+    }
+    uring->scheduled[uring->scheduled_count++] = connection;
+    connection->scheduled = true;
+}
+
+/**
+ * @brief queue an accept operation for the reactor listener
+ *
+ * @param reactor pointer to the reactor
+ */
+static void mcp_uring_accept(mcp_reactor_t* reactor) {
+    mcp_uring_t* uring = reactor->uring;
+    struct io_uring_sqe* sqe = mcp_uring_sqe(uring, uring, MCP_URING_ACCEPT);
+    if (uring->multishot) {
+        io_uring_prep_multishot_accept(sqe, reactor->listener, NULL, NULL, 0);
+    } else {
+        io_uring_prep_accept(sqe, reactor->listener, NULL, NULL, 0);
+    }
+}
+
+/**
+ * @brief start accepting connections from the reactor listener
+ *
+ * @param reactor pointer to the reactor
+ *
+ * @return false on failure
+ */
+bool mcp_uring_listen(mcp_reactor_t* reactor) {
+    mcp_uring_accept(reactor);
+    return true;
+}
+
+/**
+ * @brief start receiving from a connection
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ *
+ * @return false on failure
+ */
+bool mcp_uring_add(mcp_reactor_t* reactor, mcp_context_t* context) {
+    mcp_uring_connection_t* connection = malloc(sizeof(mcp_uring_connection_t));
+    assertd_not_null("mcp_uring_add", connection);
+    memset(connection, 0, sizeof(mcp_uring_connection_t));
+    connection->context = context;
+    connection->stream = context->buffer.stream;
+    mcp_output_init(&connection->sending, context->output.region.limit);
+    context->transport = connection;
+    context->corked = true;
+    mcp_uring_receive(reactor->uring, connection);
+    return true;
+}
+
+/**
+ * @brief schedule queued output of a connection for the next submission
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ */
+void mcp_uring_flush(mcp_reactor_t* reactor, mcp_context_t* context) {
+    if (context->transport != NULL) {
+        mcp_uring_schedule(reactor->uring, context->transport);
+    }
+}
+
+/**
+ * @brief cancel operations on a connection
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ * @param notify  call the close callback when the operations are finished
+ */
+void mcp_uring_remove(mcp_reactor_t* reactor, mcp_context_t* context, bool notify) {
+    mcp_uring_t* uring = reactor->uring;
+    mcp_uring_connection_t* connection = context->transport;
+    if (connection == NULL) {
+        return;
+    }
+    context->transport = NULL;
+    connection->removed = true;
+    connection->notify = notify;
+    if (connection->receiving) {
+        struct io_uring_sqe* sqe = mcp_uring_sqe(uring, connection, MCP_URING_CANCEL);
+        io_uring_prep_cancel64(sqe, (uintptr_t) connection | MCP_URING_RECEIVE, 0);
+    }
+    mcp_uring_schedule(uring, connection);
+}
+
+/**
+ * @brief handle a completion
+ *
+ * @param reactor pointer to the reactor
+ * @param uring   backend state
+ * @param cqe     completion queue entry
+ */
+static void mcp_uring_complete(mcp_reactor_t* reactor, mcp_uring_t* uring, struct io_uring_cqe* cqe) {
+    uint64_t data = io_uring_cqe_get_data64(cqe);
+    int type = data & MCP_URING_OPERATION;
+    if (type == MCP_URING_CANCEL) {
+        return;
+    }
+    if (type == MCP_URING_ACCEPT) {
+        if (cqe->res >= 0) {
+            mcp_reactor_adopt(reactor, cqe->res);
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            if (cqe->res == -EINVAL && uring->multishot) {
+                uring->multishot = false;
+            } else if (cqe->res < 0 && cqe->res != -EINTR && cqe->res != -EAGAIN && cqe->res != -ECONNABORTED) {
+                return;
+            }
+            mcp_uring_accept(reactor);
+        }
+        return;
+    }
+    mcp_uring_connection_t* connection = (mcp_uring_connection_t*) (uintptr_t) (data & ~(uint64_t) MCP_URING_OPERATION);
+    bool alive = true;
+    if (type == MCP_URING_RECEIVE) {
+        if (cqe->flags & IORING_CQE_F_BUFFER) {
+            unsigned int id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            char* buffer = &uring->memory[(size_t) id * MCP_URING_BUFFER_SIZE];
+            if (cqe->res > 0 && !connection->removed) {
+                alive = mcp_reactor_deliver(reactor, connection->context, buffer, cqe->res);
+            }
+            io_uring_buf_ring_add(uring->buffers, buffer, MCP_URING_BUFFER_SIZE, id, io_uring_buf_ring_mask(MCP_URING_BUFFERS), 0);
+            io_uring_buf_ring_advance(uring->buffers, 1);
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            connection->receiving = false;
+            connection->operations--;
+            if (cqe->res == -EINVAL && uring->multishot) {
+                /* multishot receive is not supported by the kernel */
+                uring->multishot = false;
+            } else if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -EINTR && cqe->res != -EAGAIN)) {
+                alive = false;
+            }
+            if (alive && !connection->removed) {
+                mcp_uring_receive(uring, connection);
+            }
+        }
+    } else {
+        connection->writing = false;
+        connection->operations--;
+        if (cqe->res >= 0) {
+            mcp_output_advance(&connection->sending, cqe->res);
+        } else if (cqe->res != -EINTR && cqe->res != -EAGAIN) {
+            alive = false;
+        }
+    }
+    if (!alive && !connection->removed) {
+        mcp_reactor_close(reactor, connection->context);
+    }
+    mcp_uring_schedule(uring, connection);
+}
+
+/**
+ * @brief queue sends of scheduled connections and free finished ones
+ *
+ * @param reactor pointer to the reactor
+ * @param uring   backend state
+ */
+static void mcp_uring_process(mcp_reactor_t* reactor, mcp_uring_t* uring) {
+    for (size_t i = 0; i < uring->scheduled_count; i++) {
+        mcp_uring_connection_t* connection = uring->scheduled[i];
+        connection->scheduled = false;
+        if (!connection->removed) {
+            mcp_uring_send(uring, connection);
+        } else if (connection->operations == 0) {
+            if (connection->notify && reactor->close != NULL) {
+                reactor->close(reactor, connection->context);
+            }
+            mcp_output_free(&connection->sending);
+            free(connection);
+        }
+    }
+    uring->scheduled_count = 0;
+}
+
+/**
+ * @brief submit queued operations, wait for completions and handle them
+ *
+ * @param reactor pointer to the reactor
+ * @param timeout maximum wait time in milliseconds, -1 for infinite
+ *
+ * @return number of handled completions, or -1 on failure
+ */
+int mcp_uring_run(mcp_reactor_t* reactor, int timeout) {
+    mcp_uring_t* uring = reactor->uring;
+    mcp_uring_process(reactor, uring);
+    struct io_uring_cqe* cqe;
+    struct __kernel_timespec time = {
+        .tv_sec = timeout / 1000,
+        .tv_nsec = (timeout % 1000) * 1000000L
+    };
+    int result = io_uring_submit_and_wait_timeout(&uring->ring, &cqe, 1, timeout < 0 ? NULL : &time, NULL);
+    if (result < 0 && result != -ETIME && result != -EINTR) {
+        return -1;
+    }
+    unsigned int head;
+    int count = 0;
+    io_uring_for_each_cqe(&uring->ring, head, cqe) {
+        mcp_uring_complete(reactor, uring, cqe);
+        count++;
+    }
+    io_uring_cq_advance(&uring->ring, count);
+    mcp_uring_process(reactor, uring);
+    return count;
+}
+
+/**
+ * @brief free io_uring backend state
+ *
+ * @param reactor pointer to the reactor
+ */
+void mcp_uring_free(mcp_reactor_t* reactor) {
+    mcp_uring_t* uring = reactor->uring;
+    io_uring_free_buf_ring(&uring->ring, uring->buffers, MCP_URING_BUFFERS, MCP_URING_GROUP);
+    io_uring_queue_exit(&uring->ring);
+    free(uring->memory);
+    free(uring->scheduled);
+    free(uring);
+}
+
+#else
+
+    /* functions */
+/**
+ * @brief io_uring backend is not available without MCP_USE_IO_URING
+ *
+ * @param reactor pointer to the reactor
+ *
+ * @return NULL
+ */
+void* mcp_uring_create(mcp_reactor_t* reactor) {
+    return NULL;
+}
+
+bool mcp_uring_listen(mcp_reactor_t* reactor) {
+    return false;
+}
+
+bool mcp_uring_add(mcp_reactor_t* reactor, mcp_context_t* context) {
+    return false;
+}
+
+void mcp_uring_flush(mcp_reactor_t* reactor, mcp_context_t* context) {}
+
+void mcp_uring_remove(mcp_reactor_t* reactor, mcp_context_t* context, bool notify) {}
+
+int mcp_uring_run(mcp_reactor_t* reactor, int timeout) {
+    return -1;
+}
+
+void mcp_uring_free(mcp_reactor_t* reactor) {}
+
+#endif /* MCP_USE_IO_URING */
@@ -0,0 +1,628 @@
+/**
+ * @file metadata.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief entity metadata codec and delta building
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/metadata.h"  /* this */
+#include "csafe/assertd.h" /* debug assertions */
+#include <stdlib.h>        /* memory allocation */
+#include <string.h>        /* memory operations */
+
+    /* functions */
+/**
+ * @brief read the index of the next entry
+ *
+ * @param src   source buffer
+ * @param index destination index
+ *
+ * @return false at the end of the metadata or if the buffer is too short
+ */
+static inline bool mcp_metadata_next(mcp_buffer_t* src, uint8_t* index) {
+  if (!mcp_buffer_check(src, sizeof(uint8_t))) {
+    return false;
+  }
+  mcp_decode_byte(index, src);
+  return *index != MCP_METADATA_END;
+}
+
+/**
+ * @brief read the presence byte of an optional value
+ *
+ * @param src source buffer
+ *
+ * @return false if the value is absent or the buffer is too short
+ */
+static inline bool mcp_metadata_present(mcp_buffer_t* src) {
+  uint8_t present = 0;
+  if (mcp_buffer_check(src, sizeof(uint8_t))) {
+    mcp_decode_byte(&present, src);
+  }
+  return present;
+}
+
+/**
+ * @brief skip a particle with its data
+ *
+ * @param src source buffer
+ */
+static void mcp_metadata_skip_particle(mcp_buffer_t* src) {
+  switch ((mcp_type_ParticleType) mcp_decode_varint(src)) {
+    case MCP_DEFINED_PARTICLE_BLOCK_DUST:
+    case MCP_DEFINED_PARTICLE_FALLING_DUST:
+      mcp_skip_varint(src);
+      break;
+
+    case MCP_DEFINED_PARTICLE_DUST:
+      mcp_buffer_skip(src, 4 * sizeof(float));
+      break;
+
+    case MCP_DEFINED_PARTICLE_ITEM:
+      mcp_skip_type_Slot(src);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief skip a value
+ *
+ * @param type value type
+ * @param src  source buffer
+ *
+ * @return false if the type is unknown
+ * @note type is not truncated, so values past the known types
+ *         never alias one of them
+ */
+static bool mcp_metadata_skip_value(uint64_t type, mcp_buffer_t* src) {
+  switch (type) {
+    case MCP_METADATA_BYTE:
+    case MCP_METADATA_BOOLEAN:
+      mcp_buffer_skip(src, sizeof(uint8_t));
+      break;
+
+    case MCP_METADATA_VARINT:
+    case MCP_METADATA_DIRECTION:
+    case MCP_METADATA_OPT_BLOCK_ID:
+    case MCP_METADATA_OPT_VARINT:
+    case MCP_METADATA_POSE:
+      mcp_skip_varint(src);
+      break;
+
+    case MCP_METADATA_FLOAT:
+      mcp_buffer_skip(src, sizeof(float));
+      break;
+
+    case MCP_METADATA_STRING:
+    case MCP_METADATA_CHAT:
+      mcp_skip_string(src);
+      break;
+
+    case MCP_METADATA_OPT_CHAT:
+      if (mcp_metadata_present(src)) {
+        mcp_skip_string(src);
+      }
+      break;
+
+    case MCP_METADATA_SLOT:
+      mcp_skip_type_Slot(src);
+      break;
+
+    case MCP_METADATA_ROTATION:
+      mcp_buffer_skip(src, 3 * sizeof(float));
+      break;
+
+    case MCP_METADATA_POSITION:
+      mcp_buffer_skip(src, sizeof(uint64_t));
+      break;
+
+    case MCP_METADATA_OPT_POSITION:
+      if (mcp_metadata_present(src)) {
+        mcp_buffer_skip(src, sizeof(uint64_t));
+      }
+      break;
+
+    case MCP_METADATA_OPT_UUID:
+      if (mcp_metadata_present(src)) {
+        mcp_buffer_skip(src, sizeof(mcp_type_UUID));
+      }
+      break;
+
+    case MCP_METADATA_NBT:
+      mcp_skip_type_NbtTagCompound(src);
+      break;
+
+    case MCP_METADATA_PARTICLE:
+      mcp_metadata_skip_particle(src);
+      break;
+
+    case MCP_METADATA_VILLAGER_DATA:
+      mcp_skip_varint(src);
+      mcp_skip_varint(src);
+      mcp_skip_varint(src);
+      break;
+
+    default:
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief decode a value into an entry
+ *
+ * @param entry the entry with its type set
+ * @param src   source buffer
+ * @param data  destination of encoded values
+ * @param used  number of used bytes of data
+ */
+static void mcp_metadata_decode_value(mcp_type_EntityMetadataEntry* entry, mcp_buffer_t* src, char* data, size_t* used) {
+  uint8_t byte;
+  entry->present = true;
+  switch (entry->type) {
+    case MCP_METADATA_BYTE:
+    case MCP_METADATA_BOOLEAN:
+      mcp_decode_byte(&byte, src);
+      entry->value.integer = byte;
+      break;
+
+    case MCP_METADATA_VARINT:
+    case MCP_METADATA_DIRECTION:
+    case MCP_METADATA_OPT_BLOCK_ID:
+    case MCP_METADATA_OPT_VARINT:
+    case MCP_METADATA_POSE:
+      entry->value.integer = mcp_decode_varint(src);
+      break;
+
+    case MCP_METADATA_FLOAT:
+      mcp_decode_bef32(&entry->value.number, src);
+      break;
+
+    case MCP_METADATA_ROTATION:
+      mcp_decode_bef32(&entry->value.rotation[0], src);
+      mcp_decode_bef32(&entry->value.rotation[1], src);
+      mcp_decode_bef32(&entry->value.rotation[2], src);
+      break;
+
+    case MCP_METADATA_OPT_POSITION:
+      mcp_decode_byte(&byte, src);
+      entry->present = byte;
+      if (!entry->present) {
+        break;
+      }
+      /* fallthrough */
+    case MCP_METADATA_POSITION:
+      mcp_decode_type_Position(&entry->value.position, src);
+      break;
+
+    case MCP_METADATA_OPT_UUID:
+      mcp_decode_byte(&byte, src);
+      entry->present = byte;
+      if (entry->present) {
+        mcp_decode_type_UUID(&entry->value.uuid, src);
+      }
+      break;
+
+    case MCP_METADATA_VILLAGER_DATA:
+      entry->value.villager[0] = mcp_decode_varint(src);
+      entry->value.villager[1] = mcp_decode_varint(src);
+      entry->value.villager[2] = mcp_decode_varint(src);
+      break;
+
+    case MCP_METADATA_OPT_CHAT:
+      mcp_decode_byte(&byte, src);
+      entry->present = byte;
+      if (!entry->present) {
+        entry->value.data.offset = *used;
+        entry->value.data.size = 0;
+        break;
+      }
+      /* fallthrough */
+    default: {
+      size_t start = src->index;
+      mcp_metadata_skip_value(entry->type == MCP_METADATA_OPT_CHAT ? MCP_METADATA_STRING : entry->type, src);
+      entry->value.data.offset = *used;
+      entry->value.data.size = src->index - start;
+      memcpy(&data[*used], &src->data[start], entry->value.data.size);
+      *used += entry->value.data.size;
+      break;
+    }
+  }
+}
+
+/**
+ * @brief encode the value of an entry
+ *
+ * @param this  the metadata
+ * @param entry the entry
+ * @param dest  destination buffer
+ */
+static void mcp_metadata_encode_value(mcp_type_EntityMetadata* this, mcp_type_EntityMetadataEntry* entry, mcp_buffer_t* dest) {
+  switch (entry->type) {
+    case MCP_METADATA_BYTE:
+    case MCP_METADATA_BOOLEAN:
+      mcp_encode_byte(entry->value.integer, dest);
+      break;
+
+    case MCP_METADATA_VARINT:
+    case MCP_METADATA_DIRECTION:
+    case MCP_METADATA_OPT_BLOCK_ID:
+    case MCP_METADATA_OPT_VARINT:
+    case MCP_METADATA_POSE:
+      mcp_encode_varint((uint32_t) entry->value.integer, dest);
+      break;
+
+    case MCP_METADATA_FLOAT:
+      mcp_encode_bef32(entry->value.number, dest);
+      break;
+
+    case MCP_METADATA_ROTATION:
+      mcp_encode_bef32(entry->value.rotation[0], dest);
+      mcp_encode_bef32(entry->value.rotation[1], dest);
+      mcp_encode_bef32(entry->value.rotation[2], dest);
+      break;
+
+    case MCP_METADATA_OPT_POSITION:
+      mcp_encode_byte(entry->present, dest);
+      if (!entry->present) {
+        break;
+      }
+      /* fallthrough */
+    case MCP_METADATA_POSITION:
+      mcp_encode_type_Position(&entry->value.position, dest);
+      break;
+
+    case MCP_METADATA_OPT_UUID:
+      mcp_encode_byte(entry->present, dest);
+      if (entry->present) {
+        mcp_encode_type_UUID(&entry->value.uuid, dest);
+      }
+      break;
+
+    case MCP_METADATA_VILLAGER_DATA:
+      mcp_encode_varint((uint32_t) entry->value.villager[0], dest);
+      mcp_encode_varint((uint32_t) entry->value.villager[1], dest);
+      mcp_encode_varint((uint32_t) entry->value.villager[2], dest);
+      break;
+
+    case MCP_METADATA_OPT_CHAT:
+      mcp_encode_byte(entry->present, dest);
+      if (!entry->present) {
+        break;
+      }
+      /* fallthrough */
+    default:
+      mcp_buffer_reserve(dest, entry->value.data.size);
+      memcpy(mcp_buffer_current(dest), mcp_metadata_data(this, entry), entry->value.data.size);
+      mcp_buffer_increment(dest, entry->value.data.size);
+      break;
+  }
+}
+
+/**
+ * minecraft entity metadata
+ */
+void mcp_encode_type_EntityMetadata(mcp_type_EntityMetadata* this, mcp_buffer_t* dest) {
+  for (size_t i = 0; i < this->count; i++) {
+    mcp_encode_byte(this->entries[i].index, dest);
+    mcp_encode_varint(this->entries[i].type, dest);
+    mcp_metadata_encode_value(this, &this->entries[i], dest);
+  }
+  mcp_encode_byte(MCP_METADATA_END, dest);
+}
+void mcp_decode_type_EntityMetadata(mcp_type_EntityMetadata* this, mcp_buffer_t* src) {
+  mcp_buffer_t scan = *src;
+  size_t count = 0;
+  size_t size = 0;
+  uint8_t index;
+  while (mcp_metadata_next(&scan, &index)) {
+    uint64_t type = mcp_decode_varint(&scan);
+    size_t start = scan.index;
+    if (!mcp_metadata_skip_value(type, &scan)) {
+      mcp_buffer_fail(&scan);
+      break;
+    }
+    if (mcp_metadata_is_data(type)) {
+      size += scan.index - start;
+    }
+    count++;
+  }
+  if (scan.failed) {
+    memset(this, 0, sizeof(mcp_type_EntityMetadata));
+    mcp_buffer_fail(src);
+    return;
+  }
+  this->entries = mcp_buffer_decode_allocate(src, count * sizeof(mcp_type_EntityMetadataEntry) + size);
+  assertd_not_null("mcp_decode_type_EntityMetadata", this->entries);
+  this->count = count;
+  this->data = (char*) &this->entries[count];
+  this->size = 0;
+  for (size_t i = 0; i < count; i++) {
+    mcp_type_EntityMetadataEntry* entry = &this->entries[i];
+    memset(entry, 0, sizeof(mcp_type_EntityMetadataEntry));
+    mcp_decode_byte(&entry->index, src);
+    entry->type = mcp_decode_varint(src);
+    mcp_metadata_decode_value(entry, src, this->data, &this->size);
+  }
+  src->index = scan.index;
+}
+void mcp_length_type_EntityMetadata(mcp_type_EntityMetadata* this, size_t* length) {
+  for (size_t i = 0; i < this->count; i++) {
+    mcp_type_EntityMetadataEntry* entry = &this->entries[i];
+    *length += sizeof(uint8_t) + mcp_length_varint(entry->type);
+    switch (entry->type) {
+      case MCP_METADATA_BYTE:
+      case MCP_METADATA_BOOLEAN:
+        *length += sizeof(uint8_t);
+        break;
+
+      case MCP_METADATA_VARINT:
+      case MCP_METADATA_DIRECTION:
+      case MCP_METADATA_OPT_BLOCK_ID:
+      case MCP_METADATA_OPT_VARINT:
+      case MCP_METADATA_POSE:
+        *length += mcp_length_varint(entry->value.integer);
+        break;
+
+      case MCP_METADATA_FLOAT:
+        *length += sizeof(float);
+        break;
+
+      case MCP_METADATA_ROTATION:
+        *length += 3 * sizeof(float);
+        break;
+
+      case MCP_METADATA_POSITION:
+        *length += sizeof(uint64_t);
+        break;
+
+      case MCP_METADATA_OPT_POSITION:
+        *length += sizeof(uint8_t) + (entry->present ? sizeof(uint64_t) : 0);
+        break;
+
+      case MCP_METADATA_OPT_UUID:
+        *length += sizeof(uint8_t) + (entry->present ? sizeof(mcp_type_UUID) : 0);
+        break;
+
+      case MCP_METADATA_VILLAGER_DATA:
+        *length += mcp_length_varint(entry->value.villager[0]);
+        *length += mcp_length_varint(entry->value.villager[1]);
+        *length += mcp_length_varint(entry->value.villager[2]);
+        break;
+
+      case MCP_METADATA_OPT_CHAT:
+        *length += sizeof(uint8_t) + (entry->present ? entry->value.data.size : 0);
+        break;
+
+      default:
+        *length += entry->value.data.size;
+        break;
+    }
+  }
+  *length += sizeof(uint8_t);
+}
+void mcp_skip_type_EntityMetadata(mcp_buffer_t* src) {
+  uint8_t index;
+  while (mcp_metadata_next(src, &index)) {
+    if (!mcp_metadata_skip_value(mcp_decode_varint(src), src)) {
+      mcp_buffer_fail(src);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief initialize a metadata builder
+ *
+ * @param builder pointer to the builder
+ */
+void mcp_metadata_builder_init(mcp_metadata_builder_t* builder) {
+  memset(builder, 0, sizeof(mcp_metadata_builder_t));
+}
+
+/**
+ * @brief free a metadata builder
+ *
+ * @param builder pointer to the builder
+ */
+void mcp_metadata_builder_free(mcp_metadata_builder_t* builder) {
+  free(builder->state.entries);
+  free(builder->state.data);
+  free(builder->delta);
+  mcp_metadata_builder_init(builder);
+}
+
+/**
+ * @brief get the entry of an index, adding it if there is none
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param added   set to true if the entry was added
+ */
+static mcp_type_EntityMetadataEntry* mcp_metadata_builder_entry(mcp_metadata_builder_t* builder, uint8_t index, bool* added) {
+  assertd_false_custom("mcp_metadata_builder_entry", index == MCP_METADATA_END, "invalid metadata index");
+  *added = builder->positions[index] == 0;
+  if (!*added) {
+    return &builder->state.entries[builder->positions[index] - 1];
+  }
+  if (builder->state.count == builder->capacity) {
+    builder->capacity = builder->capacity == 0 ? 8 : builder->capacity * 2;
+    builder->state.entries = realloc(builder->state.entries, builder->capacity * sizeof(mcp_type_EntityMetadataEntry));
+    builder->delta = realloc(builder->delta, builder->capacity * sizeof(mcp_type_EntityMetadataEntry));
+    assertd_not_null("mcp_metadata_builder_entry", builder->state.entries);
+    assertd_not_null("mcp_metadata_builder_entry", builder->delta);
+  }
+  builder->positions[index] = ++builder->state.count;
+  mcp_type_EntityMetadataEntry* entry = &builder->state.entries[builder->state.count - 1];
+  memset(entry, 0, sizeof(mcp_type_EntityMetadataEntry));
+  entry->index = index;
+  return entry;
+}
+
+/**
+ * @brief mark an index as changed
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ */
+static inline void mcp_metadata_builder_change(mcp_metadata_builder_t* builder, uint8_t index) {
+  builder->dirty[index >> 6] |= (uint64_t) 1 << (index & 63);
+}
+
+/**
+ * @brief set an inline value
+ *
+ * @param builder pointer to the builder
+ * @param entry   entry with the index, type and value
+ *
+ * @return true if the value has changed
+ */
+bool mcp_metadata_set(mcp_metadata_builder_t* builder, mcp_type_EntityMetadataEntry* entry) {
+  assertd_false_custom("mcp_metadata_set", mcp_metadata_is_data(entry->type), "encoded value type");
+  bool added;
+  mcp_type_EntityMetadataEntry* current = mcp_metadata_builder_entry(builder, entry->index, &added);
+  if (!added && memcmp(current, entry, sizeof(mcp_type_EntityMetadataEntry)) == 0) {
+    return false;
+  }
+  *current = *entry;
+  mcp_metadata_builder_change(builder, entry->index);
+  return true;
+}
+
+/**
+ * @brief get space for an encoded value of an entry
+ *
+ * @param builder pointer to the builder
+ * @param entry   the entry
+ * @param size    value size
+ *
+ * @return pointer to the space
+ * @note values are overwritten in the slot of the index when they fit,
+ *         otherwise the slot is appended to the data
+ */
+static char* mcp_metadata_builder_space(mcp_metadata_builder_t* builder, mcp_type_EntityMetadataEntry* entry, size_t size) {
+  mcp_metadata_slot_t* slot = &builder->slots[entry->index];
+  if (slot->capacity < size) {
+    if (builder->state.size + size > builder->data_capacity) {
+      do {
+        builder->data_capacity = builder->data_capacity == 0 ? 64 : builder->data_capacity * 2;
+      } while (builder->state.size + size > builder->data_capacity);
+      builder->state.data = realloc(builder->state.data, builder->data_capacity);
+      assertd_not_null("mcp_metadata_builder_space", builder->state.data);
+    }
+    slot->offset = builder->state.size;
+    slot->capacity = size;
+    builder->state.size += size;
+  }
+  entry->value.data.offset = slot->offset;
+  entry->value.data.size = size;
+  return &builder->state.data[slot->offset];
+}
+
+/**
+ * @brief set an encoded value
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param type    string, chat, optional chat, slot, nbt or particle type
+ * @param data    encoded value
+ * @param size    value size
+ *
+ * @return true if the value has changed
+ */
+bool mcp_metadata_set_data(mcp_metadata_builder_t* builder, uint8_t index, uint8_t type, char* data, size_t size) {
+  assertd_true_custom("mcp_metadata_set_data", mcp_metadata_is_data(type), "inline value type");
+  bool added;
+  mcp_type_EntityMetadataEntry* entry = mcp_metadata_builder_entry(builder, index, &added);
+  bool present = data != NULL;
+  bool reuse = !added && mcp_metadata_is_data(entry->type);
+  if (reuse && entry->type == type && entry->present == present && entry->value.data.size == size
+      && memcmp(mcp_metadata_data(&builder->state, entry), data, size) == 0) {
+    return false;
+  }
+  if (!reuse) {
+    memset(&entry->value, 0, sizeof(entry->value));
+  }
+  entry->type = type;
+  entry->present = present;
+  if (present) {
+    memcpy(mcp_metadata_builder_space(builder, entry, size), data, size);
+  } else {
+    entry->value.data.size = 0;
+  }
+  mcp_metadata_builder_change(builder, index);
+  return true;
+}
+
+/**
+ * @brief set a string or chat value
+ *
+ * @param builder pointer to the builder
+ * @param index   entry index
+ * @param type    string, chat or optional chat type
+ * @param value   null-terminated string, NULL for absent optional chat
+ *
+ * @return true if the value has changed
+ */
+bool mcp_metadata_set_string(mcp_metadata_builder_t* builder, uint8_t index, uint8_t type, const char* value) {
+  if (value == NULL) {
+    return mcp_metadata_set_data(builder, index, type, NULL, 0);
+  }
+  size_t size = strlen(value);
+  mcp_type_EntityMetadataEntry* entry = builder->positions[index] != 0 ? &builder->state.entries[builder->positions[index] - 1] : NULL;
+  if (entry != NULL && entry->type == type && entry->present) {
+    string_view_t current = mcp_metadata_string(&builder->state, entry);
+    if (current.size == size && memcmp(current.data, value, size) == 0) {
+      return false;
+    }
+  }
+  char header[5];
+  size_t header_size = 0;
+  uint32_t length = size;
+  do {
+    header[header_size++] = (length & 0x7F) | (length > 0x7F ? 0x80 : 0);
+    length >>= 7;
+  } while (length != 0);
+  bool added;
+  entry = mcp_metadata_builder_entry(builder, index, &added);
+  bool reuse = !added && mcp_metadata_is_data(entry->type);
+  if (!reuse) {
+    memset(&entry->value, 0, sizeof(entry->value));
+  }
+  entry->type = type;
+  entry->present = true;
+  char* space = mcp_metadata_builder_space(builder, entry, header_size + size);
+  memcpy(space, header, header_size);
+  memcpy(space + header_size, value, size);
+  mcp_metadata_builder_change(builder, index);
+  return true;
+}
+
+/**
+ * @brief get changed entries and clear the changes
+ *
+ * @param builder pointer to the builder
+ * @param delta   metadata with the changed entries
+ * @param full    get every entry instead of the changed ones
+ *
+ * @return number of entries
+ */
+size_t mcp_metadata_builder_delta(mcp_metadata_builder_t* builder, mcp_type_EntityMetadata* delta, bool full) {
+  size_t count = 0;
+  for (size_t i = 0; i < builder->state.count; i++) {
+    uint8_t index = builder->state.entries[i].index;
+    if (full || (builder->dirty[index >> 6] >> (index & 63) & 1)) {
+      builder->delta[count++] = builder->state.entries[i];
+    }
+  }
+  memset(builder->dirty, 0, sizeof(builder->dirty));
+  delta->entries = builder->delta;
+  delta->count = count;
+  delta->data = builder->state.data;
+  delta->size = builder->state.size;
+  return count;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file metrics.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief per-packet counters and handler latency histograms
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/metrics.h"   /* this */
+#include "mcp/protocol.h"  /* packet descriptors */
+#include "csafe/assertd.h" /* debug assertions */
+#include <stdlib.h>        /* calloc */
+
+    /* variables */
+static const char* mcp_metrics_states[MCP_STATE__MAX] = { "handshaking", "status", "login", "play" };
+static const char* mcp_metrics_sources[MCP_SOURCE__MAX] = { "client", "server" };
+
+    /* functions */
+/**
+ * @brief initialize metrics with zero counters
+ *
+ * @param metrics pointer to the metrics
+ */
+void mcp_metrics_init(mcp_metrics_t* metrics) {
+    size_t count = 0;
+    for (int state = 0; state < MCP_STATE__MAX; state++) {
+        for (int source = 0; source < MCP_SOURCE__MAX; source++) {
+            count += mcp_protocol_max_ids[state][source];
+        }
+    }
+    mcp_metrics_packet_t* packets = calloc(count, sizeof(mcp_metrics_packet_t));
+    assertd_not_null("mcp_metrics_init", packets);
+    for (int state = 0; state < MCP_STATE__MAX; state++) {
+        for (int source = 0; source < MCP_SOURCE__MAX; source++) {
+            metrics->packets[state][source] = packets;
+            packets += mcp_protocol_max_ids[state][source];
+        }
+    }
+}
+
+/**
+ * @brief free metrics
+ *
+ * @param metrics pointer to the metrics
+ */
+void mcp_metrics_free(mcp_metrics_t* metrics) {
+    free(metrics->packets[0][0]);
+}
+
+/**
+ * @brief add a counter of another thread
+ *
+ * @param dest   destination counter
+ * @param source source counter
+ */
+static inline void mcp_metrics_merge_counter(mcp_metrics_counter_t* dest, mcp_metrics_counter_t* source) {
+    mcp_metrics_add(dest, atomic_load_explicit(source, memory_order_relaxed));
+}
+
+/**
+ * @brief add metrics of another thread
+ *
+ * @param dest   destination metrics
+ * @param source source metrics
+ */
+void mcp_metrics_merge(mcp_metrics_t* dest, mcp_metrics_t* source) {
+    for (int state = 0; state < MCP_STATE__MAX; state++) {
+        for (int source_id = 0; source_id < MCP_SOURCE__MAX; source_id++) {
+            for (size_t id = 0; id < mcp_protocol_max_ids[state][source_id]; id++) {
+                mcp_metrics_packet_t* to = &dest->packets[state][source_id][id];
+                mcp_metrics_packet_t* from = &source->packets[state][source_id][id];
+                if (atomic_load_explicit(&from->count, memory_order_relaxed) == 0) {
+                    continue;
+                }
+                mcp_metrics_merge_counter(&to->count, &from->count);
+                mcp_metrics_merge_counter(&to->handled, &from->handled);
+                mcp_metrics_merge_counter(&to->wire_bytes, &from->wire_bytes);
+                mcp_metrics_merge_counter(&to->packet_bytes, &from->packet_bytes);
+                mcp_metrics_merge_counter(&to->nanoseconds, &from->nanoseconds);
+                for (size_t bucket = 0; bucket < MCP_METRICS_BUCKETS; bucket++) {
+                    mcp_metrics_merge_counter(&to->buckets[bucket], &from->buckets[bucket]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief get the upper bound of a latency percentile
+ *
+ * @param packet   packet metrics
+ * @param quantile quantile between 0 and 1
+ */
+uint64_t mcp_metrics_percentile(mcp_metrics_packet_t* packet, double quantile) {
+    uint64_t total = 0;
+    for (size_t bucket = 0; bucket < MCP_METRICS_BUCKETS; bucket++) {
+        total += atomic_load_explicit(&packet->buckets[bucket], memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = quantile * total;
+    if (rank >= total) {
+        rank = total - 1;
+    }
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < MCP_METRICS_BUCKETS - 1; bucket++) {
+        seen += atomic_load_explicit(&packet->buckets[bucket], memory_order_relaxed);
+        if (seen > rank) {
+            return mcp_metrics_bucket_value(bucket + 1) - 1;
+        }
+    }
+    return UINT64_MAX;
+}
+
+/**
+ * @brief write metrics of every seen packet as JSON
+ *
+ * @param metrics pointer to the metrics
+ * @param file    destination file
+ */
+void mcp_metrics_write(mcp_metrics_t* metrics, FILE* file) {
+    for (int state = 0; state < MCP_STATE__MAX; state++) {
+        for (int source = 0; source < MCP_SOURCE__MAX; source++) {
+            for (size_t id = 0; id < mcp_protocol_max_ids[state][source]; id++) {
+                mcp_metrics_packet_t* packet = &metrics->packets[state][source][id];
+                uint64_t count = atomic_load_explicit(&packet->count, memory_order_relaxed);
+                if (count == 0) {
+                    continue;
+                }
+                uint64_t handled = atomic_load_explicit(&packet->handled, memory_order_relaxed);
+                uint64_t wire_bytes = atomic_load_explicit(&packet->wire_bytes, memory_order_relaxed);
+                uint64_t packet_bytes = atomic_load_explicit(&packet->packet_bytes, memory_order_relaxed);
+                uint64_t nanoseconds = atomic_load_explicit(&packet->nanoseconds, memory_order_relaxed);
+                fprintf(file, "{\"state\": \"%s\", \"source\": \"%s\", \"packet\": \"%s\", \"count\": %llu, \"handled\": %llu, "
+                        "\"wire_bytes\": %llu, \"packet_bytes\": %llu, \"compression_ratio\": %.3f, \"handler_ns\": %llu, "
+                        "\"mean_ns\": %.1f, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu}\n",
+                        mcp_metrics_states[state], mcp_metrics_sources[source], mcp_protocol_packets[state][source][id].name,
+                        (unsigned long long) count, (unsigned long long) handled,
+                        (unsigned long long) wire_bytes, (unsigned long long) packet_bytes,
+                        wire_bytes != 0 ? (double) packet_bytes / wire_bytes : 0.0, (unsigned long long) nanoseconds,
+                        handled != 0 ? (double) nanoseconds / handled : 0.0,
+                        (unsigned long long) mcp_metrics_percentile(packet, 0.5),
+                        (unsigned long long) mcp_metrics_percentile(packet, 0.99),
+                        (unsigned long long) mcp_metrics_percentile(packet, 0.999));
+            }
+        }
+    }
+}
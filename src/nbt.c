@@ -0,0 +1,449 @@
+/**
+ * @file nbt.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief named binary tag reader, tree and writer
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/nbt.h"       /* this */
+#include "csafe/assertd.h" /* debug assertions */
+#include <stdlib.h>        /* memory allocation */
+#include <string.h>        /* string operations */
+
+    /* typedefs */
+/**
+ * @brief open compound or list
+ */
+typedef struct mcp_nbt_frame_t {
+  uint8_t tag;
+  uint8_t element;
+  uint32_t remaining;
+} mcp_nbt_frame_t;
+
+/**
+ * @brief tree builder state
+ */
+typedef struct mcp_nbt_builder_t {
+  mcp_type_NbtTagCompound* compound;
+  uint32_t count;
+  size_t depth;
+  uint32_t parents[MCP_NBT_MAX_DEPTH];
+} mcp_nbt_builder_t;
+
+    /* variables */
+/**
+ * @brief payload size of number tags, indexed by tag type
+ */
+static const uint8_t mcp_nbt_sizes[] = { 0, 1, 2, 4, 8, 4, 8 };
+
+/**
+ * @brief element size of array tags, indexed by tag type
+ */
+static const uint8_t mcp_nbt_array_sizes[MCP_NBT_TAG__MAX] = {
+  [MCP_NBT_TAG_BYTE_ARRAY] = 1,
+  [MCP_NBT_TAG_INT_ARRAY] = 4,
+  [MCP_NBT_TAG_LONG_ARRAY] = 8
+};
+
+    /* functions */
+/**
+ * @brief read a big-endian length
+ *
+ * @param data source data
+ * @param size length size, 2 or 4 bytes
+ *
+ * @return the length, negative if it is invalid
+ */
+static inline int64_t mcp_nbt_read_length(char* data, size_t size) {
+  if (size == sizeof(uint16_t)) {
+    uint16_t length;
+    memcpy(&length, data, sizeof(length));
+    return be16toh(length);
+  }
+  uint32_t length;
+  memcpy(&length, data, sizeof(length));
+  return (int32_t) be32toh(length);
+}
+
+/**
+ * @brief read a named tag, calling a visitor for every value
+ *
+ * @param data    encoded tag after its type byte
+ * @param size    data size
+ * @param tag     tag type
+ * @param visitor visitor callback, NULL to only validate the tag
+ * @param user    visitor user data
+ * @param nodes   number of tree nodes of the tag, could be NULL
+ *
+ * @return length of the tag, 0 if it is malformed or the visitor stopped
+ */
+size_t mcp_nbt_read(char* data, size_t size, mcp_type_NbtTag tag, mcp_nbt_visitor_t* visitor, void* user, size_t* nodes) {
+  mcp_nbt_frame_t frames[MCP_NBT_MAX_DEPTH];
+  mcp_nbt_event_t event;
+  size_t depth = 0;
+  size_t count = 0;
+  size_t index = 0;
+  bool root = true;
+  do {
+    event.name.data = NULL;
+    event.name.size = 0;
+    if (root) {
+      root = false;
+    } else {
+      mcp_nbt_frame_t* parent = &frames[depth - 1];
+      bool end;
+      if (parent->tag == MCP_NBT_TAG_COMPOUND) {
+        if (index + 1 > size) {
+          return 0;
+        }
+        tag = (uint8_t) data[index++];
+        end = tag == MCP_NBT_TAG_END;
+      } else {
+        tag = parent->element;
+        end = parent->remaining == 0;
+        parent->remaining--;
+      }
+      if (end) {
+        depth--;
+        if (visitor != NULL) {
+          event.tag = MCP_NBT_TAG_END;
+          event.element = MCP_NBT_TAG_END;
+          event.value = &data[index];
+          event.size = 0;
+          event.depth = depth;
+          event.container = false;
+          if (!visitor(&event, user)) {
+            return 0;
+          }
+        }
+        continue;
+      }
+    }
+    if (tag == MCP_NBT_TAG_END || tag >= MCP_NBT_TAG__MAX) {
+      return 0;
+    }
+    if (depth == 0 || frames[depth - 1].tag == MCP_NBT_TAG_COMPOUND) {
+      if (index + sizeof(uint16_t) > size) {
+        return 0;
+      }
+      event.name.size = mcp_nbt_read_length(&data[index], sizeof(uint16_t));
+      event.name.data = &data[index + sizeof(uint16_t)];
+      index += sizeof(uint16_t) + event.name.size;
+    }
+    event.tag = tag;
+    event.element = MCP_NBT_TAG_END;
+    event.size = 0;
+    event.depth = depth;
+    event.container = false;
+    size_t payload;
+    switch (tag) {
+      case MCP_NBT_TAG_BYTE_ARRAY:
+      case MCP_NBT_TAG_INT_ARRAY:
+      case MCP_NBT_TAG_LONG_ARRAY:
+      case MCP_NBT_TAG_STRING: {
+        size_t header = tag == MCP_NBT_TAG_STRING ? sizeof(uint16_t) : sizeof(uint32_t);
+        if (index + header > size) {
+          return 0;
+        }
+        int64_t length = mcp_nbt_read_length(&data[index], header);
+        if (length < 0) {
+          return 0;
+        }
+        event.size = length;
+        index += header;
+        payload = tag == MCP_NBT_TAG_STRING ? (size_t) length : (size_t) length * mcp_nbt_array_sizes[tag];
+        break;
+      }
+      case MCP_NBT_TAG_LIST: {
+        if (index + sizeof(uint8_t) + sizeof(uint32_t) > size) {
+          return 0;
+        }
+        event.element = (uint8_t) data[index];
+        int64_t length = mcp_nbt_read_length(&data[index + sizeof(uint8_t)], sizeof(uint32_t));
+        if (length < 0 || event.element >= MCP_NBT_TAG__MAX || (event.element == MCP_NBT_TAG_END && length != 0)) {
+          return 0;
+        }
+        event.size = length;
+        index += sizeof(uint8_t) + sizeof(uint32_t);
+        if (event.element <= MCP_NBT_TAG_DOUBLE) {
+          payload = (size_t) length * mcp_nbt_sizes[event.element];
+        } else {
+          payload = 0;
+          event.container = true;
+        }
+        break;
+      }
+      case MCP_NBT_TAG_COMPOUND:
+        payload = 0;
+        event.container = true;
+        break;
+      default:
+        payload = mcp_nbt_sizes[tag];
+        break;
+    }
+    if (index > size || payload > size - index) {
+      return 0;
+    }
+    event.value = &data[index];
+    index += payload;
+    count++;
+    if (event.container) {
+      if (depth == MCP_NBT_MAX_DEPTH) {
+        return 0;
+      }
+      frames[depth].tag = tag;
+      frames[depth].element = event.element;
+      frames[depth].remaining = event.size;
+      depth++;
+    }
+    if (visitor != NULL && !visitor(&event, user)) {
+      return 0;
+    }
+  } while (depth > 0);
+  if (nodes != NULL) {
+    *nodes = count;
+  }
+  return index;
+}
+
+/**
+ * @brief add a node to a compound tree
+ *
+ * @param event reader event
+ * @param user  tree builder state
+ */
+static bool mcp_nbt_build(mcp_nbt_event_t* event, void* user) {
+  mcp_nbt_builder_t* builder = user;
+  mcp_type_NbtNode* nodes = builder->compound->nodes;
+  if (event->tag == MCP_NBT_TAG_END) {
+    nodes[builder->parents[--builder->depth]].next = builder->count;
+    return true;
+  }
+  mcp_type_NbtNode* node = &nodes[builder->count];
+  node->tag = event->tag;
+  node->element = event->element;
+  node->name_size = event->name.size;
+  node->name = event->name.data != NULL ? event->name.data - builder->compound->data : 0;
+  node->value = event->value - builder->compound->data;
+  node->size = event->size;
+  node->next = builder->count + 1;
+  if (builder->depth > 0 && nodes[builder->parents[builder->depth - 1]].tag == MCP_NBT_TAG_COMPOUND) {
+    nodes[builder->parents[builder->depth - 1]].size++;
+  }
+  if (event->container) {
+    builder->parents[builder->depth++] = builder->count;
+  }
+  builder->count++;
+  return true;
+}
+
+/**
+ * @brief build a compound tree from the encoded compound after its type byte
+ *
+ * @param this      the compound
+ * @param data      encoded compound after its type byte
+ * @param size      data size
+ * @param allocator buffer used to allocate the tree, NULL for malloc
+ *
+ * @return length of the compound, 0 if it is malformed
+ */
+static size_t mcp_nbt_tree(mcp_type_NbtTagCompound* this, char* data, size_t size, mcp_buffer_t* allocator) {
+  size_t count;
+  size_t length = mcp_nbt_measure(data, size, MCP_NBT_TAG_COMPOUND, &count);
+  if (length == 0) {
+    return 0;
+  }
+  size_t memory = count * sizeof(mcp_type_NbtNode) + length;
+  this->nodes = allocator != NULL ? mcp_buffer_decode_allocate(allocator, memory) : malloc(memory);
+  assertd_not_null("mcp_nbt_tree", this->nodes);
+  this->count = count;
+  this->data = (char*) &this->nodes[count];
+  this->size = length;
+  memcpy(this->data, data, length);
+  mcp_nbt_builder_t builder;
+  builder.compound = this;
+  builder.count = 0;
+  builder.depth = 0;
+  mcp_nbt_read(this->data, length, MCP_NBT_TAG_COMPOUND, mcp_nbt_build, &builder, NULL);
+  return length;
+}
+
+/**
+ * @brief build a compound tree from encoded data
+ *
+ * @param this the compound
+ * @param data encoded compound starting with its type byte
+ * @param size data size
+ *
+ * @return false if the data is malformed
+ */
+bool mcp_nbt_parse(mcp_type_NbtTagCompound* this, char* data, size_t size) {
+  memset(this, 0, sizeof(mcp_type_NbtTagCompound));
+  if (size == 0) {
+    return false;
+  }
+  if (data[0] == MCP_NBT_TAG_END) {
+    return true;
+  }
+  return data[0] == MCP_NBT_TAG_COMPOUND && mcp_nbt_tree(this, data + 1, size - 1, NULL) != 0;
+}
+
+/**
+ * @brief find a child of a compound node by its name
+ *
+ * @param this     the compound
+ * @param compound compound node
+ * @param name     child name
+ *
+ * @return the child, NULL if there is none
+ */
+mcp_type_NbtNode* mcp_nbt_find(mcp_type_NbtTagCompound* this, mcp_type_NbtNode* compound, const char* name) {
+  size_t size = strlen(name);
+  for (mcp_type_NbtNode* node = mcp_nbt_child(this, compound); node != NULL; node = mcp_nbt_next(this, compound, node)) {
+    if (node->name_size == size && memcmp(&this->data[node->name], name, size) == 0) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief write a string with its 16-bit length
+ *
+ * @param dest   destination buffer
+ * @param string null-terminated string
+ *
+ * @note longer strings are cut to UINT16_MAX bytes without debug assertions
+ */
+static void mcp_nbt_write_text(mcp_buffer_t* dest, const char* string) {
+  size_t size = strlen(string);
+  assertd_false_custom("mcp_nbt_write_text", size > UINT16_MAX, "nbt string is too long");
+  if (size > UINT16_MAX) {
+    size = UINT16_MAX;
+  }
+  mcp_buffer_reserve(dest, sizeof(uint16_t) + size);
+  mcp_encode_be16(size, dest);
+  memcpy(mcp_buffer_current(dest), string, size);
+  mcp_buffer_increment(dest, size);
+}
+
+/**
+ * @brief write the type byte and the name of a tag
+ *
+ * @param dest destination buffer
+ * @param tag  tag type
+ * @param name tag name
+ */
+void mcp_nbt_write_tag(mcp_buffer_t* dest, mcp_type_NbtTag tag, const char* name) {
+  mcp_encode_byte(tag, dest);
+  mcp_nbt_write_text(dest, name);
+}
+
+/**
+ * @brief write a string tag
+ *
+ * @param dest  destination buffer
+ * @param name  tag name
+ * @param value null-terminated string
+ */
+void mcp_nbt_write_string(mcp_buffer_t* dest, const char* name, const char* value) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_STRING, name);
+  mcp_nbt_write_text(dest, value);
+}
+
+/**
+ * @brief write the header of a list tag
+ *
+ * @param dest    destination buffer
+ * @param name    tag name
+ * @param element element tag type
+ * @param count   number of elements
+ */
+void mcp_nbt_write_list(mcp_buffer_t* dest, const char* name, mcp_type_NbtTag element, int32_t count) {
+  mcp_nbt_write_tag(dest, MCP_NBT_TAG_LIST, name);
+  mcp_encode_byte(element, dest);
+  mcp_encode_be32(count, dest);
+}
+
+/**
+ * @brief write an array tag
+ *
+ * @param dest   destination buffer
+ * @param name   tag name
+ * @param tag    byte, int or long array tag type
+ * @param values int8_t, int32_t or int64_t values
+ * @param count  number of values
+ */
+void mcp_nbt_write_array(mcp_buffer_t* dest, const char* name, mcp_type_NbtTag tag, void* values, int32_t count) {
+  assertd_false_custom("mcp_nbt_write_array", tag >= MCP_NBT_TAG__MAX || mcp_nbt_array_sizes[tag] == 0, "invalid array tag");
+  mcp_nbt_write_tag(dest, tag, name);
+  mcp_encode_be32(count, dest);
+  mcp_buffer_reserve(dest, (size_t) count * mcp_nbt_array_sizes[tag]);
+  for (int32_t i = 0; i < count; i++) {
+    switch (tag) {
+      case MCP_NBT_TAG_INT_ARRAY:
+        mcp_encode_be32(((int32_t*) values)[i], dest);
+        break;
+      case MCP_NBT_TAG_LONG_ARRAY:
+        mcp_encode_be64(((int64_t*) values)[i], dest);
+        break;
+      default:
+        mcp_encode_byte(((int8_t*) values)[i], dest);
+        break;
+    }
+  }
+}
+
+/**
+ * nbt compound
+ */
+void mcp_encode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* dest) {
+  if (this->nodes == NULL) {
+    mcp_encode_byte(MCP_NBT_TAG_END, dest);
+    return;
+  }
+  mcp_buffer_reserve(dest, sizeof(uint8_t) + this->size);
+  mcp_encode_byte(MCP_NBT_TAG_COMPOUND, dest);
+  memcpy(mcp_buffer_current(dest), this->data, this->size);
+  mcp_buffer_increment(dest, this->size);
+}
+void mcp_decode_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src) {
+  uint8_t tag;
+  memset(this, 0, sizeof(mcp_type_NbtTagCompound));
+  if (!mcp_buffer_check(src, sizeof(uint8_t))) {
+    return;
+  }
+  mcp_decode_byte(&tag, src);
+  if (tag == MCP_NBT_TAG_COMPOUND) {
+    mcp_read_type_NbtTagCompound(this, src);
+  } else if (tag != MCP_NBT_TAG_END) {
+    mcp_buffer_fail(src);
+  }
+}
+void mcp_read_type_NbtTagCompound(mcp_type_NbtTagCompound* this, mcp_buffer_t* src) {
+  size_t length = mcp_nbt_tree(this, mcp_buffer_current(src), src->size - src->index, src);
+  if (length == 0) {
+    memset(this, 0, sizeof(mcp_type_NbtTagCompound));
+    mcp_buffer_fail(src);
+    return;
+  }
+  mcp_buffer_increment(src, length);
+}
+void mcp_skip_type_NbtTagCompound(mcp_buffer_t* src) {
+  uint8_t tag;
+  if (!mcp_buffer_check(src, sizeof(uint8_t))) {
+    return;
+  }
+  mcp_decode_byte(&tag, src);
+  if (tag == MCP_NBT_TAG_COMPOUND) {
+    size_t length = mcp_nbt_measure(mcp_buffer_current(src), src->size - src->index, MCP_NBT_TAG_COMPOUND, NULL);
+    if (length == 0) {
+      mcp_buffer_fail(src);
+      return;
+    }
+    mcp_buffer_increment(src, length);
+  } else if (tag != MCP_NBT_TAG_END) {
+    mcp_buffer_fail(src);
+  }
+}
@@ -0,0 +1,364 @@
+/**
+ * @file reactor.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief non-blocking event loop for many connections
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/reactor.h"   /* this */
+#include "mcp/io/uring.h"  /* io_uring backend */
+#include "csafe/assertd.h" /* debug assertions */
+#include <sys/epoll.h>     /* epoll */
+#include <sys/socket.h>    /* accept */
+#include <errno.h>         /* error codes */
+
+    /* functions */
+/**
+ * @brief initialize a reactor
+ *
+ * @param reactor pointer to the reactor
+ * @param close   connection close callback
+ *
+ * @return false on failure
+ */
+bool mcp_reactor_init(mcp_reactor_t* reactor, mcp_reactor_close_t* close) {
+    return mcp_reactor_init_backend(reactor, close, MCP_REACTOR_AUTO);
+}
+
+/**
+ * @brief initialize a reactor with a specific backend
+ *
+ * @param reactor pointer to the reactor
+ * @param close   connection close callback
+ * @param backend requested backend
+ *
+ * @return false on failure or if the backend is not available
+ */
+bool mcp_reactor_init_backend(mcp_reactor_t* reactor, mcp_reactor_close_t* close, mcp_reactor_backend_t backend) {
+    reactor->epoll = -1;
+    reactor->uring = NULL;
+    reactor->batch = NULL;
+    reactor->batch_size = 0;
+    reactor->count = 0;
+    reactor->close = close;
+    reactor->listener = -1;
+    reactor->accept = NULL;
+    reactor->handlers = NULL;
+    reactor->metrics = NULL;
+    mcp_region_init(&reactor->input, MCP_REGION_DEFAULT_LIMIT);
+    if (backend != MCP_REACTOR_EPOLL) {
+        reactor->uring = mcp_uring_create(reactor);
+        if (reactor->uring != NULL) {
+            return true;
+        }
+        if (backend == MCP_REACTOR_IO_URING) {
+            return false;
+        }
+    }
+    reactor->epoll = epoll_create1(EPOLL_CLOEXEC);
+    return reactor->epoll >= 0;
+}
+
+/**
+ * @brief add a connection to a reactor
+ *
+ * @param reactor pointer to the reactor
+ * @param context initialized connection context
+ *
+ * @return false on failure
+ */
+bool mcp_reactor_add(mcp_reactor_t* reactor, mcp_context_t* context) {
+    if (!mcp_stream_blocking(context->buffer.stream, false)) {
+        return false;
+    }
+    context->input.region.limit = MCP_REACTOR_CONTEXT_LIMIT;
+    context->frame.limit = MCP_REACTOR_CONTEXT_LIMIT;
+    context->output.region.limit = MCP_REACTOR_CONTEXT_LIMIT;
+    if (context->handlers == NULL) {
+        context->handlers = reactor->handlers;
+    }
+    if (context->metrics == NULL) {
+        context->metrics = reactor->metrics;
+    }
+    if (reactor->uring != NULL) {
+        if (!mcp_uring_add(reactor, context)) {
+            return false;
+        }
+    } else {
+        struct epoll_event event = {
+            .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+            .data.ptr = context
+        };
+        if (epoll_ctl(reactor->epoll, EPOLL_CTL_ADD, context->buffer.stream, &event) != 0) {
+            return false;
+        }
+    }
+    reactor->count++;
+    return true;
+}
+
+/**
+ * @brief accept connections from a listening stream
+ *
+ * @param reactor pointer to the reactor
+ * @param stream  non-blocking listening stream
+ * @param accept  connection accept callback
+ *
+ * @return false on failure
+ */
+bool mcp_reactor_listen(mcp_reactor_t* reactor, mcp_stream_t stream, mcp_reactor_accept_t* accept) {
+    reactor->listener = stream;
+    reactor->accept = accept;
+    if (reactor->uring != NULL) {
+        return mcp_uring_listen(reactor);
+    }
+    struct epoll_event event = {
+        .events = EPOLLIN | EPOLLET,
+        .data.ptr = reactor
+    };
+    return epoll_ctl(reactor->epoll, EPOLL_CTL_ADD, stream, &event) == 0;
+}
+
+/**
+ * @brief create a connection for an accepted stream and add it to a reactor
+ *
+ * @param reactor pointer to the reactor
+ * @param stream  accepted stream
+ *
+ * @return false if the connection was rejected or could not be added
+ */
+bool mcp_reactor_adopt(mcp_reactor_t* reactor, mcp_stream_t stream) {
+    mcp_context_t* context = reactor->accept(reactor, stream);
+    if (context == NULL) {
+        close(stream);
+        return false;
+    }
+    if (!mcp_reactor_add(reactor, context)) {
+        if (reactor->close != NULL) {
+            reactor->close(reactor, context);
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief accept all pending connections from the listening stream
+ *
+ * @param reactor pointer to the reactor
+ */
+static void mcp_reactor_accept(mcp_reactor_t* reactor) {
+    while (true) {
+        mcp_stream_t stream = accept(reactor->listener, NULL, NULL);
+        if (stream < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;
+        }
+        mcp_reactor_adopt(reactor, stream);
+    }
+}
+
+/**
+ * @brief remove a connection from a reactor without closing it
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ */
+void mcp_reactor_remove(mcp_reactor_t* reactor, mcp_context_t* context) {
+    if (reactor->uring != NULL) {
+        if (context->transport != NULL) {
+            mcp_uring_remove(reactor, context, false);
+            reactor->count--;
+        }
+        return;
+    }
+    struct epoll_event* events = reactor->batch;
+    for (int i = 0; i < reactor->batch_size; i++) {
+        if (events[i].data.ptr == context) {
+            events[i].data.ptr = NULL;
+        }
+    }
+    if (epoll_ctl(reactor->epoll, EPOLL_CTL_DEL, context->buffer.stream, NULL) == 0) {
+        reactor->count--;
+    }
+}
+
+/**
+ * @brief send packets queued by a connection outside of its handlers
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ */
+void mcp_reactor_flush(mcp_reactor_t* reactor, mcp_context_t* context) {
+    if (reactor->uring != NULL) {
+        mcp_uring_flush(reactor, context);
+    } else if (mcp_output_pending(&context->output) && !mcp_flush(context)) {
+        mcp_reactor_close(reactor, context);
+    }
+}
+
+/**
+ * @brief handle packets buffered in the connection input
+ *
+ * @param context connection context
+ *
+ * @return false if the connection should be closed
+ */
+static bool mcp_reactor_dispatch(mcp_context_t* context) {
+    int handled = mcp_receive_buffered(context);
+    if (mcp_input_available(&context->input) == 0) {
+        mcp_input_free(&context->input);
+    }
+    return handled >= 0;
+}
+
+/**
+ * @brief handle data received by a connection
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ * @param src     received data
+ * @param size    number of received bytes
+ *
+ * @return false if the connection should be closed
+ */
+bool mcp_reactor_deliver(mcp_reactor_t* reactor, mcp_context_t* context, char* src, size_t size) {
+    if (mcp_input_available(&context->input) != 0) {
+        mcp_input_write(&context->input, src, size);
+        return mcp_reactor_dispatch(context);
+    }
+    mcp_input_t own = context->input;
+    context->input.region.data = src;
+    context->input.region.capacity = size;
+    context->input.region.limit = 0;
+    context->input.begin = 0;
+    context->input.end = size;
+    int handled = mcp_receive_buffered(context);
+    size_t left = mcp_input_available(&context->input);
+    char* current = mcp_input_current(&context->input);
+    context->input = own;
+    if (handled >= 0 && left != 0) {
+        mcp_input_write(&context->input, current, left);
+    }
+    return handled >= 0;
+}
+
+/**
+ * @brief read everything available from a connection and handle received packets
+ *
+ * connections without buffered bytes read into the reactor input,
+ * so idle connections do not keep any input memory
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ *
+ * @return false if the connection should be closed
+ */
+static bool mcp_reactor_read(mcp_reactor_t* reactor, mcp_context_t* context) {
+    char* data = mcp_region_reserve(&reactor->input, MCP_INPUT_DEFAULT_SIZE);
+    while (true) {
+        ssize_t received;
+        bool alive;
+        if (mcp_input_available(&context->input) == 0) {
+            received = read(context->buffer.stream, data, MCP_INPUT_DEFAULT_SIZE);
+            alive = received <= 0 || mcp_reactor_deliver(reactor, context, data, received);
+        } else {
+            received = mcp_input_receive(&context->input, context->buffer.stream);
+            alive = received <= 0 || mcp_reactor_dispatch(context);
+        }
+        if (received == 0 || !alive) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+}
+
+/**
+ * @brief remove a connection and pass it to the close callback
+ *
+ * @param reactor pointer to the reactor
+ * @param context connection context
+ */
+void mcp_reactor_close(mcp_reactor_t* reactor, mcp_context_t* context) {
+    if (reactor->uring != NULL) {
+        if (context->transport != NULL) {
+            mcp_uring_remove(reactor, context, true);
+            reactor->count--;
+        }
+        return;
+    }
+    mcp_reactor_remove(reactor, context);
+    if (reactor->close != NULL) {
+        reactor->close(reactor, context);
+    }
+}
+
+/**
+ * @brief wait for events and handle them
+ *
+ * @param reactor pointer to the reactor
+ * @param timeout maximum wait time in milliseconds, -1 for infinite
+ *
+ * @return number of handled events, or -1 on failure
+ */
+int mcp_reactor_run(mcp_reactor_t* reactor, int timeout) {
+    if (reactor->uring != NULL) {
+        return mcp_uring_run(reactor, timeout);
+    }
+    struct epoll_event events[MCP_REACTOR_EVENTS];
+    int count = epoll_wait(reactor->epoll, events, MCP_REACTOR_EVENTS, timeout);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    /* connections closed by handlers are cleared from the batch */
+    reactor->batch = events;
+    reactor->batch_size = count;
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.ptr == reactor) {
+            mcp_reactor_accept(reactor);
+            continue;
+        }
+        mcp_context_t* context = events[i].data.ptr;
+        if (context == NULL) {
+            continue;
+        }
+        bool alive = !(events[i].events & EPOLLERR);
+        if (alive && events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+            alive = mcp_reactor_read(reactor, context);
+        }
+        if (events[i].data.ptr == NULL) {
+            continue;
+        }
+        if (alive && events[i].events & EPOLLOUT && mcp_output_pending(&context->output)) {
+            alive = mcp_flush(context);
+        }
+        if (!alive) {
+            mcp_reactor_close(reactor, context);
+        }
+    }
+    reactor->batch = NULL;
+    reactor->batch_size = 0;
+    return count;
+}
+
+/**
+ * @brief free a reactor
+ *
+ * @param reactor pointer to the reactor
+ */
+void mcp_reactor_free(mcp_reactor_t* reactor) {
+    if (reactor->uring != NULL) {
+        mcp_uring_free(reactor);
+    } else {
+        close(reactor->epoll);
+    }
+    mcp_region_free(&reactor->input);
+}
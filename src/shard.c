@@ -0,0 +1,156 @@
+/**
+ * @file shard.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief multi-threaded connection sharding
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* feature test */
+#define _GNU_SOURCE /* pthread_setaffinity_np */
+
+    /* includes */
+#include "mcp/shard.h"     /* this */
+#include "csafe/assertd.h" /* debug assertions */
+#include <sched.h>         /* processor sets */
+#include <stdlib.h>        /* malloc */
+#include <string.h>        /* memset */
+#include <unistd.h>        /* sysconf */
+
+    /* functions */
+/**
+ * @brief initialize a shard group
+ *
+ * @param group  pointer to the shard group
+ * @param count  number of shards, 0 for the number of online processors
+ * @param host   local address, NULL for any
+ * @param port   local port
+ * @param accept connection accept callback
+ * @param close  connection close callback
+ *
+ * @return false on failure
+ */
+bool mcp_shard_group_init(mcp_shard_group_t* group, size_t count, const char* host, const char* port,
+                          mcp_reactor_accept_t* accept, mcp_reactor_close_t* close) {
+    if (count == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        count = processors > 0 ? processors : 1;
+    }
+    group->shards = malloc(count * sizeof(mcp_shard_t));
+    assertd_not_null("mcp_shard_group_init", group->shards);
+    memset(group->shards, 0, count * sizeof(mcp_shard_t));
+    group->count = 0;
+    atomic_init(&group->running, false);
+    for (size_t i = 0; i < count; i++) {
+        mcp_shard_t* shard = &group->shards[i];
+        shard->index = i;
+        shard->group = group;
+        if (!mcp_reactor_init(&shard->reactor, close)) {
+            mcp_shard_group_free(group);
+            return false;
+        }
+        shard->listener = mcp_stream_listen(host, port, true);
+        mcp_handler_table_init(&shard->handlers);
+        mcp_metrics_init(&shard->metrics);
+        mcp_arena_init(&shard->arena, MCP_REGION_DEFAULT_LIMIT);
+        group->count++;
+        if (shard->listener < 0 || !mcp_reactor_listen(&shard->reactor, shard->listener, accept)) {
+            mcp_shard_group_free(group);
+            return false;
+        }
+        shard->reactor.handlers = &shard->handlers;
+        shard->reactor.metrics = &shard->metrics;
+    }
+    return true;
+}
+
+/**
+ * @brief run the reactor of a shard until the group is stopped
+ *
+ * @param argument pointer to the shard
+ */
+static void* mcp_shard_run(void* argument) {
+    mcp_shard_t* shard = argument;
+    while (atomic_load_explicit(&shard->group->running, memory_order_relaxed)) {
+        if (mcp_reactor_run(&shard->reactor, MCP_SHARD_TIMEOUT) < 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief start the shard threads
+ *
+ * @param group pointer to the shard group
+ *
+ * @return false if a thread could not be started
+ */
+bool mcp_shard_group_start(mcp_shard_group_t* group) {
+    atomic_store(&group->running, true);
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    for (size_t i = 0; i < group->count; i++) {
+        mcp_shard_t* shard = &group->shards[i];
+        if (pthread_create(&shard->thread, NULL, mcp_shard_run, shard) != 0) {
+            atomic_store(&group->running, false);
+            for (size_t j = 0; j < i; j++) {
+                pthread_join(group->shards[j].thread, NULL);
+            }
+            return false;
+        }
+        if (processors > 1) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % processors, &set);
+            pthread_setaffinity_np(shard->thread, sizeof(cpu_set_t), &set);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief stop the shard threads and wait for them to finish
+ *
+ * @param group pointer to the shard group
+ */
+void mcp_shard_group_stop(mcp_shard_group_t* group) {
+    if (!atomic_exchange(&group->running, false)) {
+        return;
+    }
+    for (size_t i = 0; i < group->count; i++) {
+        pthread_join(group->shards[i].thread, NULL);
+    }
+}
+
+/**
+ * @brief free a shard group
+ *
+ * @param group pointer to the shard group
+ */
+void mcp_shard_group_free(mcp_shard_group_t* group) {
+    mcp_shard_group_stop(group);
+    for (size_t i = 0; i < group->count; i++) {
+        mcp_shard_t* shard = &group->shards[i];
+        mcp_reactor_free(&shard->reactor);
+        mcp_handler_table_free(&shard->handlers);
+        mcp_metrics_free(&shard->metrics);
+        mcp_arena_free(&shard->arena);
+        if (shard->listener >= 0) {
+            close(shard->listener);
+        }
+    }
+    free(group->shards);
+    group->shards = NULL;
+    group->count = 0;
+}
+
+/**
+ * @brief add metrics of every shard
+ *
+ * @param group    pointer to the shard group
+ * @param snapshot initialized metrics
+ */
+void mcp_shard_group_metrics(mcp_shard_group_t* group, mcp_metrics_t* snapshot) {
+    for (size_t i = 0; i < group->count; i++) {
+        mcp_metrics_merge(snapshot, &group->shards[i].metrics);
+    }
+}
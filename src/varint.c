@@ -0,0 +1,333 @@
+/**
+ * @file varint.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief bulk encoders/decoders for varint arrays
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * decoders take 16 bytes at a time and convert the leading
+ * one or two byte varints with a few vector operations,
+ * longer varints are decoded one by one,
+ * the kernel is chosen at runtime from the cpu features,
+ * kernels return NULL if the source ends inside a varint
+ * or a varint is longer than 5 bytes,
+ * values are 32-bit and sign extended into 64-bit arrays,
+ * as mcp_decode_varint does
+ */
+      /* includes */
+#include "mcp/codec.h" /* this */
+#include <stdint.h>    /* integer types */
+#include <string.h>    /* memset */
+
+      /* defines */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define MCP_VARINT_X86
+  #include <immintrin.h> /* vector intrinsics */
+#endif /* __GNUC__ && x86 */
+
+      /* functions */
+/**
+ * decode a single varint and move the pointer past it,
+ * the pointer is set to NULL if the varint does not end before end
+ * or within 5 bytes
+ */
+static inline uint32_t mcp_varint_next(const uint8_t** src, const uint8_t* end) {
+  const uint8_t* byte = *src;
+  if (end - byte >= 2) {
+    if (!(byte[0] & 0x80)) {
+      *src = byte + 1;
+      return byte[0];
+    }
+    if (!(byte[1] & 0x80)) {
+      *src = byte + 2;
+      return (byte[0] & 0x7F) | (uint32_t) byte[1] << 7;
+    }
+  }
+  uint32_t value = 0;
+  for (int shift = 0; shift < 35 && byte != end; shift += 7) {
+    value |= (uint32_t) (*byte & 0x7F) << shift;
+    if (!(*byte++ & 0x80)) {
+      *src = byte;
+      return value;
+    }
+  }
+  *src = NULL;
+  return 0;
+}
+
+/**
+ * encode a single varint and move the pointer past it,
+ * negative values take 5 bytes as in mcp_encode_varint
+ */
+static inline void mcp_varint_put(uint32_t value, uint8_t** dest) {
+  uint8_t* byte = *dest;
+  for (; value >= 0x80; value >>= 7) {
+    *byte++ = 0x80 | (value & 0x7F);
+  }
+  *byte++ = value;
+  *dest = byte;
+}
+
+/**
+ * scalar kernels
+ */
+static const uint8_t* mcp_decode_varint_array_scalar(int32_t* this, size_t count, const uint8_t* src, size_t size) {
+  const uint8_t* end = src + size;
+  for (size_t i = 0; i < count && src != NULL; i++) {
+    this[i] = (int32_t) mcp_varint_next(&src, end);
+  }
+  return src;
+}
+static const uint8_t* mcp_decode_varint_array64_scalar(int64_t* this, size_t count, const uint8_t* src, size_t size) {
+  const uint8_t* end = src + size;
+  for (size_t i = 0; i < count && src != NULL; i++) {
+    this[i] = (int32_t) mcp_varint_next(&src, end);
+  }
+  return src;
+}
+
+#ifdef MCP_VARINT_X86
+/**
+ * convert 16 one byte varints
+ */
+__attribute__((target("sse4.1")))
+static inline void mcp_varint_widen8_sse41(int32_t* this, __m128i bytes) {
+  _mm_storeu_si128((__m128i*) &this[0], _mm_cvtepu8_epi32(bytes));
+  _mm_storeu_si128((__m128i*) &this[4], _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)));
+  _mm_storeu_si128((__m128i*) &this[8], _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+  _mm_storeu_si128((__m128i*) &this[12], _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12)));
+}
+__attribute__((target("sse4.1")))
+static inline void mcp_varint_widen8_64_sse41(int64_t* this, __m128i bytes) {
+  for (int i = 0; i < 8; i++) {
+    _mm_storeu_si128((__m128i*) &this[i * 2], _mm_cvtepu8_epi64(bytes));
+    bytes = _mm_srli_si128(bytes, 2);
+  }
+}
+__attribute__((target("avx2")))
+static inline void mcp_varint_widen8_avx2(int32_t* this, __m128i bytes) {
+  _mm256_storeu_si256((__m256i*) &this[0], _mm256_cvtepu8_epi32(bytes));
+  _mm256_storeu_si256((__m256i*) &this[8], _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+}
+__attribute__((target("avx2")))
+static inline void mcp_varint_widen8_64_avx2(int64_t* this, __m128i bytes) {
+  _mm256_storeu_si256((__m256i*) &this[0], _mm256_cvtepu8_epi64(bytes));
+  _mm256_storeu_si256((__m256i*) &this[4], _mm256_cvtepu8_epi64(_mm_srli_si128(bytes, 4)));
+  _mm256_storeu_si256((__m256i*) &this[8], _mm256_cvtepu8_epi64(_mm_srli_si128(bytes, 8)));
+  _mm256_storeu_si256((__m256i*) &this[12], _mm256_cvtepu8_epi64(_mm_srli_si128(bytes, 12)));
+}
+
+/**
+ * convert 8 varints of at most two bytes, one per 16-bit lane
+ */
+__attribute__((target("sse4.1")))
+static inline __m128i mcp_varint_join16(__m128i bytes) {
+  return _mm_or_si128(_mm_and_si128(bytes, _mm_set1_epi16(0x007F)),
+                      _mm_and_si128(_mm_srli_epi16(bytes, 1), _mm_set1_epi16(0x3F80)));
+}
+__attribute__((target("sse4.1")))
+static inline void mcp_varint_widen16_sse41(int32_t* this, __m128i bytes) {
+  __m128i words = mcp_varint_join16(bytes);
+  _mm_storeu_si128((__m128i*) &this[0], _mm_cvtepu16_epi32(words));
+  _mm_storeu_si128((__m128i*) &this[4], _mm_cvtepu16_epi32(_mm_srli_si128(words, 8)));
+}
+__attribute__((target("sse4.1")))
+static inline void mcp_varint_widen16_64_sse41(int64_t* this, __m128i bytes) {
+  __m128i words = mcp_varint_join16(bytes);
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_si128((__m128i*) &this[i * 2], _mm_cvtepu16_epi64(words));
+    words = _mm_srli_si128(words, 4);
+  }
+}
+__attribute__((target("avx2")))
+static inline void mcp_varint_widen16_avx2(int32_t* this, __m128i bytes) {
+  _mm256_storeu_si256((__m256i*) this, _mm256_cvtepu16_epi32(mcp_varint_join16(bytes)));
+}
+__attribute__((target("avx2")))
+static inline void mcp_varint_widen16_64_avx2(int64_t* this, __m128i bytes) {
+  __m128i words = mcp_varint_join16(bytes);
+  _mm256_storeu_si256((__m256i*) &this[0], _mm256_cvtepu16_epi64(words));
+  _mm256_storeu_si256((__m256i*) &this[4], _mm256_cvtepu16_epi64(_mm_srli_si128(words, 8)));
+}
+
+/**
+ * layout of one and two byte varints in 8 bytes,
+ * indexed by the continuation bits of the bytes
+ */
+typedef struct mcp_varint_pattern_t {
+  uint8_t shuffle[16];
+  uint8_t count;
+  uint8_t length;
+} mcp_varint_pattern_t;
+static mcp_varint_pattern_t mcp_varint_patterns[256];
+
+/**
+ * fill the pattern table, each varint is moved into its own 16-bit lane
+ */
+__attribute__((constructor))
+static void mcp_varint_patterns_init() {
+  for (unsigned mask = 0; mask < 256; mask++) {
+    mcp_varint_pattern_t* pattern = &mcp_varint_patterns[mask];
+    memset(pattern->shuffle, 0x80, sizeof(pattern->shuffle));
+    unsigned position = 0;
+    while (position < 8) {
+      if (mask & (1 << position)) {
+        if (position == 7 || mask & (1 << (position + 1))) {
+          break;
+        }
+        pattern->shuffle[pattern->count * 2] = position;
+        pattern->shuffle[pattern->count * 2 + 1] = position + 1;
+        position += 2;
+      } else {
+        pattern->shuffle[pattern->count * 2] = position;
+        position += 1;
+      }
+      pattern->count++;
+    }
+    pattern->length = position;
+  }
+}
+
+/**
+ * vector kernel template
+ *
+ * a run of at least 8 one byte varints or 8 two byte varints
+ * is converted at once, otherwise varints from the first 8 bytes
+ * are moved into 16-bit lanes with a shuffle from the pattern table,
+ * values past the decoded ones are stored too and overwritten
+ * by the next iteration
+ */
+#define __mcp_varint_decoder(name, type, isa, widen8, widen16)                        \
+__attribute__((target(isa)))                                                          \
+static const uint8_t* name(type* this, size_t count, const uint8_t* src, size_t size) { \
+  const uint8_t* end = src + size;                                                    \
+  size_t i = 0;                                                                       \
+  while (count - i >= 16 && end - src >= 16) {                                        \
+    __m128i bytes = _mm_loadu_si128((const __m128i*) src);                            \
+    unsigned mask = _mm_movemask_epi8(bytes);                                         \
+    if (!(mask & 0xFF)) {                                                             \
+      size_t run = mask == 0 ? 16 : __builtin_ctz(mask);                              \
+      widen8(&this[i], bytes);                                                        \
+      i += run;                                                                       \
+      src += run;                                                                     \
+    } else if (mask == 0x5555) {                                                      \
+      widen16(&this[i], bytes);                                                       \
+      i += 8;                                                                         \
+      src += 16;                                                                      \
+    } else {                                                                          \
+      mcp_varint_pattern_t* pattern = &mcp_varint_patterns[mask & 0xFF];              \
+      if (pattern->count != 0) {                                                      \
+        __m128i shuffle = _mm_loadu_si128((const __m128i*) pattern->shuffle);         \
+        widen16(&this[i], _mm_shuffle_epi8(bytes, shuffle));                          \
+        i += pattern->count;                                                          \
+        src += pattern->length;                                                       \
+      } else {                                                                        \
+        this[i++] = (int32_t) mcp_varint_next(&src, end);                             \
+        if (src == NULL) {                                                            \
+          return NULL;                                                                \
+        }                                                                             \
+      }                                                                               \
+    }                                                                                 \
+  }                                                                                   \
+  for (; i < count && src != NULL; i++) {                                             \
+    this[i] = (int32_t) mcp_varint_next(&src, end);                                   \
+  }                                                                                   \
+  return src;                                                                         \
+}
+
+__mcp_varint_decoder(mcp_decode_varint_array_sse41, int32_t, "sse4.1", mcp_varint_widen8_sse41, mcp_varint_widen16_sse41)
+__mcp_varint_decoder(mcp_decode_varint_array64_sse41, int64_t, "sse4.1", mcp_varint_widen8_64_sse41, mcp_varint_widen16_64_sse41)
+__mcp_varint_decoder(mcp_decode_varint_array_avx2, int32_t, "avx2", mcp_varint_widen8_avx2, mcp_varint_widen16_avx2)
+__mcp_varint_decoder(mcp_decode_varint_array64_avx2, int64_t, "avx2", mcp_varint_widen8_64_avx2, mcp_varint_widen16_64_avx2)
+
+#undef __mcp_varint_decoder
+
+/**
+ * encode 16 values below 0x80 with a single store
+ */
+__attribute__((target("sse4.1")))
+static size_t mcp_encode_varint_array_sse41(int32_t* this, size_t count, uint8_t* dest) {
+  uint8_t* start = dest;
+  size_t i = 0;
+  __m128i high = _mm_set1_epi32(~0x7F);
+  for (; count - i >= 16; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*) &this[i]);
+    __m128i b = _mm_loadu_si128((const __m128i*) &this[i + 4]);
+    __m128i c = _mm_loadu_si128((const __m128i*) &this[i + 8]);
+    __m128i d = _mm_loadu_si128((const __m128i*) &this[i + 12]);
+    if (_mm_testz_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high)) {
+      __m128i words = _mm_packus_epi32(a, b);
+      _mm_storeu_si128((__m128i*) dest, _mm_packus_epi16(words, _mm_packus_epi32(c, d)));
+      dest += 16;
+    } else {
+      for (size_t j = i; j < i + 16; j++) {
+        mcp_varint_put(this[j], &dest);
+      }
+    }
+  }
+  for (; i < count; i++) {
+    mcp_varint_put(this[i], &dest);
+  }
+  return dest - start;
+}
+#endif /* MCP_VARINT_X86 */
+
+/**
+ * array of variable sized integers
+ */
+void mcp_encode_varint_array(int32_t* this, size_t count, mcp_buffer_t* dest) {
+  mcp_buffer_reserve(dest, count * 5);
+  uint8_t* bytes = (uint8_t*) mcp_buffer_current(dest);
+  #ifdef MCP_VARINT_X86
+    if (__builtin_cpu_supports("sse4.1")) {
+      mcp_buffer_increment(dest, mcp_encode_varint_array_sse41(this, count, bytes));
+      return;
+    }
+  #endif /* MCP_VARINT_X86 */
+  for (size_t i = 0; i < count; i++) {
+    mcp_varint_put(this[i], &bytes);
+  }
+  mcp_buffer_increment(dest, bytes - (uint8_t*) mcp_buffer_current(dest));
+}
+void mcp_encode_varint_array64(int64_t* this, size_t count, mcp_buffer_t* dest) {
+  mcp_buffer_reserve(dest, count * 5);
+  uint8_t* bytes = (uint8_t*) mcp_buffer_current(dest);
+  for (size_t i = 0; i < count; i++) {
+    mcp_varint_put((uint32_t) this[i], &bytes);
+  }
+  mcp_buffer_increment(dest, bytes - (uint8_t*) mcp_buffer_current(dest));
+}
+void mcp_decode_varint_array(int32_t* this, size_t count, mcp_buffer_t* src) {
+  const uint8_t* bytes = (const uint8_t*) mcp_buffer_current(src);
+  const uint8_t* end;
+  #ifdef MCP_VARINT_X86
+    if (__builtin_cpu_supports("avx2")) {
+      end = mcp_decode_varint_array_avx2(this, count, bytes, src->size - src->index);
+    } else if (__builtin_cpu_supports("sse4.1")) {
+      end = mcp_decode_varint_array_sse41(this, count, bytes, src->size - src->index);
+    } else
+  #endif /* MCP_VARINT_X86 */
+  end = mcp_decode_varint_array_scalar(this, count, bytes, src->size - src->index);
+  if (end == NULL) {
+    mcp_buffer_fail(src);
+    return;
+  }
+  mcp_buffer_increment(src, end - bytes);
+}
+void mcp_decode_varint_array64(int64_t* this, size_t count, mcp_buffer_t* src) {
+  const uint8_t* bytes = (const uint8_t*) mcp_buffer_current(src);
+  const uint8_t* end;
+  #ifdef MCP_VARINT_X86
+    if (__builtin_cpu_supports("avx2")) {
+      end = mcp_decode_varint_array64_avx2(this, count, bytes, src->size - src->index);
+    } else if (__builtin_cpu_supports("sse4.1")) {
+      end = mcp_decode_varint_array64_sse41(this, count, bytes, src->size - src->index);
+    } else
+  #endif /* MCP_VARINT_X86 */
+  end = mcp_decode_varint_array64_scalar(this, count, bytes, src->size - src->index);
+  if (end == NULL) {
+    mcp_buffer_fail(src);
+    return;
+  }
+  mcp_buffer_increment(src, end - bytes);
+}
@@ -0,0 +1,89 @@
+/**
+ * @file version.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief protocol versions and packet translation implementations
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/version.h"   /* this */
+#include "mcp/codec.h"     /* varint encoders */
+#include <string.h>        /* memcpy */
+
+    /* functions */
+/**
+ * @brief find a generated version
+ *
+ * @param version protocol version number
+ */
+const mcp_protocol_t* mcp_version_find(int version) {
+    for (const mcp_protocol_t* const* protocol = mcp_protocols; *protocol != NULL; protocol++) {
+        if ((*protocol)->version == version) {
+            return *protocol;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief set the protocol version spoken on the stream of a connection
+ *
+ * @param context connection context
+ * @param version protocol version number
+ */
+bool mcp_version_select(mcp_context_t* context, int version) {
+    const mcp_protocol_t* protocol = mcp_version_find(version);
+    if (protocol == NULL) {
+        return false;
+    }
+    context->protocol = protocol;
+    return true;
+}
+
+/**
+ * @brief select the version of a connection from its handshake packet
+ *
+ * @param context connection context with a received handshake packet in its buffer
+ */
+void mcp_version_handshake(mcp_context_t* context) {
+    uint64_t version;
+    if (mcp_peek_varint(mcp_buffer_current(&context->buffer), mcp_buffer_remaining(&context->buffer), &version) != 0) {
+        mcp_version_select(context, (int) version);
+    }
+}
+
+/**
+ * @brief translate a packet
+ *
+ * @param translation translation of the packet, not dropped
+ * @param packet      buffer with the packet from its id, positioned after the id
+ * @param region      memory for the translated packet
+ */
+bool mcp_version_translate(const mcp_translation_t* translation, mcp_buffer_t* packet, mcp_region_t* region) {
+    size_t id_size = mcp_length_varint(translation->id);
+    if (translation->mode == MCP_TRANSLATION_RAW) {
+        char id[5];
+        mcp_put_varint(id, translation->id);
+        if (id_size == packet->index && memcmp(packet->data, id, id_size) == 0) {
+            return true;
+        }
+        size_t size = packet->size - packet->index;
+        char* data = mcp_region_reserve(region, MCP_BUFFER_HEADROOM + id_size + size) + MCP_BUFFER_HEADROOM;
+        memcpy(data, id, id_size);
+        memcpy(data + id_size, mcp_buffer_current(packet), size);
+        packet->data = data;
+        packet->size = id_size + size;
+        packet->index = id_size;
+        return true;
+    }
+
+    mcp_buffer_t dest = { 0 };
+    dest.region = region;
+    if (!translation->translate(packet, &dest)) {
+        return false;
+    }
+    packet->data = mcp_buffer_packet(&dest);
+    packet->size = mcp_buffer_packet_length(&dest);
+    packet->index = id_size;
+    return true;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file view.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief lazy access to packet fields
+ * @version 0.1
+ * @date 2021-03-15
+ */
+    /* includes */
+#include "mcp/view.h" /* this */
+
+    /* functions */
+/**
+ * @brief scan a field at its recorded offset and record the next one
+ *
+ * @param view   pointer to the view
+ * @param field  field index
+ * @param decode decode the field instead of skipping it
+ */
+static inline void mcp_view_scan(mcp_view_t* view, size_t field, bool decode) {
+    view->src.index = view->offsets[field];
+    view->scan(view, field, decode);
+    if (view->scanned == field) {
+        view->offsets[field + 1] = view->src.index;
+        view->scanned++;
+    }
+}
+
+/**
+ * @brief decode a packet field if it is not decoded yet
+ *
+ * @param view  pointer to the view
+ * @param field field index
+ */
+void mcp_view_field(mcp_view_t* view, size_t field) {
+    while (view->scanned < field) {
+        size_t previous = view->scanned;
+        mcp_view_scan(view, previous, (view->eager >> previous & 1) && !(view->decoded >> previous & 1));
+    }
+    if (!(view->decoded >> field & 1)) {
+        mcp_view_scan(view, field, true);
+    }
+}
@@ -0,0 +1,508 @@
+/**
+ * @file world.c
+ * @author andersonarc (e.andersonarc@gmail.com)
+ * @brief world state cache kept current from chunk and block packets
+ * @version 0.1
+ * @date 2021-03-15
+ *
+ * sections keep the smallest of 4 bit, 8 bit and 16 bit storage
+ * that fits their states, which is the layout they are sent with,
+ * so a column of mostly uniform sections takes a few hundred bytes
+ * instead of the 128 kilobytes of a decoded one
+ *
+ * columns are found in an open addressing table with linear probing,
+ * removed columns shift their followers back instead of leaving tombstones
+ */
+    /* includes */
+#include "mcp/world.h"     /* this */
+#include "mcp/chunk.h"     /* chunk sections */
+#include "csafe/assertd.h" /* debug assertions */
+#include <stdlib.h>        /* malloc */
+#include <string.h>        /* memset */
+
+    /* defines */
+/**
+ * @brief initial capacity of the column table
+ */
+#define MCP_WORLD_CAPACITY 64
+
+    /* functions */
+/**
+ * @brief replace the storage of a section
+ *
+ * @param section the section
+ * @param bits    bits per state, 4, 8 or 16
+ * @param values  palette indices or states
+ * @param palette palette of size entries, NULL for states
+ * @param size    number of palette entries
+ */
+static void mcp_world_section_pack(mcp_world_section_t* section, uint8_t bits, const uint16_t* values, const int32_t* palette, size_t size) {
+  size_t longs = mcp_chunk_longs(MCP_CHUNK_SECTION_BLOCKS, bits, false);
+  size_t capacity = palette != NULL ? 1u << bits : 0;
+  free(section->data);
+  section->data = malloc(longs * sizeof(uint64_t) + capacity * sizeof(int32_t));
+  assertd_not_null("mcp_world_section_pack", section->data);
+  mcp_chunk_pack((char*) section->data, values, MCP_CHUNK_SECTION_BLOCKS, bits, false);
+  if (palette != NULL) {
+    section->palette = (int32_t*) (section->data + longs);
+    memcpy(section->palette, palette, size * sizeof(int32_t));
+    memset(section->palette + size, 0, (capacity - size) * sizeof(int32_t));
+  } else {
+    section->palette = NULL;
+  }
+  section->size = size;
+  section->value = 0;
+  section->bits = bits;
+}
+
+/**
+ * @brief replace the states of a section
+ *
+ * @param section the section
+ * @param blocks  MCP_CHUNK_SECTION_BLOCKS states
+ */
+void mcp_world_section_store(mcp_world_section_t* section, const uint16_t* blocks) {
+  uint16_t indices[MCP_CHUNK_SECTION_BLOCKS];
+  int32_t palette[1 << MCP_CHUNK_PALETTE_BITS];
+  size_t size;
+  if (!mcp_chunk_palette(blocks, indices, palette, &size)) {
+    mcp_world_section_pack(section, MCP_CHUNK_MAX_BITS, blocks, NULL, 0);
+  } else if (size == 1) {
+    mcp_world_section_free(section);
+    section->value = palette[0];
+  } else {
+    mcp_world_section_pack(section, size <= 16 ? 4 : 8, indices, palette, size);
+  }
+}
+
+/**
+ * @brief expand the states of a section
+ *
+ * @param section the section
+ * @param blocks  destination of MCP_CHUNK_SECTION_BLOCKS states
+ */
+void mcp_world_section_load(mcp_world_section_t* section, uint16_t* blocks) {
+  if (section->bits == 0) {
+    for (size_t i = 0; i < MCP_CHUNK_SECTION_BLOCKS; i++) {
+      blocks[i] = section->value;
+    }
+  } else {
+    mcp_chunk_unpack(blocks, MCP_CHUNK_SECTION_BLOCKS, (char*) section->data, section->bits, false, section->palette);
+  }
+}
+
+/**
+ * @brief free a section, leaving it filled with air
+ *
+ * @param section the section
+ */
+void mcp_world_section_free(mcp_world_section_t* section) {
+  free(section->data);
+  memset(section, 0, sizeof(mcp_world_section_t));
+}
+
+/**
+ * @brief set a state of a section
+ *
+ * a state missing from a full palette
+ * repacks the section with the next storage
+ *
+ * @param section the section
+ * @param index   block index
+ * @param state   block state
+ */
+void mcp_world_section_set(mcp_world_section_t* section, size_t index, uint16_t state) {
+  if (section->bits == 0 && section->value == state) {
+    return;
+  }
+  uint32_t value = state;
+  if (section->palette != NULL) {
+    value = 0;
+    while (value < section->size && section->palette[value] != state) {
+      value++;
+    }
+    if (value == section->size && section->size < 1u << section->bits) {
+      section->palette[section->size++] = state;
+    }
+  }
+  if (section->bits == 0 || value == 1u << section->bits) {
+    uint16_t blocks[MCP_CHUNK_SECTION_BLOCKS];
+    mcp_world_section_load(section, blocks);
+    blocks[index] = state;
+    mcp_world_section_store(section, blocks);
+    return;
+  }
+  size_t bit = index * section->bits;
+  uint64_t mask = ((1ull << section->bits) - 1) << (bit & 63);
+  uint64_t word = be64toh(section->data[bit >> 6]);
+  word = (word & ~mask) | ((uint64_t) value << (bit & 63));
+  section->data[bit >> 6] = htobe64(word);
+}
+
+/**
+ * @brief get the key of a column position
+ *
+ * @param x column x coordinate
+ * @param z column z coordinate
+ */
+static inline uint64_t mcp_world_key(int32_t x, int32_t z) {
+  return (uint64_t) (uint32_t) x << 32 | (uint32_t) z;
+}
+
+/**
+ * @brief get the home slot of a key
+ *
+ * @param world pointer to the world
+ * @param key   column key
+ */
+static inline size_t mcp_world_slot(mcp_world_t* world, uint64_t key) {
+  return (key * 0x9E3779B97F4A7C15ull) >> world->shift;
+}
+
+/**
+ * @brief initialize a world
+ *
+ * @param world pointer to the world
+ */
+void mcp_world_init(mcp_world_t* world) {
+  world->capacity = MCP_WORLD_CAPACITY;
+  world->count = 0;
+  world->shift = 64 - __builtin_ctzll(MCP_WORLD_CAPACITY);
+  world->entries = calloc(world->capacity, sizeof(mcp_world_entry_t));
+  assertd_not_null("mcp_world_init", world->entries);
+  world->scratch = NULL;
+}
+
+/**
+ * @brief free a column
+ *
+ * @param column the column
+ */
+static void mcp_world_column_free(mcp_world_column_t* column) {
+  for (size_t i = 0; i < MCP_CHUNK_SECTIONS; i++) {
+    free(column->sections[i].data);
+  }
+  free(column->biomes);
+  free(column);
+}
+
+/**
+ * @brief free a world and its columns
+ *
+ * @param world pointer to the world
+ */
+void mcp_world_free(mcp_world_t* world) {
+  for (size_t i = 0; i < world->capacity; i++) {
+    if (world->entries[i].column != NULL) {
+      mcp_world_column_free(world->entries[i].column);
+    }
+  }
+  free(world->entries);
+  free(world->scratch);
+  world->entries = NULL;
+  world->scratch = NULL;
+  world->capacity = 0;
+  world->count = 0;
+}
+
+/**
+ * @brief find the slot of a key
+ *
+ * @param world pointer to the world
+ * @param key   column key
+ *
+ * @return slot with the key or the empty slot where it belongs
+ */
+static size_t mcp_world_probe(mcp_world_t* world, uint64_t key) {
+  size_t mask = world->capacity - 1;
+  size_t slot = mcp_world_slot(world, key);
+  while (world->entries[slot].column != NULL && world->entries[slot].key != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/**
+ * @brief find a column
+ *
+ * @param world pointer to the world
+ * @param x     column x coordinate
+ * @param z     column z coordinate
+ */
+mcp_world_column_t* mcp_world_find(mcp_world_t* world, int32_t x, int32_t z) {
+  return world->entries[mcp_world_probe(world, mcp_world_key(x, z))].column;
+}
+
+/**
+ * @brief double the capacity of the column table
+ *
+ * @param world pointer to the world
+ */
+static void mcp_world_grow(mcp_world_t* world) {
+  mcp_world_entry_t* entries = world->entries;
+  size_t capacity = world->capacity;
+  world->capacity *= 2;
+  world->shift--;
+  world->entries = calloc(world->capacity, sizeof(mcp_world_entry_t));
+  assertd_not_null("mcp_world_grow", world->entries);
+  for (size_t i = 0; i < capacity; i++) {
+    if (entries[i].column != NULL) {
+      world->entries[mcp_world_probe(world, entries[i].key)] = entries[i];
+    }
+  }
+  free(entries);
+}
+
+/**
+ * @brief find a column, loading an empty one if there is none
+ *
+ * @param world pointer to the world
+ * @param x     column x coordinate
+ * @param z     column z coordinate
+ */
+mcp_world_column_t* mcp_world_load(mcp_world_t* world, int32_t x, int32_t z) {
+  uint64_t key = mcp_world_key(x, z);
+  size_t slot = mcp_world_probe(world, key);
+  if (world->entries[slot].column != NULL) {
+    return world->entries[slot].column;
+  }
+  if ((world->count + 1) * 2 > world->capacity) {
+    mcp_world_grow(world);
+    slot = mcp_world_probe(world, key);
+  }
+  mcp_world_column_t* column = calloc(1, sizeof(mcp_world_column_t));
+  assertd_not_null("mcp_world_load", column);
+  column->x = x;
+  column->z = z;
+  world->entries[slot].key = key;
+  world->entries[slot].column = column;
+  world->count++;
+  return column;
+}
+
+/**
+ * @brief unload a column
+ *
+ * @param world pointer to the world
+ * @param x     column x coordinate
+ * @param z     column z coordinate
+ */
+void mcp_world_unload(mcp_world_t* world, int32_t x, int32_t z) {
+  size_t mask = world->capacity - 1;
+  size_t slot = mcp_world_probe(world, mcp_world_key(x, z));
+  if (world->entries[slot].column == NULL) {
+    return;
+  }
+  mcp_world_column_free(world->entries[slot].column);
+  world->count--;
+  /* shift back followers whose home slot is not between the hole and them */
+  size_t next = slot;
+  for (;;) {
+    next = (next + 1) & mask;
+    if (world->entries[next].column == NULL) {
+      break;
+    }
+    size_t home = mcp_world_slot(world, world->entries[next].key);
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      world->entries[slot] = world->entries[next];
+      slot = next;
+    }
+  }
+  world->entries[slot].column = NULL;
+}
+
+/**
+ * @brief get the section of a block
+ *
+ * @param world    pointer to the world
+ * @param position block position
+ *
+ * @return the section, NULL if the column is not loaded or y is out of the world
+ */
+static mcp_world_section_t* mcp_world_section(mcp_world_t* world, mcp_type_Position* position) {
+  if (position->y < 0 || position->y >= MCP_CHUNK_SECTIONS * 16) {
+    return NULL;
+  }
+  mcp_world_column_t* column = mcp_world_find(world, position->x >> 4, position->z >> 4);
+  if (column == NULL) {
+    return NULL;
+  }
+  return &column->sections[position->y >> 4];
+}
+
+/**
+ * @brief get a block state
+ *
+ * @param world    pointer to the world
+ * @param position block position
+ */
+uint16_t mcp_world_get_block(mcp_world_t* world, mcp_type_Position* position) {
+  mcp_world_section_t* section = mcp_world_section(world, position);
+  if (section == NULL) {
+    return 0;
+  }
+  return mcp_world_section_get(section, mcp_world_index(position));
+}
+
+/**
+ * @brief set a block state
+ *
+ * @param world    pointer to the world
+ * @param position block position
+ * @param state    block state
+ */
+bool mcp_world_set_block(mcp_world_t* world, mcp_type_Position* position, uint16_t state) {
+  mcp_world_section_t* section = mcp_world_section(world, position);
+  if (section == NULL) {
+    return false;
+  }
+  mcp_world_section_set(section, mcp_world_index(position), state);
+  return true;
+}
+
+/**
+ * @brief get the scratch column of a world
+ *
+ * @param world pointer to the world
+ */
+static mcp_chunk_column_t* mcp_world_scratch(mcp_world_t* world) {
+  if (world->scratch == NULL) {
+    world->scratch = malloc(sizeof(mcp_chunk_column_t));
+    assertd_not_null("mcp_world_scratch", world->scratch);
+  }
+  return world->scratch;
+}
+
+/**
+ * @brief apply chunk data to a column
+ *
+ * @param world     pointer to the world
+ * @param x         column x coordinate
+ * @param z         column z coordinate
+ * @param data      chunk data
+ * @param size      data size
+ * @param mask      primary bit mask of sent sections
+ * @param full      column is full, unsent sections are cleared
+ * @param sky_light sections have sky light
+ * @param format    chunk data format
+ */
+bool mcp_world_apply_chunk(mcp_world_t* world, int32_t x, int32_t z, char* data, size_t size, uint16_t mask, bool full, bool sky_light, mcp_chunk_format_t* format) {
+  mcp_chunk_column_t* scratch = mcp_world_scratch(world);
+  if (!mcp_chunk_decode_column(scratch, data, size, mask, full, sky_light, format)) {
+    return false;
+  }
+  mcp_world_column_t* column = mcp_world_load(world, x, z);
+  for (size_t i = 0; i < MCP_CHUNK_SECTIONS; i++) {
+    if (mask & (1 << i)) {
+      mcp_world_section_store(&column->sections[i], scratch->sections[i].blocks);
+    } else if (full) {
+      mcp_world_section_free(&column->sections[i]);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief expand a column into a dense one
+ *
+ * @param column source column
+ * @param dest   destination column, sections with blocks are set in its mask
+ */
+void mcp_world_export(mcp_world_column_t* column, mcp_chunk_column_t* dest) {
+  dest->mask = 0;
+  dest->biomes = NULL;
+  for (size_t i = 0; i < MCP_CHUNK_SECTIONS; i++) {
+    mcp_world_section_t* section = &column->sections[i];
+    if (section->bits == 0 && section->value == 0) {
+      continue;
+    }
+    mcp_world_section_load(section, dest->sections[i].blocks);
+    dest->sections[i].block_count = -1;
+    dest->sections[i].bits = 0;
+    dest->sections[i].block_light = NULL;
+    dest->sections[i].sky_light = NULL;
+    dest->mask |= 1 << i;
+  }
+}
+
+/**
+ * @brief apply a block change packet
+ *
+ * @param world  pointer to the world
+ * @param packet the packet
+ */
+bool mcp_world_apply_block_change(mcp_world_t* world, mcp_packet_server_BlockChange* packet) {
+  return mcp_world_set_block(world, &packet->location, packet->type);
+}
+
+#if MCP_PROTOCOL_VERSION >= 751
+/**
+ * @brief apply a multi block change packet
+ *
+ * @param world  pointer to the world
+ * @param packet the packet
+ */
+bool mcp_world_apply_multi_block_change(mcp_world_t* world, mcp_packet_server_MultiBlockChange* packet) {
+  mcp_type_chunkCoordinates* coordinates = &packet->chunkCoordinates;
+  if (coordinates->y < 0 || coordinates->y >= MCP_CHUNK_SECTIONS) {
+    return false;
+  }
+  mcp_world_column_t* column = mcp_world_find(world, coordinates->x, coordinates->z);
+  if (column == NULL) {
+    return false;
+  }
+  mcp_world_section_t* section = &column->sections[coordinates->y];
+  for (size_t i = 0; i < packet->records.size; i++) {
+    /* state << 12 | x << 8 | z << 4 | y */
+    uint64_t record = packet->records.data[i];
+    size_t index = (record & 0xF) << 8 | ((record >> 4) & 0xF) << 4 | ((record >> 8) & 0xF);
+    mcp_world_section_set(section, index, record >> 12);
+  }
+  return true;
+}
+
+/**
+ * @brief apply a map chunk packet
+ *
+ * @param world  pointer to the world
+ * @param packet the packet
+ */
+bool mcp_world_apply_map_chunk(mcp_world_t* world, mcp_packet_server_MapChunk* packet) {
+  mcp_chunk_format_t format = mcp_chunk_format(MCP_PROTOCOL_VERSION);
+  if (!mcp_world_apply_chunk(world, packet->x, packet->z, packet->chunkData.data, packet->chunkData.size, packet->bitMap, packet->groundUp, true, &format)) {
+    return false;
+  }
+  if (packet->groundUp && packet->biomes.size > 0) {
+    mcp_world_column_t* column = mcp_world_find(world, packet->x, packet->z);
+    if (column->biomes == NULL) {
+      column->biomes = calloc(MCP_WORLD_BIOMES, sizeof(int32_t));
+      assertd_not_null("mcp_world_apply_map_chunk", column->biomes);
+    }
+    size_t count = packet->biomes.size < MCP_WORLD_BIOMES ? packet->biomes.size : MCP_WORLD_BIOMES;
+    for (size_t i = 0; i < count; i++) {
+      column->biomes[i] = packet->biomes.data[i];
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief create a map chunk packet from a cached column
+ *
+ * @param world  pointer to the world
+ * @param x      column x coordinate
+ * @param z      column z coordinate
+ * @param packet destination packet
+ * @param data   buffer holding the chunk data, could be reused between packets
+ */
+bool mcp_world_create_packet(mcp_world_t* world, int32_t x, int32_t z, mcp_packet_server_MapChunk* packet, mcp_buffer_t* data) {
+  mcp_world_column_t* column = mcp_world_find(world, x, z);
+  if (column == NULL) {
+    return false;
+  }
+  mcp_chunk_column_t* scratch = mcp_world_scratch(world);
+  mcp_world_export(column, scratch);
+  mcp_chunk_create_packet(packet, scratch, x, z, column->biomes, data);
+  return true;
+}
+#endif /* MCP_PROTOCOL_VERSION */